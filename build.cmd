@@ -34,6 +34,7 @@ echo Executables created:
 echo   - temperature_server.exe (main server)
 echo   - web_server.exe (web interface)
 echo   - device_simulator.exe (device simulator)
+echo   - tempctl.exe (history import/export tool)
 echo.
 echo Usage:
 echo   1. Run temperature_server.exe
@@ -27,6 +27,7 @@ echo "Executables created:"
 echo "  - temperature_server (main server)"
 echo "  - web_server (web interface)"
 echo "  - device_simulator (device simulator)"
+echo "  - tempctl (history import/export tool)"
 echo ""
 echo "Usage:"
 echo "  1. Run ./temperature_server"
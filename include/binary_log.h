@@ -0,0 +1,25 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <ctime>
+
+struct TemperatureRecord;
+
+// Бинарный журнал: записи фиксированной длины, little-endian:
+// [int64 время, секунды эпохи][float значение][uint32 контрольная сумма].
+// Время хранится как есть, поэтому переходы на летнее время его не искажают.
+const size_t BINARY_LOG_RECORD_SIZE = 16;
+
+void write_binary_record(std::ostream& out, std::time_t timestamp, float value);
+
+// Отображает файл в память и добавляет все записи в out. Записи с неверной
+// контрольной суммой (например, недописанный хвост) пропускаются. Память в out
+// не резервируется: при чтении нескольких файлов это делает вызывающий один раз.
+bool load_binary_log(const std::string& path, std::vector<TemperatureRecord>& out,
+                     size_t* corrupted = nullptr);
+
+#endif // BINARY_LOG_H
@@ -0,0 +1,77 @@
+#ifndef CALCULATOR_POLICIES_H
+#define CALCULATOR_POLICIES_H
+
+#include "database_manager.h"
+#include <ctime>
+#include <vector>
+
+// Корзины фиксированной ширины. Ширина известна при компиляции, поэтому
+// деление на неё компилятор заменяет умножением и сдвигами.
+template <std::time_t Seconds>
+struct FixedBuckets {
+    static_assert(Seconds > 0, "bucket width must be positive");
+
+    static constexpr std::time_t width = Seconds;
+
+    // Начало корзины, округление вниз и для отрицательных меток
+    static constexpr std::time_t start_of(std::time_t timestamp) {
+        std::time_t rem = timestamp % Seconds;
+        return rem < 0 ? timestamp - rem - Seconds : timestamp - rem;
+    }
+};
+
+// Та же арифметика с шириной, заданной при выполнении (настраиваемые ряды,
+// сравнение в замерах)
+struct RuntimeBuckets {
+    std::time_t width;
+
+    std::time_t start_of(std::time_t timestamp) const {
+        std::time_t rem = timestamp % width;
+        return rem < 0 ? timestamp - rem - width : timestamp - rem;
+    }
+};
+
+// Сколько истории калькулятор держит в памяти
+template <std::time_t Seconds>
+struct RetentionWindow {
+    static_assert(Seconds > 0, "retention window must be positive");
+
+    static constexpr std::time_t length = Seconds;
+};
+
+// Набор сводок по корзинам: среднее, min/max всегда; процентили - по скетчам
+template <bool Percentiles>
+struct AggregateSet {
+    static constexpr bool percentiles = Percentiles;
+};
+
+using MeanAggregates = AggregateSet<false>;
+using FullAggregates = AggregateSet<true>;
+
+// Раскладывает упорядоченные по времени записи по корзинам (без скетчей).
+// Подряд идущие записи одной корзины дописываются в out.back().
+template <typename Buckets>
+void accumulate_buckets(const Buckets& buckets, const std::time_t* timestamps, const float* values,
+                        size_t count, std::vector<TemperatureBucket>& out) {
+    for (size_t i = 0; i < count; ++i) {
+        std::time_t start = buckets.start_of(timestamps[i]);
+        if (out.empty() || out.back().bucket_start != start) {
+            out.push_back({start, TemperatureAggregate()});
+        }
+
+        TemperatureAggregate& aggregate = out.back().aggregate;
+        float value = values[i];
+        if (aggregate.count == 0) {
+            aggregate.first_timestamp = timestamps[i];
+            aggregate.min_temp = aggregate.max_temp = value;
+        } else {
+            aggregate.min_temp = value < aggregate.min_temp ? value : aggregate.min_temp;
+            aggregate.max_temp = value > aggregate.max_temp ? value : aggregate.max_temp;
+        }
+        aggregate.last_timestamp = timestamps[i];
+        aggregate.sum += value;
+        ++aggregate.count;
+    }
+}
+
+#endif // CALCULATOR_POLICIES_H
@@ -1,10 +1,12 @@
 #ifndef DATABASE_MANAGER_H
 #define DATABASE_MANAGER_H
 
+#include "quantile_sketch.h"
 #include <string>
 #include <vector>
 #include <ctime>
 #include <memory>
+#include <functional>
 
 struct TemperatureData {
     std::time_t timestamp;
@@ -15,12 +17,56 @@ struct HourlyAverage {
     std::time_t hour_start;
     float average_temp;
     int count;
+    TemperaturePercentiles percentiles;
 };
 
 struct DailyAverage {
     std::time_t day_start;
     float average_temp;
     int count;
+    TemperaturePercentiles percentiles;
+};
+
+// Сводка по набору измерений; хранится для каждого блока (zone map)
+struct TemperatureAggregate {
+    std::time_t first_timestamp{0};
+    std::time_t last_timestamp{0};
+    long long count{0};
+    double sum{0.0};
+    float min_temp{0.0f};
+    float max_temp{0.0f};
+    // Распределение значений; сливается вместе с остальными полями
+    QuantileSketch sketch;
+    
+    void add(std::time_t timestamp, float temperature);
+    void merge(const TemperatureAggregate& other);
+    float average() const { return count > 0 ? static_cast<float>(sum / count) : 0.0f; }
+    // Процентили скетча, ограниченные точными min/max
+    TemperaturePercentiles percentiles() const;
+};
+
+// Уровень хранения: сырые данные (resolution_seconds == 0) или прореженные до интервала
+struct StorageTier {
+    std::time_t resolution_seconds;
+    std::time_t retention_seconds;
+};
+
+struct TemperatureBucket {
+    std::time_t bucket_start;
+    TemperatureAggregate aggregate;
+};
+
+// Параметры онлайн-копии: шаг копирования подбирается так, чтобы
+// удерживать базу не дольше latency_budget_ms, между шагами - пауза
+struct BackupOptions {
+    int latency_budget_ms = 5;
+    int pause_ms = 20;
+};
+
+struct BackupStats {
+    int pages = 0;
+    int steps = 0;
+    double seconds = 0.0;
 };
 
 class DatabaseManager {
@@ -30,14 +76,52 @@ public:
     bool initialize(const std::string& db_path = "temperature_data.db");
     void cleanup();
     
+    // Строки старше уже прореженного интервала отодвигают отметки уровней назад:
+    // maintain_storage пересчитает этот интервал
     bool add_measurement(std::time_t timestamp, float temperature);
-    bool add_hourly_average(std::time_t hour_start, float average_temp, int count);
-    bool add_daily_average(std::time_t day_start, float average_temp, int count);
+    // Пачка текущих измерений одной транзакцией. При ошибке сохраняется начало
+    // пачки; его длина - в stored. Если не удалась сама фиксация, не сохраняется
+    // ничего, и кэш с последним измерением остаются прежними.
+    bool add_measurements(const std::vector<TemperatureData>& batch, size_t* stored = nullptr);
+    // Скетч сохраняется вместе со средним: по нему отдаются процентили
+    bool add_hourly_average(std::time_t hour_start, float average_temp, int count,
+                            const QuantileSketch& sketch = QuantileSketch());
+    bool add_daily_average(std::time_t day_start, float average_temp, int count,
+                           const QuantileSketch& sketch = QuantileSketch());
+    
+    // Пакетная загрузка истории одной транзакцией
+    bool import_measurements(const std::vector<TemperatureData>& batch);
+    
+    // Выгрузка: блоки читаются и форматируются в threads потоках,
+    // sink получает готовые куски строго в порядке времени. Если блок удалён
+    // во время выгрузки, она прерывается с false, а не пропускает его молча.
+    using ChunkFormatter = std::function<std::string(const std::vector<TemperatureData>&)>;
+    using ChunkSink = std::function<bool(const std::string&)>;
+    bool export_measurements(std::time_t from, std::time_t to, int threads,
+                             const ChunkFormatter& format, const ChunkSink& sink);
     
     std::vector<TemperatureData> get_measurements(std::time_t from = 0, std::time_t to = 0, int limit = 1000);
     std::vector<HourlyAverage> get_hourly_averages(std::time_t from = 0, std::time_t to = 0);
     std::vector<DailyAverage> get_daily_averages(std::time_t from = 0, std::time_t to = 0);
     
+    // Агрегат за [from, to]: целые блоки берутся из сводок, декодируются только краевые
+    TemperatureAggregate get_aggregate(std::time_t from = 0, std::time_t to = 0);
+    
+    // Ряд с шагом resolution, построенный по самому грубому подходящему уровню
+    std::vector<TemperatureBucket> get_downsampled(std::time_t from, std::time_t to, std::time_t resolution);
+    
+    // Уровни по возрастанию интервала; первый - сырые данные.
+    // Формат строки: "raw:7d,1m:30d,15m:90d,1h:365d,1d:3650d"
+    bool set_storage_tiers(const std::vector<StorageTier>& tiers);
+    static bool parse_storage_tiers(const std::string& spec, std::vector<StorageTier>& tiers);
+    
+    // Прореживание состарившихся данных и удаление вышедших за срок хранения
+    void maintain_storage(std::time_t now);
+    
+    // Согласованная копия базы без остановки записи (постраничный SQLite backup)
+    bool backup(const std::string& dest_path, const BackupOptions& options = BackupOptions(),
+                BackupStats* stats = nullptr);
+    
     TemperatureData get_last_measurement();
     float get_current_temperature();
     
@@ -0,0 +1,189 @@
+#ifndef DEVICE_FRAME_H
+#define DEVICE_FRAME_H
+
+#include "serial_port.h"
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Двоичный кадр устройства, little-endian:
+// [0xA5][канал][N][uint48 время первого показания, мс от эпохи]
+// N x [uint16 приращение времени от предыдущего показания, мс][int16 сотые градуса]
+// [uint16 CRC-16/CCITT всех байтов после байта синхронизации]
+// Кадр из 16 показаний - 75 байт, около 4.7 байта на показание против ~44 байт
+// текстовой строки: на 9600 бод это ~200 показаний в секунду вместо ~22.
+const unsigned char FRAME_SYNC = 0xA5;
+const size_t FRAME_HEADER_SIZE = 9;
+const size_t FRAME_SAMPLE_SIZE = 4;
+const size_t FRAME_CRC_SIZE = 2;
+const size_t MAX_FRAME_SAMPLES = 64;
+const size_t MAX_FRAME_SIZE = FRAME_HEADER_SIZE + MAX_FRAME_SAMPLES * FRAME_SAMPLE_SIZE + FRAME_CRC_SIZE;
+const int64_t MAX_FRAME_TIME_MS = (int64_t(1) << 48) - 1;
+
+struct DeviceSample {
+    int64_t timestamp_ms = 0; // время устройства, мс от эпохи (UTC)
+    float temperature = 0.0f;
+};
+
+struct DeviceFrame {
+    unsigned channel = 0; // номер датчика на устройстве
+    size_t count = 0;
+    DeviceSample samples[MAX_FRAME_SAMPLES];
+};
+
+// CRC-16/CCITT-FALSE (полином 0x1021, начальное значение 0xFFFF)
+uint16_t crc16_ccitt(const unsigned char* data, size_t size, uint16_t crc = 0xFFFF);
+
+// Дописывает кадр в out. Время не должно убывать, соседние показания - не дальше
+// 65.535 с; температура округляется до сотых и ограничивается диапазоном int16
+// (±327.67). false - показаний нет или больше MAX_FRAME_SAMPLES, время вне
+// диапазона или температура не число.
+bool encode_device_frame(unsigned channel, const DeviceSample* samples, size_t count,
+                         std::vector<unsigned char>& out);
+
+enum class FrameStatus {
+    Ok,         // кадр цел, его длина - в consumed
+    Incomplete, // кадр ещё не пришёл целиком
+    Corrupt     // неверная длина или CRC
+};
+
+// Проверяет длину и CRC кадра в начале data; data[0] - байт синхронизации
+FrameStatus check_device_frame(const unsigned char* data, size_t size, size_t& consumed);
+
+// Проверяет и разбирает кадр в начале data
+FrameStatus decode_device_frame(const unsigned char* data, size_t size, DeviceFrame& frame, size_t& consumed);
+
+// Делит поток устройства на текстовые строки и двоичные кадры. Протокол
+// определяется по первому байту каждого сообщения (текст - ASCII, кадр
+// начинается с FRAME_SYNC), поэтому устройство может перейти с одного на
+// другой в любой момент. Буфер линейный, как в LineSplitter: строки и кадры
+// отдаются на месте, кадр - целиком после проверки CRC, разбирает его
+// decode_device_frame. После кадра с неверной CRC байты пропускаются до
+// ближайшего '\n' или байта синхронизации; байт синхронизации посреди строки
+// обрывает её (ресинхронизация).
+class DeviceStreamSplitter {
+public:
+    explicit DeviceStreamSplitter(size_t max_line = LineSplitter::DEFAULT_MAX_LINE);
+
+    // Место для следующего чтения; всегда не меньше одного байта
+    char* write_area() { return buffer_.get() + size_; }
+    size_t write_space() const { return capacity_ - size_; }
+
+    // Разбирает count байт, записанных в write_area(). on_line(std::string_view)
+    // и on_frame(std::string_view) вызываются в порядке прихода сообщений;
+    // представления живут до возврата из вызова.
+    template <typename OnLine, typename OnFrame>
+    void commit(size_t count, OnLine&& on_line, OnFrame&& on_frame);
+
+    // То же для данных из чужого буфера (копируются в свой)
+    template <typename OnLine, typename OnFrame>
+    void feed(const char* data, size_t size, OnLine&& on_line, OnFrame&& on_frame);
+
+    // Отбрасывает недописанное сообщение (например, после переподключения)
+    void clear() {
+        size_ = 0;
+        scanned_ = 0;
+        discarding_ = false;
+    }
+
+    size_t frames() const { return frames_; }
+    size_t corrupt_frames() const { return corrupt_frames_; }
+    size_t dropped_lines() const { return dropped_lines_; }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    size_t scanned_ = 0;      // столько байт в начале буфера - текст без '\n' и FRAME_SYNC
+    bool discarding_ = false; // пропускаем до '\n' или FRAME_SYNC
+    size_t frames_ = 0;
+    size_t corrupt_frames_ = 0;
+    size_t dropped_lines_ = 0;
+};
+
+template <typename OnLine, typename OnFrame>
+void DeviceStreamSplitter::commit(size_t count, OnLine&& on_line, OnFrame&& on_frame) {
+    char* base = buffer_.get();
+    size_t start = 0;       // начало неразобранного сообщения
+    size_t scan = scanned_; // [start, scan) уже проверены
+    size_ += count;
+
+    while (start < size_) {
+        if (scan == start && static_cast<unsigned char>(base[start]) == FRAME_SYNC) {
+            discarding_ = false;
+            size_t consumed = 0;
+            FrameStatus status = check_device_frame(reinterpret_cast<const unsigned char*>(base + start),
+                                                    size_ - start, consumed);
+            if (status == FrameStatus::Incomplete) break;
+            if (status == FrameStatus::Ok) {
+                ++frames_;
+                on_frame(std::string_view(base + start, consumed));
+                start += consumed;
+            } else {
+                ++corrupt_frames_;
+                discarding_ = true;
+                ++start;
+            }
+            scan = start;
+            continue;
+        }
+
+        // Ищем конец строки, а в ней - начало кадра; только в новых байтах
+        const char* newline = static_cast<const char*>(std::memchr(base + scan, '\n', size_ - scan));
+        size_t limit = newline != nullptr ? static_cast<size_t>(newline - base) : size_;
+        const char* sync = static_cast<const char*>(std::memchr(base + scan, FRAME_SYNC, limit - scan));
+
+        if (sync != nullptr) {
+            // Начало строки потеряно или это хвост испорченного кадра
+            size_t sync_pos = static_cast<size_t>(sync - base);
+            if (!discarding_ && sync_pos > start) ++dropped_lines_;
+            discarding_ = false;
+            start = sync_pos;
+        } else if (newline != nullptr) {
+            if (discarding_) {
+                discarding_ = false;
+            } else if (limit > start) {
+                on_line(std::string_view(base + start, limit - start));
+            }
+            start = limit + 1;
+        } else {
+            scan = size_;
+            break;
+        }
+        scan = start;
+    }
+
+    // Недописанный кадр всегда помещается: ёмкость не меньше MAX_FRAME_SIZE
+    size_t tail = size_ - start;
+    if (!discarding_ && tail == capacity_) {
+        discarding_ = true;
+        ++dropped_lines_;
+    }
+    if (discarding_) {
+        size_ = 0;
+        scanned_ = 0;
+        return;
+    }
+    if (start > 0 && tail > 0) {
+        std::memmove(base, base + start, tail);
+    }
+    size_ = tail;
+    scanned_ = scan - start;
+}
+
+template <typename OnLine, typename OnFrame>
+void DeviceStreamSplitter::feed(const char* data, size_t size, OnLine&& on_line, OnFrame&& on_frame) {
+    while (size > 0) {
+        size_t chunk = std::min(size, write_space());
+        std::memcpy(write_area(), data, chunk);
+        commit(chunk, on_line, on_frame);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+#endif // DEVICE_FRAME_H
@@ -0,0 +1,35 @@
+#ifndef DEVICE_LINE_PARSER_H
+#define DEVICE_LINE_PARSER_H
+
+#include <string_view>
+#include <cstdint>
+#include <ctime>
+
+// Показание из строки устройства
+struct DeviceReading {
+    float temperature = 0.0f;
+    int64_t timestamp_ms = 0; // время устройства, мс от эпохи
+    bool has_time = false;    // поля TIME не было - время ставит приёмник
+};
+
+// Разбор строк "TEMP:<float> TIME:YYYY-MM-DD HH:MM:SS.mmm" без выделения
+// памяти и без зависимости от локали (std::from_chars). Миллисекунды и поле
+// TIME необязательны. Время устройства - местное; смещение от UTC берётся
+// из mktime один раз на час и кэшируется, поэтому объект не разделяется
+// между потоками.
+class DeviceLineParser {
+public:
+    static constexpr float MIN_TEMPERATURE = -273.15f;
+    static constexpr float MAX_TEMPERATURE = 1000.0f;
+
+    // false - строка не в этом формате или значения вне допустимых пределов
+    bool parse(std::string_view line, DeviceReading& reading);
+
+private:
+    int64_t local_offset(int64_t civil_hour, int year, int month, int day, int hour);
+
+    int64_t cached_hour_ = INT64_MIN; // час (по местному календарю) в кэше
+    int64_t cached_offset_ = 0;       // местное время - UTC, секунды
+};
+
+#endif // DEVICE_LINE_PARSER_H
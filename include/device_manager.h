@@ -0,0 +1,80 @@
+#ifndef DEVICE_MANAGER_H
+#define DEVICE_MANAGER_H
+
+#include "serial_port.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+class PortReader;
+
+// Устройство из конфигурации: путь, параметры линии и датчик
+struct DeviceConfig {
+    std::string path;
+    SerialSettings settings;
+    std::string sensor_id;
+};
+
+// Опрашивает много последовательных устройств из нескольких потоков
+// событий (epoll): число потоков не зависит от числа устройств. Отключённые
+// и ещё не появившиеся устройства переоткрываются с растущей задержкой.
+class DeviceManager {
+public:
+    // Строка действительна только во время вызова
+    using LineCallback = std::function<void(const std::string& sensor_id, std::string_view line)>;
+    // Двоичный кадр целиком, CRC проверена; протокол каждого устройства
+    // определяется по потоку
+    using FrameCallback = std::function<void(const std::string& sensor_id, std::string_view frame)>;
+
+    // threads == 0 - один поток
+    explicit DeviceManager(size_t threads = 1);
+    ~DeviceManager();
+
+    DeviceManager(const DeviceManager&) = delete;
+    DeviceManager& operator=(const DeviceManager&) = delete;
+
+    // До start()
+    bool add_device(const DeviceConfig& config);
+    // callback вызывается из потоков событий, одновременно для разных устройств
+    void set_callback(LineCallback callback);
+    void set_frame_callback(FrameCallback callback);
+
+    bool start();
+    void stop();
+
+    size_t device_count() const { return devices_.size(); }
+    size_t connected_count() const { return connected_.load(); }
+
+    // Строка конфигурации: "<путь> [скорость] [формат] [датчик]", например
+    // "/dev/ttyUSB0 115200 8N1 rack1-top". По умолчанию 9600 8N1, датчик - путь.
+    static bool parse_device_line(const std::string& line, DeviceConfig& config);
+    // Файл конфигурации: по устройству в строке, "#" - комментарий
+    static bool load_config(const std::string& path, std::vector<DeviceConfig>& devices);
+
+    static constexpr std::chrono::milliseconds INITIAL_BACKOFF{250};
+    static constexpr std::chrono::milliseconds MAX_BACKOFF{30000};
+
+private:
+    struct Device;
+    struct EventLoop;
+
+    void event_loop(EventLoop& loop);
+    void try_connect(EventLoop& loop, Device& device);
+    void disconnect(EventLoop& loop, Device& device);
+    void read_device(EventLoop& loop, Device& device);
+
+    size_t threads_;
+    std::vector<std::unique_ptr<Device>> devices_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    LineCallback callback_;
+    FrameCallback frame_callback_;
+    std::atomic<size_t> connected_{0};
+    bool started_ = false;
+};
+
+#endif // DEVICE_MANAGER_H
@@ -5,6 +5,8 @@
 #include <thread>
 #include <atomic>
 #include <vector>
+#include <chrono>
+#include <cstddef>
 
 class DeviceSimulator {
 public:
@@ -14,10 +16,15 @@ public:
     bool start();
     void stop();
     void set_temperature_range(float min, float max);
+    // 0 - текстовые строки "TEMP:... TIME:...", иначе двоичные кадры
+    // (device_frame.h) по samples_per_frame показаний, не больше MAX_FRAME_SAMPLES
+    void set_binary_frames(size_t samples_per_frame);
+    void set_sample_interval(std::chrono::milliseconds interval);
     
 private:
     void simulation_loop();
     float generate_temperature();
+    void write_message(const void* data, size_t size);
     
     std::string port_name_;
     int baud_rate_;
@@ -26,6 +33,8 @@ private:
     
     float min_temp_{20.0f};
     float max_temp_{25.0f};
+    size_t samples_per_frame_{0};
+    std::chrono::milliseconds sample_interval_{5000};
     int file_descriptor_{-1};
     
 #ifdef _WIN32
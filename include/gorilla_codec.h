@@ -0,0 +1,74 @@
+#ifndef GORILLA_CODEC_H
+#define GORILLA_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include <vector>
+
+// Блочный кодек измерений в стиле Facebook Gorilla:
+// метки времени кодируются как delta-of-delta, температуры - XOR с предыдущим значением.
+// Формат блока: [uint32 количество записей, little-endian][битовый поток].
+class GorillaEncoder {
+public:
+    GorillaEncoder();
+
+    void append(std::time_t timestamp, float temperature);
+    void clear();
+
+    bool empty() const { return count_ == 0; }
+    uint32_t count() const { return count_; }
+    std::time_t first_timestamp() const { return first_timestamp_; }
+    std::time_t last_timestamp() const { return prev_timestamp_; }
+
+    // Размер закодированного блока в байтах (с заголовком)
+    size_t size_bytes() const;
+
+    // Возвращает готовый блок; кодер при этом не сбрасывается
+    std::vector<uint8_t> finish() const;
+
+private:
+    void write_bits(uint64_t value, int bits);
+
+    std::vector<uint8_t> stream_;
+    int bit_pos_{0}; // занятые биты в последнем байте stream_
+
+    uint32_t count_{0};
+    std::time_t first_timestamp_{0};
+    std::time_t prev_timestamp_{0};
+    int64_t prev_delta_{0};
+    uint32_t prev_value_{0};
+    int prev_leading_{-1};
+    int prev_trailing_{0};
+};
+
+// Потоковый декодер: не выделяет память, читает записи по одной
+class GorillaDecoder {
+public:
+    GorillaDecoder(const uint8_t* data, size_t size);
+    explicit GorillaDecoder(const std::vector<uint8_t>& block)
+        : GorillaDecoder(block.data(), block.size()) {}
+
+    bool next(std::time_t& timestamp, float& temperature);
+    uint32_t count() const { return count_; }
+
+private:
+    uint64_t read_bits(int bits);
+    bool read_bit();
+    void refill();
+
+    const uint8_t* data_;
+    const uint8_t* end_;
+    uint64_t window_{0};
+    int available_{0};
+
+    uint32_t count_{0};
+    uint32_t decoded_{0};
+    std::time_t prev_timestamp_{0};
+    int64_t prev_delta_{0};
+    uint32_t prev_value_{0};
+    int prev_leading_{0};
+    int prev_trailing_{0};
+};
+
+#endif // GORILLA_CODEC_H
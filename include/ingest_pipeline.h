@@ -0,0 +1,180 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include "spsc_ring.h"
+#include "device_line_parser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+
+// Что делает производитель, когда следующая стадия не успевает
+enum class OverflowPolicy {
+    DropNewest, // новое сообщение отбрасывается и учитывается в dropped
+    Block,      // производитель ждёт, пока освободится место
+    Spill       // излишек копится у производителя до spill_limit, сверх него - DropNewest
+};
+
+// Показание после разбора; время окончательное, секунды от эпохи - с той же
+// точностью, что и в хранилище (миллисекунды строк и кадров отбрасываются)
+struct IngestSample {
+    const std::string* sensor_id = nullptr;
+    std::time_t timestamp = 0;
+    float temperature = 0.0f;
+};
+
+// Счётчики одной границы между стадиями
+struct StageStats {
+    uint64_t accepted = 0;  // принято производителем (в кольцо или в запас)
+    uint64_t processed = 0; // забрано следующей стадией
+    uint64_t dropped = 0;   // отброшено по политике переполнения
+    size_t queued = 0;      // ждёт сейчас, вместе с запасом
+    size_t high_water = 0;  // наибольшая замеченная глубина кольца
+};
+
+struct IngestStats {
+    StageStats raw;     // потоки чтения -> разбор
+    StageStats samples; // разбор -> запись
+    uint64_t parse_errors = 0;
+    uint64_t clock_corrections = 0; // показаний со сбитыми часами устройства
+    uint64_t batches = 0;
+    uint64_t write_retries = 0;
+};
+
+struct IngestOptions {
+    size_t raw_capacity = 1024; // слотов на каждый поток чтения
+    // Поток чтения не должен ждать и копить: допустимы DropNewest и Block
+    OverflowPolicy raw_overflow = OverflowPolicy::DropNewest;
+    size_t sample_capacity = 1 << 16;
+    OverflowPolicy sample_overflow = OverflowPolicy::Spill;
+    size_t spill_limit = 1 << 20;
+    size_t max_batch = 4096;
+    // Время устройства, отличающееся от времени приёма сильнее, заменяется им
+    long long max_clock_skew_seconds = 86400;
+};
+
+// Конвейер приёма показаний. Потоки чтения только кладут строки и кадры в
+// свои кольца SPSC (у каждого потока - своё, заводится при первой записи);
+// поток разбора разбирает их и передаёт показания потоку записи, который
+// сохраняет их пачками. Заминка записи задерживает только поток записи:
+// показания копятся в кольце и запасе разборщика, а чтение портов не ждёт.
+class IngestPipeline {
+public:
+    // Сохраняет пачку и возвращает, сколько показаний с её начала сохранено;
+    // остаток повторяется через RETRY_MS, пока конвейер не остановят. Пачка
+    // упорядочена по времени (показания одного датчика - в порядке приёма).
+    using BatchSink = std::function<size_t(const std::vector<IngestSample>& batch)>;
+
+    explicit IngestPipeline(const IngestOptions& options = IngestOptions());
+    ~IngestPipeline();
+
+    IngestPipeline(const IngestPipeline&) = delete;
+    IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+    // До start()
+    void set_sink(BatchSink sink);
+
+    bool start();
+    // Дописывает всё принятое; производители к этому моменту должны остановиться
+    void stop();
+
+    // Из потоков чтения. sensor_id должен жить дольше конвейера. false -
+    // сообщение отброшено (конвейер не запущен, кольцо полно или строка
+    // длиннее MAX_RAW_MESSAGE).
+    bool push_line(const std::string& sensor_id, std::string_view line);
+    bool push_frame(const std::string& sensor_id, std::string_view frame);
+
+    IngestStats stats() const;
+
+    static constexpr size_t MAX_RAW_MESSAGE = 272; // вмещает самый длинный кадр
+    static constexpr size_t MAX_PRODUCERS = 64;
+    static constexpr int IDLE_WAIT_MS = 100;
+    static constexpr int SPILL_RETRY_MS = 5;
+    static constexpr int RETRY_MS = 100;
+
+private:
+    struct RawMessage {
+        const std::string* sensor_id;
+        int64_t received_ms; // время приёма: для строк без TIME и проверки часов
+        uint16_t size;
+        bool frame;
+        char data[MAX_RAW_MESSAGE];
+    };
+
+    struct Producer {
+        explicit Producer(size_t capacity) : ring(capacity) {}
+        SpscRing<RawMessage> ring;
+        std::thread::id thread;
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<size_t> high_water{0};
+    };
+
+    bool push_raw(const std::string& sensor_id, std::string_view data, bool frame);
+    Producer* current_producer();
+    bool raw_empty() const;
+
+    void parser_loop();
+    void handle_message(const RawMessage& message);
+    void emit_sample(const std::string* sensor_id, std::time_t timestamp, float temperature);
+    bool drain_spill();
+
+    void writer_loop();
+    void write_batch(std::vector<IngestSample>& batch);
+
+    const IngestOptions options_;
+    const uint64_t id_; // отличает конвейеры в кэше потоков чтения
+    BatchSink sink_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> parser_done_{false};
+    bool started_ = false;
+
+    // Кольца потоков чтения: добавляются под мьютексом, читаются без него
+    std::unique_ptr<Producer> producers_[MAX_PRODUCERS];
+    std::atomic<size_t> producer_count_{0};
+    std::mutex producers_mutex_;
+    std::atomic<uint64_t> unregistered_drops_{0};
+
+    // Данные ниже принадлежат потоку разбора
+    DeviceLineParser line_parser_;
+    std::deque<IngestSample> spill_;
+    // Имена каналов многоканальных устройств: "<датчик>/N"
+    std::map<std::pair<const std::string*, unsigned>, std::string> channel_names_;
+
+    SpscRing<IngestSample> samples_;
+    std::atomic<uint64_t> samples_accepted_{0};
+    std::atomic<uint64_t> samples_dropped_{0};
+    std::atomic<size_t> samples_high_water_{0};
+    std::atomic<size_t> spilled_{0};
+    std::atomic<uint64_t> raw_processed_{0};
+    std::atomic<uint64_t> samples_processed_{0};
+    std::atomic<uint64_t> parse_errors_{0};
+    std::atomic<uint64_t> clock_corrections_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> write_retries_{0};
+
+    std::thread parser_thread_;
+    std::thread writer_thread_;
+
+    // Стадия засыпает, только проверив под мьютексом, что входных данных нет
+    std::mutex parser_mutex_;
+    std::condition_variable parser_cv_;
+    std::atomic<bool> parser_sleeping_{false};
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    std::atomic<bool> writer_sleeping_{false};
+};
+
+#endif // INGEST_PIPELINE_H
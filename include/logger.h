@@ -6,6 +6,13 @@
 #include <ctime>
 #include <mutex>
 #include <memory>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "mpsc_queue.h"
+#include "segmented_log.h"
 
 struct TemperatureRecord {
     std::time_t timestamp;
@@ -14,43 +21,118 @@ struct TemperatureRecord {
     TemperatureRecord(std::time_t ts, float temp) : timestamp(ts), temperature(temp) {}
 };
 
+// Формат файлов журнала: текстовые строки или бинарные записи фиксированной длины
+enum class LogFormat {
+    TEXT,
+    BINARY
+};
+
+// Вызовы log_* только кладут запись в очередь; форматирование и запись
+// в файлы выполняет фоновый поток. При разрушении очередь дописывается до конца.
 class Logger {
 public:
     static Logger& get_instance();
     
+    // Вызывается до первого get_instance(). При выборе BINARY текстовые
+    // сегменты при старте переводятся в бинарные и удаляются.
+    static void set_format(LogFormat format);
+    
     void log_measurement(std::time_t timestamp, float temperature);
     void log_hourly_average(std::time_t timestamp, float average_temp);
     void log_daily_average(std::time_t timestamp, float average_temp);
     
     void cleanup_old_data();
     
+    // Ждёт, пока всё, что поставлено в очередь до вызова, окажется в файлах
+    void flush();
+    
 private:
+    struct LogRecord {
+        enum Kind : uint8_t { MEASUREMENT, HOURLY_AVERAGE, DAILY_AVERAGE, CLEANUP };
+        
+        std::time_t timestamp;
+        float value;
+        Kind kind;
+    };
+    
     Logger();
     ~Logger();
     
-    void save_measurements_to_file();
-    void save_hourly_averages_to_file();
-    void save_daily_averages_to_file();
+    void enqueue(const LogRecord& record);
+    void flusher_loop();
+    void process(const LogRecord& record);
+    void process_measurement(std::time_t timestamp, float temperature);
+    void update_windows(const TemperatureRecord& record, bool emit);
+    void append_hourly_average(std::time_t timestamp, float average_temp);
+    void append_daily_average(std::time_t timestamp, float average_temp);
+    void remove_old_data();
+    void flush_streams();
+    
+    void load_measurements_from_file(const std::string& path, std::vector<TemperatureRecord>& out);
+    void load_hourly_averages_from_file(const std::string& path, std::vector<TemperatureRecord>& out);
+    void load_daily_averages_from_file(const std::string& path, std::vector<TemperatureRecord>& out);
+    
+    typedef void (*TextWriter)(std::ostream&, const TemperatureRecord&);
     
-    void load_measurements_from_file();
-    void load_hourly_averages_from_file();
-    void load_daily_averages_from_file();
+    void write_record(SegmentedLog& log, const TemperatureRecord& record, TextWriter text_writer);
+    void append_records(const std::vector<TemperatureRecord>& records, SegmentedLog& log, TextWriter text_writer);
     
-    std::vector<TemperatureRecord> measurements_;
-    std::vector<TemperatureRecord> hourly_averages_;
-    std::vector<TemperatureRecord> daily_averages_;
+    // Журналы в памяти не хранятся: при старте читаются только измерения,
+    // чтобы восстановить текущие час и сутки
+    void load_segments(std::vector<TemperatureRecord>& measurements);
+    void migrate_legacy_files(std::vector<TemperatureRecord>& measurements);
+    void convert_text_segments(std::vector<TemperatureRecord>& measurements);
     
-    std::mutex measurements_mutex_;
-    std::mutex hourly_mutex_;
-    std::mutex daily_mutex_;
+    static LogFormat configured_format_;
+    const LogFormat format_;
     
-    const std::string measurements_file_ = "temperature_measurements.log";
-    const std::string hourly_file_ = "hourly_averages.log";
-    const std::string daily_file_ = "daily_averages.log";
+    // Сегменты: измерения - по часу, часовые средние - по месяцу, дневные - по году.
+    // Файлы принадлежат фоновому потоку.
+    SegmentedLog measurements_log_;
+    SegmentedLog hourly_log_;
+    SegmentedLog daily_log_;
     
-    std::time_t last_hourly_save_ = 0;
-    std::time_t last_daily_save_ = 0;
+    // Файлы прежнего формата: при старте переносятся в сегменты и удаляются
+    const std::string legacy_measurements_file_ = "temperature_measurements.log";
+    const std::string legacy_hourly_file_ = "hourly_averages.log";
+    const std::string legacy_daily_file_ = "daily_averages.log";
+    
+    // Текущие час и сутки по местным часам: сумма и количество обновляются
+    // на каждое измерение, среднее пишется при переходе в следующее окно
+    struct RunningWindow {
+        std::time_t start = 0;
+        std::time_t end = 0;
+        double sum = 0.0;
+        long long count = 0;
+    };
+    
+    RunningWindow hour_window_;
+    RunningWindow day_window_;
     std::time_t last_cleanup_ = 0;
+    std::time_t last_flush_ = 0;
+    
+    MpscQueue<LogRecord> queue_{QUEUE_CAPACITY};
+    std::thread flusher_thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> flusher_sleeping_{false};
+    std::atomic<bool> flush_requested_{false};
+    
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> flushed_{0}; // записей, гарантированно сброшенных в файлы
+    uint64_t processed_ = 0;
+    
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    
+    static constexpr const char* LOG_DIR = "logs";
+    static constexpr std::time_t MEASUREMENTS_RETENTION_SECONDS = 86400;  // 24 часа
+    static constexpr std::time_t HOURLY_RETENTION_SECONDS = 2592000;      // 30 дней
+    static constexpr std::time_t DAILY_RETENTION_SECONDS = 31536000;      // 365 дней
+    static constexpr int FLUSH_INTERVAL_SECONDS = 5;
+    static constexpr size_t QUEUE_CAPACITY = 1 << 16;
+    static constexpr size_t MAX_BATCH = 4096;
+    static constexpr int IDLE_WAIT_MS = 100;
 };
 
 #endif // LOGGER_H
@@ -0,0 +1,49 @@
+#ifndef MEASUREMENT_CACHE_H
+#define MEASUREMENT_CACHE_H
+
+#include "database_manager.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// Кольцевой буфер последних измерений перед базой данных.
+// Пишет один поток (приём данных), читатели не берут блокировок:
+// они копируют нужный участок и проверяют, что его не перезаписали.
+class MeasurementCache {
+public:
+    explicit MeasurementCache(size_t capacity);
+
+    // Только для потока записи
+    void push(std::time_t timestamp, float temperature);
+
+    // Забыть все записи (при закрытии хранилища); читателей быть не должно
+    void clear();
+
+    // С этого момента кэш содержит все измерения хранилища
+    void set_coverage_start(std::time_t from);
+
+    bool get_last(TemperatureData& out) const;
+
+    // Измерения из [from, to], от новых к старым. Возвращает false,
+    // если кэш не может ответить полностью и нужно идти в хранилище.
+    bool query(std::time_t from, std::time_t to, int limit,
+               std::vector<TemperatureData>& out) const;
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    std::time_t timestamp_at(uint64_t index) const;
+
+    size_t capacity_;
+    std::unique_ptr<std::atomic<std::time_t>[]> timestamps_;
+    std::unique_ptr<std::atomic<float>[]> temperatures_;
+
+    std::atomic<uint64_t> head_{0};     // опубликованные записи
+    std::atomic<uint64_t> reserved_{0}; // начатые записи (слот мог быть перезаписан)
+    std::atomic<std::time_t> coverage_start_;
+
+    std::time_t last_pushed_{0};
+};
+
+#endif // MEASUREMENT_CACHE_H
@@ -0,0 +1,104 @@
+#ifndef NETWORK_LISTENER_H
+#define NETWORK_LISTENER_H
+
+#include "serial_port.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// Принимает показания сетевых датчиков по UDP и TCP. Формат тот же, что у
+// устройств на COM-порту, с идентификатором датчика впереди:
+// "<датчик> TEMP:21.5 TIME:2024-01-15 14:30:45.123\n". Датаграмма UDP может
+// нести несколько строк (последняя - без '\n'), соединение TCP - сколько угодно.
+// Все сокеты обслуживает один поток событий (epoll); датаграммы читаются
+// пачками через recvmmsg.
+class NetworkListener {
+public:
+    // line - строка без идентификатора ("TEMP:..."), действительна только во
+    // время вызова; sensor_id живёт, пока жив NetworkListener
+    using LineCallback = std::function<void(const std::string& sensor_id, std::string_view line)>;
+
+    // Порт < 0 - протокол выключен, 0 - любой свободный (см. udp_port()/tcp_port())
+    NetworkListener(int udp_port, int tcp_port, const std::string& bind_address = "0.0.0.0");
+    ~NetworkListener();
+
+    NetworkListener(const NetworkListener&) = delete;
+    NetworkListener& operator=(const NetworkListener&) = delete;
+
+    // До start(); вызывается из потока событий
+    void set_callback(LineCallback callback);
+
+    bool start();
+    void stop();
+
+    // Фактические порты после start(); -1 - протокол выключен
+    int udp_port() const { return udp_port_; }
+    int tcp_port() const { return tcp_port_; }
+
+    size_t connection_count() const { return connections_count_.load(); }
+    uint64_t datagram_count() const { return datagrams_.load(); }
+    uint64_t line_count() const { return lines_.load(); }
+    // Строки без идентификатора, с недопустимым идентификатором, сверх
+    // MAX_SENSORS датчиков, а также обрезанные датаграммы
+    uint64_t rejected_count() const { return rejected_.load(); }
+
+    static constexpr size_t UDP_BATCH = 64;        // датаграмм за один recvmmsg
+    static constexpr size_t MAX_DATAGRAM = 2048;
+    static constexpr int UDP_RECEIVE_BUFFER = 4 << 20;
+    static constexpr size_t MAX_CONNECTIONS = 1024;
+    static constexpr size_t MAX_SENSORS = 10000;
+    static constexpr size_t MAX_SENSOR_ID = 64;
+
+private:
+    struct Connection {
+        int fd = -1;
+        LineSplitter lines;
+        const std::string* last_sensor = nullptr; // соединение обычно несёт один датчик
+    };
+
+    bool open_udp();
+    bool open_tcp();
+    void event_loop();
+    void read_datagrams();
+    void accept_connections();
+    void read_connection(Connection& connection);
+    void close_connection(Connection& connection);
+    void handle_line(std::string_view line, const std::string*& last_sensor);
+    const std::string* intern_sensor(std::string_view sensor_id);
+
+    int requested_udp_port_;
+    int requested_tcp_port_;
+    std::string bind_address_;
+    int udp_port_ = -1;
+    int tcp_port_ = -1;
+
+    int udp_fd_ = -1;
+    int tcp_fd_ = -1;
+    int epoll_fd_ = -1;
+    int stop_event_ = -1;
+    std::thread thread_;
+    bool started_ = false;
+    LineCallback callback_;
+
+    // Данные ниже принадлежат потоку событий
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::unique_ptr<char[]> datagram_buffers_;
+    const std::string* last_udp_sensor_ = nullptr;
+    // Узлы set не перемещаются: указатели на идентификаторы стабильны
+    std::set<std::string, std::less<>> sensors_;
+    bool sensor_limit_reported_ = false;
+
+    std::atomic<size_t> connections_count_{0};
+    std::atomic<uint64_t> datagrams_{0};
+    std::atomic<uint64_t> lines_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+#endif // NETWORK_LISTENER_H
@@ -2,13 +2,18 @@
 #define PORT_READER_H
 
 #include <string>
+#include <string_view>
 #include <thread>
 #include <atomic>
 #include <functional>
 
 class PortReader {
 public:
-    using DataCallback = std::function<void(const std::string&)>;
+    // Строка действительна только во время вызова
+    using DataCallback = std::function<void(std::string_view)>;
+    // Двоичный кадр целиком, CRC проверена (протокол определяется сам, см.
+    // DeviceStreamSplitter); разбирается decode_device_frame
+    using FrameCallback = std::function<void(std::string_view frame)>;
     
     PortReader(const std::string& port_name, int baud_rate = 9600);
     ~PortReader();
@@ -16,20 +21,24 @@ public:
     bool start();
     void stop();
     void set_callback(DataCallback callback);
+    void set_frame_callback(FrameCallback callback);
     
 private:
     void reading_loop();
-    bool parse_temperature(const std::string& data, float& temperature, std::time_t& timestamp);
     
     std::string port_name_;
     int baud_rate_;
     std::atomic<bool> running_{false};
     std::thread reading_thread_;
     DataCallback callback_;
+    FrameCallback frame_callback_;
     
     int file_descriptor_{-1};
+    int stop_event_{-1}; // eventfd, будит reading_loop при stop()
     
 #ifdef _WIN32
+    // Сколько ReadFile ждёт без данных, прежде чем проверить running_
+    static constexpr unsigned long STOP_CHECK_MS = 100;
     void* handle_{nullptr};
 #endif
 };
@@ -0,0 +1,63 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Процентили набора измерений; count == 0 - данных нет
+struct TemperaturePercentiles {
+    long long count = 0;
+    float p5 = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+};
+
+// Квантильный скетч DDSketch: значения раскладываются по логарифмическим
+// корзинам с шагом gamma = (1 + a) / (1 - a), поэтому любой квантиль
+// отличается от точного не более чем на долю a от его модуля. Скетчи
+// объединяются простым сложением счётчиков - результат тот же, что при
+// добавлении всех значений в один скетч.
+class QuantileSketch {
+public:
+    // Относительная точность: 0.5% - не хуже 0.1 °C при 20 °C
+    static constexpr double RELATIVE_ACCURACY = 0.005;
+
+    QuantileSketch();
+
+    void add(float value);
+    void merge(const QuantileSketch& other);
+    void clear();
+
+    bool empty() const { return count_ == 0; }
+    long long count() const { return static_cast<long long>(count_); }
+
+    // q от 0 до 1; для пустого скетча - 0
+    float quantile(double q) const;
+    TemperaturePercentiles percentiles() const;
+
+    // Компактная сериализация (varint); пустой скетч - пустой буфер
+    std::vector<uint8_t> serialize() const;
+    static bool deserialize(const uint8_t* data, size_t size, QuantileSketch& out);
+
+private:
+    // Непрерывный диапазон корзин начиная с индекса offset
+    struct Store {
+        int offset = 0;
+        std::vector<uint64_t> counts;
+
+        void add(int index, uint64_t count);
+        void merge(const Store& other);
+    };
+
+    int index_of(double magnitude) const;
+    double value_of(int index) const;
+
+    Store positive_;
+    Store negative_; // по модулю значения
+    uint64_t zero_count_ = 0;
+    uint64_t count_ = 0;
+};
+
+#endif // QUANTILE_SKETCH_H
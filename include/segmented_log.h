@@ -0,0 +1,68 @@
+#ifndef SEGMENTED_LOG_H
+#define SEGMENTED_LOG_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <fstream>
+
+// Длительность одного сегмента (границы считаются в UTC)
+enum class SegmentSpan {
+    HOUR,
+    MONTH,
+    YEAR
+};
+
+// Журнал, разбитый на файлы по времени, со списком сегментов (манифестом).
+// Устаревшие данные удаляются целыми файлами, без перезаписи.
+// record_size > 0 - записи фиксированной длины: недописанный хвост сегмента
+// отрезается перед дозаписью.
+class SegmentedLog {
+public:
+    SegmentedLog(const std::string& directory, const std::string& name,
+                 SegmentSpan span, std::time_t retention_seconds,
+                 const std::string& extension = ".log", size_t record_size = 0);
+    ~SegmentedLog();
+
+    // Создаёт каталог и читает манифест
+    bool open();
+
+    // Поток сегмента, в который попадает timestamp (nullptr при ошибке)
+    std::ostream* stream_for(std::time_t timestamp);
+
+    void flush();
+
+    // Удаляет сегменты, целиком вышедшие за срок хранения
+    size_t remove_expired(std::time_t now);
+
+    // Удаляет все сегменты (после переноса в другой формат)
+    void remove_all();
+
+    // Пути сегментов в порядке времени - для загрузки при старте
+    std::vector<std::string> segment_paths() const;
+
+    std::time_t segment_start(std::time_t timestamp) const;
+    std::time_t segment_end(std::time_t start) const;
+
+private:
+    std::string segment_name(std::time_t start) const;
+    std::string path_of(const std::string& file) const;
+    std::string manifest_path() const;
+    bool save_manifest() const;
+    size_t remove_segments(std::time_t cutoff);
+
+    std::string directory_;
+    std::string name_;
+    SegmentSpan span_;
+    std::time_t retention_seconds_;
+    std::string extension_;
+    size_t record_size_;
+
+    std::map<std::time_t, std::string> segments_; // начало -> имя файла
+
+    std::ofstream out_;
+    std::time_t out_start_ = -1;
+};
+
+#endif // SEGMENTED_LOG_H
@@ -0,0 +1,117 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Параметры линии: скорость и формат символа ("8N1", "7E2" ...)
+struct SerialSettings {
+    int baud_rate = 9600;
+    int data_bits = 8;
+    char parity = 'N'; // N, E или O
+    int stop_bits = 1;
+};
+
+// Разбирает формат символа вида "8N1"
+bool parse_serial_framing(const std::string& text, SerialSettings& settings);
+
+#ifndef _WIN32
+// Открывает порт в неблокирующем режиме и настраивает termios (VMIN = 1,
+// VTIME = 0). Каналы и файлы, не являющиеся терминалом, открываются как
+// есть. -1 - ошибка, причина в errno; сообщение выводит вызывающий.
+int open_serial_port(const std::string& path, const SerialSettings& settings);
+#endif
+
+// Собирает строки из произвольно нарезанного потока байтов в линейном
+// буфере. Данные читаются прямо в буфер (write_area/commit), строки ищутся
+// memchr только в новых байтах и отдаются как string_view без копирования;
+// в начало буфера переносится лишь недописанная строка. Пустые строки
+// пропускаются, "\r" перед "\n" остаётся частью строки. Строка длиннее
+// буфера отбрасывается целиком.
+class LineSplitter {
+public:
+    static constexpr size_t DEFAULT_MAX_LINE = 4096;
+
+    explicit LineSplitter(size_t max_line = DEFAULT_MAX_LINE);
+
+    // Место для следующего чтения; всегда не меньше одного байта
+    char* write_area() { return buffer_.get() + size_; }
+    size_t write_space() const { return capacity_ - size_; }
+
+    // Разбирает count байт, записанных в write_area(). on_line(std::string_view)
+    // вызывается для каждой строки; представление живёт до возврата из вызова.
+    template <typename Func>
+    void commit(size_t count, Func&& on_line);
+
+    // То же для данных из чужого буфера (копируются в свой)
+    template <typename Func>
+    void feed(const char* data, size_t size, Func&& on_line);
+
+    // Отбрасывает недописанную строку (например, после переподключения)
+    void clear() {
+        size_ = 0;
+        discarding_ = false;
+    }
+
+    size_t dropped_lines() const { return dropped_lines_; }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;
+    size_t size_ = 0;         // в начале буфера - недописанная строка, без '\n'
+    bool discarding_ = false; // пропускаем остаток слишком длинной строки
+    size_t dropped_lines_ = 0;
+};
+
+template <typename Func>
+void LineSplitter::commit(size_t count, Func&& on_line) {
+    char* base = buffer_.get();
+    size_t line_start = 0;
+    size_t scan = size_; // старые байты уже проверены: в них нет '\n'
+    size_ += count;
+
+    while (scan < size_) {
+        const char* newline = static_cast<const char*>(std::memchr(base + scan, '\n', size_ - scan));
+        if (newline == nullptr) break;
+
+        size_t line_end = static_cast<size_t>(newline - base);
+        if (discarding_) {
+            discarding_ = false;
+        } else if (line_end > line_start) {
+            on_line(std::string_view(base + line_start, line_end - line_start));
+        }
+        line_start = line_end + 1;
+        scan = line_start;
+    }
+
+    size_t tail = size_ - line_start;
+    if (!discarding_ && tail == capacity_) {
+        discarding_ = true;
+        ++dropped_lines_;
+    }
+    if (discarding_) {
+        size_ = 0;
+        return;
+    }
+    if (line_start > 0 && tail > 0) {
+        std::memmove(base, base + line_start, tail);
+    }
+    size_ = tail;
+}
+
+template <typename Func>
+void LineSplitter::feed(const char* data, size_t size, Func&& on_line) {
+    while (size > 0) {
+        size_t chunk = std::min(size, write_space());
+        std::memcpy(write_area(), data, chunk);
+        commit(chunk, on_line);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,52 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <ctime>
+
+// Векторные ядра агрегации массивов температур. Набор инструкций
+// выбирается при первом вызове по возможностям процессора.
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Накопление всегда в double; KAHAN дополнительно компенсирует ошибку
+// округления (нужно на очень длинных массивах)
+enum class Accumulation {
+    DOUBLE,
+    KAHAN
+};
+
+struct KernelStats {
+    long long count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double variance = 0.0; // по генеральной совокупности
+    float min = 0.0f;
+    float max = 0.0f;
+    // Только для выборки по диапазону времени
+    std::time_t first_timestamp = 0;
+    std::time_t last_timestamp = 0;
+};
+
+SimdLevel detected_simd_level();
+SimdLevel simd_level();
+
+// Принудительный выбор уровня (для тестов и замеров).
+// false - процессор такой уровень не поддерживает.
+bool set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+KernelStats aggregate_values(const float* values, size_t count,
+                             Accumulation accumulation = Accumulation::DOUBLE);
+
+// То же по элементам с from <= timestamps[i] <= to
+KernelStats aggregate_values_in_range(const std::time_t* timestamps, const float* values, size_t count,
+                                      std::time_t from, std::time_t to,
+                                      Accumulation accumulation = Accumulation::DOUBLE);
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,70 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <vector>
+#include <ctime>
+
+// Статистика окна: дисперсия - по генеральной совокупности
+struct WindowStats {
+    long long count = 0;
+    double mean = 0.0;
+    double variance = 0.0;
+    float min = 0.0f;
+    float max = 0.0f;
+    float last = 0.0f;
+    std::time_t last_timestamp = 0;
+};
+
+// Скользящее окно (now - span, now] на двух стеках: в каждом элементе
+// "передней" стопки хранится свёртка его и всех более новых элементов стопки,
+// для "задней" - одна общая свёртка. Запрос - O(1), вставка и вытеснение -
+// амортизированно O(1). Измерения ожидаются в порядке времени.
+class SlidingWindow {
+public:
+    explicit SlidingWindow(std::time_t span_seconds);
+
+    void add(std::time_t timestamp, float value);
+
+    // Вытесняет измерения с timestamp <= now - span
+    void evict_until(std::time_t now);
+
+    WindowStats stats() const;
+
+    std::time_t span() const { return span_; }
+    size_t size() const { return front_.size() + back_.size(); }
+
+private:
+    // Моноид: количество, среднее и сумма квадратов отклонений (слияние по Чану)
+    struct Summary {
+        long long count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+        float last = 0.0f;
+        std::time_t last_timestamp = 0;
+
+        static Summary of(std::time_t timestamp, float value);
+        // older - более ранние измерения, newer - более поздние
+        static Summary merge(const Summary& older, const Summary& newer);
+    };
+
+    struct FrontEntry {
+        std::time_t timestamp;
+        Summary suffix; // этот элемент и все более новые в передней стопке
+    };
+
+    struct BackEntry {
+        std::time_t timestamp;
+        float value;
+    };
+
+    void refill_front();
+
+    std::time_t span_;
+    std::vector<FrontEntry> front_; // вершина (back()) - самое старое измерение
+    std::vector<BackEntry> back_;
+    Summary back_summary_;
+};
+
+#endif // SLIDING_WINDOW_H
@@ -0,0 +1,92 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Ограниченное кольцо без блокировок: один производитель, один потребитель.
+// Слоты заполняются и читаются на месте (claim/publish, front/pop), поэтому
+// крупные записи не копируются лишний раз. Каждая сторона кэширует позицию
+// другой и читает общий счётчик, только когда кэш говорит «полно» или «пусто».
+template <typename T>
+class SpscRing {
+public:
+    // Ёмкость округляется вверх до степени двойки
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        slots_.reset(new T[size]);
+    }
+
+    // Только для производителя: свободный слот или nullptr, если кольцо заполнено.
+    // Слот становится виден потребителю после publish().
+    T* try_claim() {
+        if (tail_ - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail_ - cached_head_ > mask_) return nullptr;
+        }
+        return &slots_[tail_ & mask_];
+    }
+
+    void publish() {
+        ++tail_;
+        published_tail_.store(tail_, std::memory_order_release);
+    }
+
+    bool try_push(const T& value) {
+        T* slot = try_claim();
+        if (slot == nullptr) return false;
+        *slot = value;
+        publish();
+        return true;
+    }
+
+    // Только для потребителя: первый слот или nullptr, если кольцо пусто.
+    // Слот остаётся занятым до pop().
+    const T* front() {
+        if (head_position_ == cached_tail_) {
+            cached_tail_ = published_tail_.load(std::memory_order_acquire);
+            if (head_position_ == cached_tail_) return nullptr;
+        }
+        return &slots_[head_position_ & mask_];
+    }
+
+    void pop() {
+        ++head_position_;
+        head_.store(head_position_, std::memory_order_release);
+    }
+
+    bool try_pop(T& value) {
+        const T* slot = front();
+        if (slot == nullptr) return false;
+        value = *slot;
+        pop();
+        return true;
+    }
+
+    // Из любого потока; при одновременной работе сторон - приблизительно
+    size_t size() const {
+        return published_tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    size_t mask_{0};
+
+    // Сторона потребителя
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t head_position_{0};
+    size_t cached_tail_{0};
+
+    // Сторона производителя
+    alignas(64) std::atomic<size_t> published_tail_{0};
+    size_t tail_{0};
+    size_t cached_head_{0};
+};
+
+#endif // SPSC_RING_H
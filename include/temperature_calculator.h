@@ -1,30 +1,147 @@
 #ifndef TEMPERATURE_CALCULATOR_H
 #define TEMPERATURE_CALCULATOR_H
 
+#include "calculator_policies.h"
+#include "database_manager.h"
+#include "sliding_window.h"
+#include "time_series_ring.h"
+#include "quantile_sketch.h"
+#include "seqlock.h"
 #include <vector>
+#include <map>
+#include <memory>
 #include <ctime>
 #include <mutex>
 
-struct TemperatureData {
-    std::time_t timestamp;
-    float temperature;
-};
-
-class TemperatureCalculator {
+// Калькулятор собирается из политик (calculator_policies.h): ширина корзин
+// для процентилей и разбивки ряда, длина хранимой истории и набор сводок.
+// Всё известно при компиляции, поэтому арифметика корзин не делит на
+// переменную, а лишняя работа (скетчи для MeanAggregates) не выполняется.
+//
+// Один поток пишет (add_measurement, cleanup_old_data), читать можно из
+// любых потоков: читатели не берут блокировок писателя и не задерживают его.
+//
+// Все интервалы - (from, to], как у скользящих окон: измерение ровно в конце
+// часа относится к этому часу. Корзина с началом b содержит (b, b + ширина],
+// поэтому средние, процентили и ряд корзин за один час видят одни и те же
+// измерения.
+template <typename Buckets = FixedBuckets<3600>,
+          typename Window = RetentionWindow<86400>,
+          typename Aggregates = FullAggregates>
+class BasicTemperatureCalculator {
 public:
-    TemperatureCalculator();
+    static constexpr std::time_t BUCKET_SECONDS = Buckets::width;
+    static constexpr std::time_t RETENTION_SECONDS = Window::length;
+    
+    static constexpr std::time_t bucket_start(std::time_t timestamp) {
+        return Buckets::start_of(timestamp);
+    }
+    // Корзина, в которую попадает измерение
+    static constexpr std::time_t bucket_of(std::time_t timestamp) {
+        return Buckets::start_of(timestamp - 1);
+    }
+    
+    // Окна по умолчанию: минута, час и сутки
+    BasicTemperatureCalculator();
+    explicit BasicTemperatureCalculator(const std::vector<std::time_t>& window_seconds,
+                                        size_t capacity = DEFAULT_CAPACITY);
+    
+    // false - измерение старше последнего принятого и отброшено
+    bool add_measurement(std::time_t timestamp, float temperature);
+    
+    float calculate_hourly_average(std::time_t start_time) const {
+        return aggregate_between(start_time, start_time + SECONDS_IN_HOUR, false).average();
+    }
+    float calculate_daily_average(std::time_t start_time) const {
+        return aggregate_between(start_time, start_time + SECONDS_IN_DAY, false).average();
+    }
+    
+    // Сводка вместе со скетчем. Длинные диапазоны делятся на
+    // части, которые считаются параллельно в общем пуле потоков.
+    TemperatureAggregate calculate_aggregate(std::time_t from, std::time_t to) const;
+    
+    // Ряд сводок по корзинам, пересекающим (from, to]; пустые корзины
+    // пропускаются. Скетчи заполняются только для FullAggregates.
+    std::vector<TemperatureBucket> calculate_buckets(std::time_t from, std::time_t to) const;
+    
+    // Процентили по скетчам корзин, пересекающих (from, to].
+    // Для MeanAggregates скетчей нет - результат всегда пустой.
+    TemperaturePercentiles calculate_percentiles(std::time_t from, std::time_t to) const;
     
-    void add_measurement(std::time_t timestamp, float temperature);
-    float calculate_hourly_average(std::time_t start_time) const;
-    float calculate_daily_average(std::time_t start_time) const;
+    // Час и сутки от начала часа, содержащего hour_start/day_start
+    // (с точностью до ширины корзины)
+    TemperaturePercentiles calculate_hourly_percentiles(std::time_t hour_start) const {
+        std::time_t from = FixedBuckets<SECONDS_IN_HOUR>::start_of(hour_start);
+        return calculate_percentiles(from, from + SECONDS_IN_HOUR);
+    }
+    TemperaturePercentiles calculate_daily_percentiles(std::time_t day_start) const {
+        std::time_t from = FixedBuckets<SECONDS_IN_HOUR>::start_of(day_start);
+        return calculate_percentiles(from, from + SECONDS_IN_DAY);
+    }
+    
+    // Статистика скользящего окна, оканчивающегося последним измерением
+    // (или моментом последней очистки). false - окно такой длины не настроено.
+    bool get_window_stats(std::time_t window_seconds, WindowStats& stats) const;
     
     std::vector<TemperatureData> get_measurements_last_24h() const;
+    // Удаляет всё старше current_time - RETENTION_SECONDS
     void cleanup_old_data(std::time_t current_time);
     
 private:
-    mutable std::mutex mutex_;
-    std::vector<TemperatureData> measurements_;
+    // Разбивка ряда на корзины (b, b + ширина] для accumulate_buckets
+    struct ClosedBuckets {
+        static constexpr std::time_t start_of(std::time_t timestamp) { return bucket_of(timestamp); }
+    };
+    
+    TemperatureAggregate aggregate_between(std::time_t from, std::time_t to, bool with_sketch) const;
+    void advance_windows(std::time_t now);
+    void publish_window_stats();
+    void apply_pending_sketches();
+    
+    static constexpr std::time_t SECONDS_IN_MINUTE = 60;
+    static constexpr std::time_t SECONDS_IN_HOUR = 3600;
+    static constexpr std::time_t SECONDS_IN_DAY = 86400;
+    // Хранимая история при измерениях раз в секунду с запасом
+    static constexpr size_t DEFAULT_CAPACITY = static_cast<size_t>(RETENTION_SECONDS + RETENTION_SECONDS / 2);
+    // Записей на одну параллельную часть
+    static constexpr size_t PARALLEL_CHUNK = 65536;
+    // Сколько значений писатель откладывает, прежде чем дождаться читателей скетчей
+    static constexpr size_t MAX_PENDING_SKETCH_VALUES = 4096;
+    
+    // Упорядочивает писателей между собой; читатели его не берут
+    std::mutex write_mutex_;
+    TimeSeriesRing measurements_;
+    std::vector<SlidingWindow> windows_;
+    std::time_t window_end_ = 0;
+    
+    // Статистика окон публикуется после каждого изменения
+    std::vector<std::time_t> window_spans_;
+    std::unique_ptr<Seqlock<WindowStats>[]> window_stats_;
     
-    const int SECONDS_IN_HOUR = 3600;
-    const int SECONDS_IN_DAY = 86400;
+    // Скетч на каждую корзину (по её началу); длинные интервалы сливаются
+    // из них. Если мьютекс занят читателем, писатель не ждёт, а откладывает
+    // значения - не больше MAX_PENDING_SKETCH_VALUES.
+    mutable std::mutex sketch_mutex_;
+    std::map<std::time_t, QuantileSketch> bucket_sketches_;
+    std::vector<TemperatureData> pending_sketch_values_;
 };
+
+// Готовые конфигурации; реализации инстанцируются в temperature_calculator.cpp
+using TenSecondTemperatureCalculator =
+    BasicTemperatureCalculator<FixedBuckets<10>, RetentionWindow<3600>, MeanAggregates>;
+using MinuteTemperatureCalculator =
+    BasicTemperatureCalculator<FixedBuckets<60>, RetentionWindow<86400>, FullAggregates>;
+using HourlyTemperatureCalculator =
+    BasicTemperatureCalculator<FixedBuckets<3600>, RetentionWindow<86400>, FullAggregates>;
+// Корзины - сутки UTC, история - неделя
+using DailyTemperatureCalculator =
+    BasicTemperatureCalculator<FixedBuckets<86400>, RetentionWindow<7 * 86400>, FullAggregates>;
+
+using TemperatureCalculator = HourlyTemperatureCalculator;
+
+extern template class BasicTemperatureCalculator<FixedBuckets<10>, RetentionWindow<3600>, MeanAggregates>;
+extern template class BasicTemperatureCalculator<FixedBuckets<60>, RetentionWindow<86400>, FullAggregates>;
+extern template class BasicTemperatureCalculator<FixedBuckets<3600>, RetentionWindow<86400>, FullAggregates>;
+extern template class BasicTemperatureCalculator<FixedBuckets<86400>, RetentionWindow<7 * 86400>, FullAggregates>;
+
+#endif // TEMPERATURE_CALCULATOR_H
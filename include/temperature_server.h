@@ -2,47 +2,86 @@
 #define TEMPERATURE_SERVER_H
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <ctime>
 
-class PortReader;
+class DeviceManager;
 class HttpServer;
 class DatabaseManager;
+class IngestPipeline;
+class NetworkListener;
+struct DeviceConfig;
+struct IngestSample;
 
 class TemperatureServer {
 public:
     TemperatureServer();
     ~TemperatureServer();
     
-    bool initialize(const std::string& port_name = "", int http_port = 8080);
+    // Все устройства обслуживаются device_threads потоками событий; сетевые
+    // датчики принимаются на udp_port и tcp_port (< 0 - не принимаются)
+    bool initialize(const std::vector<DeviceConfig>& devices, int http_port = 8080,
+                    size_t device_threads = 1, int udp_port = -1, int tcp_port = -1);
     void run();
     void stop();
     
+    // Токен для /api/admin/* (параметр token); без него эти запросы отклоняются
+    void set_admin_token(const std::string& token) { admin_token_ = token; }
+    
     // HTTP обработчики
     std::string handle_current_temp(const std::map<std::string, std::string>& params);
     std::string handle_measurements(const std::map<std::string, std::string>& params);
     std::string handle_hourly_stats(const std::map<std::string, std::string>& params);
     std::string handle_daily_stats(const std::map<std::string, std::string>& params);
+    std::string handle_range_stats(const std::map<std::string, std::string>& params);
+    std::string handle_series_stats(const std::map<std::string, std::string>& params);
+    std::string handle_backup(const std::map<std::string, std::string>& params);
+    std::string handle_backup_status(const std::map<std::string, std::string>& params);
     std::string handle_system_info(const std::map<std::string, std::string>& params);
     
 private:
-    void process_temperature_data(const std::string& data);
+    // Запись пачки показаний из конвейера приёма; возвращает, сколько сохранено
+    size_t store_samples(const std::vector<IngestSample>& batch);
     void calculate_statistics();
     void cleanup_old_data();
+    void run_backup(const std::string& path);
+    bool admin_authorized(const std::map<std::string, std::string>& params) const;
     
-    std::unique_ptr<PortReader> port_reader_;
+    std::unique_ptr<IngestPipeline> pipeline_;
+    std::unique_ptr<DeviceManager> device_manager_;
+    std::unique_ptr<NetworkListener> network_listener_;
     std::unique_ptr<HttpServer> http_server_;
     
     std::thread stats_thread_;
     std::thread cleanup_thread_;
+    std::thread backup_thread_;
     std::atomic<bool> running_{false};
+    std::atomic<bool> backup_running_{false};
+    
+    std::string admin_token_;
+    std::mutex backup_mutex_;
+    std::string backup_status_{"idle"};
+    
+    struct SensorReading {
+        float temperature = 0.0f;
+        std::time_t timestamp = 0;
+    };
     
+    std::mutex readings_mutex_;
     float current_temperature_{0.0f};
     std::time_t last_update_{0};
+    std::map<std::string, SensorReading> sensor_readings_;
     
     static constexpr int STATS_INTERVAL_SECONDS = 3600; // 1 час
     static constexpr int CLEANUP_INTERVAL_SECONDS = 300; // 5 минут
+    static constexpr int BACKUP_LATENCY_BUDGET_MS = 5;
+    static constexpr const char* BACKUP_DIR = "backups";
 };
 
 #endif // TEMPERATURE_SERVER_H
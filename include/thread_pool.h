@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для разбиения тяжёлых запросов на части. Вызывающий поток
+// тоже обрабатывает части, поэтому пул из N потоков держит N - 1 рабочих.
+class ThreadPool {
+public:
+    // threads == 0 - по числу ядер
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size() + 1; }
+
+    // Вызывает func(0..count-1) параллельно и возвращается, когда все вызовы
+    // завершены. Можно вызывать из задач самого пула: части, до которых
+    // рабочие не дошли, выполняет вызывающий поток.
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+    // Общий пул запросов. Смена размера действует на следующие запросы;
+    // уже идущие дорабатывают на прежнем пуле.
+    static std::shared_ptr<ThreadPool> shared();
+    static void set_shared_size(size_t threads);
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+#endif // THREAD_POOL_H
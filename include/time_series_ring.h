@@ -0,0 +1,114 @@
+#ifndef TIME_SERIES_RING_H
+#define TIME_SERIES_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+// Кольцевой буфер фиксированной ёмкости: время и значения хранятся
+// отдельными массивами и всегда упорядочены по времени. Поиск по времени -
+// двоичный, вытеснение старых записей только сдвигает начало.
+//
+// Один писатель (push, evict_before) и любое число читателей через read():
+// читатель не берёт блокировок, а после работы проверяет, что писатель не
+// затёр прочитанные ячейки (seqlock по абсолютным номерам записей); если
+// затёр - чтение повторяется. Писатель читателей никогда не ждёт.
+// Ячейки - атомарные слова, поэтому гонок в смысле модели памяти нет; считать
+// (в том числе SIMD и в нескольких потоках) нужно по копии из copy().
+class TimeSeriesRing {
+public:
+    // Неизменяемый срез буфера: границы зафиксированы при создании
+    class View {
+    public:
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        // Логические индексы 0..size(): первая запись с timestamp >= t и > t
+        size_t lower_bound(std::time_t t) const;
+        size_t upper_bound(std::time_t t) const;
+
+        std::time_t timestamp_at(size_t index) const;
+        float value_at(size_t index) const;
+
+        // Копирует логический диапазон [first, last) в timestamps и values
+        // (любой из них может быть nullptr), возвращает число записей
+        size_t copy(size_t first, size_t last, std::time_t* timestamps, float* values) const;
+
+    private:
+        friend class TimeSeriesRing;
+
+        View(const TimeSeriesRing& ring, uint64_t first, size_t size);
+
+        size_t physical(size_t index) const {
+            size_t position = head_ + index;
+            return position < ring_->capacity_ ? position : position - ring_->capacity_;
+        }
+        // Запоминает самую старую прочитанную запись - её и проверяет read()
+        void touch(size_t index) const {
+            if (index < lowest_) lowest_ = index;
+        }
+
+        template <typename Compare>
+        size_t search(std::time_t t, Compare before) const;
+
+        const TimeSeriesRing* ring_;
+        uint64_t first_;
+        size_t head_;
+        size_t size_;
+        mutable size_t lowest_;
+    };
+
+    explicit TimeSeriesRing(size_t capacity);
+
+    // false - запись старше последней (порядок по времени нарушился бы).
+    // В заполненном буфере новая запись вытесняет самую старую.
+    bool push(std::time_t timestamp, float value);
+
+    // Удаляет записи с timestamp < cutoff
+    void evict_before(std::time_t cutoff);
+
+    // Чтение из любого потока: func(const View&) может вызываться несколько раз
+    // и должен каждый раз начинать заново
+    template <typename Func>
+    void read(Func&& func) const {
+        for (;;) {
+            View view = snapshot();
+            func(view);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (intact(view)) return;
+        }
+    }
+
+    // Текущее состояние без проверки - для потока писателя
+    View view() const { return snapshot(); }
+
+    size_t size() const { return view().size(); }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size() == 0; }
+
+    size_t lower_bound(std::time_t t) const { return view().lower_bound(t); }
+    size_t upper_bound(std::time_t t) const { return view().upper_bound(t); }
+    std::time_t timestamp_at(size_t index) const { return view().timestamp_at(index); }
+    float value_at(size_t index) const { return view().value_at(index); }
+    size_t copy(size_t first, size_t last, std::time_t* timestamps, float* values) const {
+        return view().copy(first, last, timestamps, values);
+    }
+
+private:
+    View snapshot() const;
+    bool intact(const View& view) const;
+
+    size_t capacity_;
+    std::unique_ptr<std::atomic<std::time_t>[]> timestamps_;
+    std::unique_ptr<std::atomic<float>[]> values_;
+
+    // Абсолютные номера записей: запись n лежит в ячейке n % capacity_.
+    // claimed_ увеличивается до записи ячейки, committed_ - после.
+    std::atomic<uint64_t> begin_{0};
+    std::atomic<uint64_t> committed_{0};
+    std::atomic<uint64_t> claimed_{0};
+};
+
+#endif // TIME_SERIES_RING_H
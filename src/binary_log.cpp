@@ -0,0 +1,152 @@
+#include "binary_log.h"
+#include "logger.h"
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t CHECKSUM_SEED = 0x544C4F47; // "TLOG"
+
+uint32_t record_checksum(uint64_t timestamp, uint32_t value_bits) {
+    // Перемешивание в духе финализатора MurmurHash3: дёшево и ловит
+    // порванные и обнулённые записи
+    uint64_t x = timestamp * 0x9E3779B97F4A7C15ULL + value_bits;
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    return static_cast<uint32_t>(x) ^ CHECKSUM_SEED;
+}
+
+void put_u32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value);
+    out[1] = static_cast<unsigned char>(value >> 8);
+    out[2] = static_cast<unsigned char>(value >> 16);
+    out[3] = static_cast<unsigned char>(value >> 24);
+}
+
+uint32_t get_u32(const unsigned char* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) return;
+        data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_) size_ = static_cast<size_t>(size.QuadPart);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return;
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || st.st_size == 0) return;
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) return;
+        // Файл читается один раз от начала до конца
+        madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const unsigned char*>(data);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const {
+#ifdef _WIN32
+        return file_ != INVALID_HANDLE_VALUE;
+#else
+        return fd_ >= 0;
+#endif
+    }
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace
+
+void write_binary_record(std::ostream& out, std::time_t timestamp, float value) {
+    uint64_t ts = static_cast<uint64_t>(static_cast<int64_t>(timestamp));
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    unsigned char record[BINARY_LOG_RECORD_SIZE];
+    put_u32(record, static_cast<uint32_t>(ts));
+    put_u32(record + 4, static_cast<uint32_t>(ts >> 32));
+    put_u32(record + 8, bits);
+    put_u32(record + 12, record_checksum(ts, bits));
+    out.write(reinterpret_cast<const char*>(record), sizeof(record));
+}
+
+bool load_binary_log(const std::string& path, std::vector<TemperatureRecord>& out,
+                     size_t* corrupted) {
+    MappedFile file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open binary log " << path << std::endl;
+        return false;
+    }
+
+    size_t count = file.size() / BINARY_LOG_RECORD_SIZE;
+    size_t bad = file.size() % BINARY_LOG_RECORD_SIZE != 0 ? 1 : 0;
+
+    const unsigned char* record = file.data();
+    for (size_t i = 0; i < count; ++i, record += BINARY_LOG_RECORD_SIZE) {
+        uint64_t ts = static_cast<uint64_t>(get_u32(record)) |
+                      (static_cast<uint64_t>(get_u32(record + 4)) << 32);
+        uint32_t bits = get_u32(record + 8);
+        if (get_u32(record + 12) != record_checksum(ts, bits)) {
+            ++bad;
+            continue;
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        out.emplace_back(static_cast<std::time_t>(static_cast<int64_t>(ts)), value);
+    }
+
+    if (bad > 0) {
+        std::cerr << "Skipped " << bad << " damaged records in " << path << std::endl;
+    }
+    if (corrupted) *corrupted = bad;
+    return true;
+}
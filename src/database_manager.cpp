@@ -1,39 +1,1518 @@
-#include "device_simulation.h"
+#include "database_manager.h"
+#include "gorilla_codec.h"
+#include "measurement_cache.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include <sqlite3.h>
 #include <iostream>
-#include <string>
+#include <mutex>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 
-int main(int argc, char* argv[]) {
-    std::string port_name;
-    
-    if (argc > 1) {
-        port_name = argv[1];
+namespace {
+
+// Измерения хранятся сжатыми блоками; один блок покрывает не более часа
+const std::time_t BLOCK_SPAN_SECONDS = 3600;
+const uint32_t MAX_BLOCK_SAMPLES = 4096;
+
+// Горячий кэш: сутки измерений с частотой 1 Гц
+const size_t HOT_CACHE_CAPACITY = 86400;
+const std::time_t HOT_CACHE_WARMUP_SECONDS = 86400;
+
+// Большие диапазоны декодируются порциями блоков в общем пуле потоков
+const size_t PARALLEL_BLOCK_BATCH = 1024;
+const size_t PARALLEL_PARTS_PER_THREAD = 4;
+
+// Прореживание идёт порциями, чтобы не держать блокировку подолгу
+const std::time_t COMPACTION_CHUNK_SECONDS = 6 * 3600;
+
+// Пределы шага онлайн-копии и число перезапусков подряд до перехода на
+// копирование за один шаг из отдельного соединения
+const int BACKUP_MIN_PAGES = 1;
+const int BACKUP_MAX_PAGES = 4096;
+const int BACKUP_MAX_RESTARTS = 3;
+
+const std::vector<StorageTier> DEFAULT_STORAGE_TIERS = {
+    {0, 7 * 86400},
+    {60, 30 * 86400},
+    {900, 90 * 86400},
+    {3600, 365 * 86400},
+    {86400, 3650 * 86400},
+};
+
+const char* SCHEMA_SQL =
+    "CREATE TABLE IF NOT EXISTS measurement_blocks ("
+    "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  start_ts INTEGER NOT NULL,"
+    "  end_ts INTEGER NOT NULL,"
+    "  sample_count INTEGER NOT NULL,"
+    "  sum_temp REAL NOT NULL,"
+    "  min_temp REAL NOT NULL,"
+    "  max_temp REAL NOT NULL,"
+    "  data BLOB NOT NULL,"
+    "  sketch BLOB);"
+    "CREATE INDEX IF NOT EXISTS idx_blocks_end ON measurement_blocks(end_ts);"
+    "CREATE INDEX IF NOT EXISTS idx_blocks_start ON measurement_blocks(start_ts);"
+    // Незакрытый блок дублируется построчно, чтобы не потерять его при сбое
+    "CREATE TABLE IF NOT EXISTS measurement_tail ("
+    "  timestamp INTEGER NOT NULL,"
+    "  temperature REAL NOT NULL);"
+    // Прореженные уровни хранения и до какого момента они построены
+    "CREATE TABLE IF NOT EXISTS rollups ("
+    "  resolution INTEGER NOT NULL,"
+    "  bucket_start INTEGER NOT NULL,"
+    "  sample_count INTEGER NOT NULL,"
+    "  sum_temp REAL NOT NULL,"
+    "  min_temp REAL NOT NULL,"
+    "  max_temp REAL NOT NULL,"
+    "  first_ts INTEGER NOT NULL,"
+    "  last_ts INTEGER NOT NULL,"
+    "  sketch BLOB,"
+    "  PRIMARY KEY (resolution, bucket_start)) WITHOUT ROWID;"
+    "CREATE TABLE IF NOT EXISTS rollup_state ("
+    "  resolution INTEGER PRIMARY KEY,"
+    "  compacted_until INTEGER NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS hourly_averages ("
+    "  hour_start INTEGER PRIMARY KEY,"
+    "  average_temp REAL NOT NULL,"
+    "  count INTEGER NOT NULL,"
+    "  sketch BLOB);"
+    "CREATE TABLE IF NOT EXISTS daily_averages ("
+    "  day_start INTEGER PRIMARY KEY,"
+    "  average_temp REAL NOT NULL,"
+    "  count INTEGER NOT NULL,"
+    "  sketch BLOB);";
+
+// Таблицы, созданные до появления квантильных скетчей
+const char* const SKETCH_TABLES[] = {
+    "measurement_blocks", "rollups", "hourly_averages", "daily_averages"
+};
+
+std::time_t upper_bound_or_max(std::time_t to) {
+    return to == 0 ? std::numeric_limits<std::time_t>::max() : to;
+}
+
+std::time_t align_down(std::time_t t, std::time_t step) {
+    std::time_t rem = t % step;
+    return rem < 0 ? t - rem - step : t - rem;
+}
+
+using BucketMap = std::map<std::time_t, TemperatureAggregate>;
+
+// Пустой скетч хранится как NULL
+void bind_sketch(sqlite3_stmt* stmt, int index, const QuantileSketch& sketch) {
+    std::vector<uint8_t> data = sketch.serialize();
+    if (data.empty()) {
+        sqlite3_bind_null(stmt, index);
     } else {
-#ifdef _WIN32
-        port_name = "COM3";
-        std::cout << "Using default port: COM3" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <port_name>" << std::endl;
-        std::cout << "Example: " << argv[0] << " COM3" << std::endl;
-#else
-        port_name = "/dev/ttyS0";
-        std::cout << "Using default port: /dev/ttyS0" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <port_name>" << std::endl;
-        std::cout << "Example: " << argv[0] << " /dev/ttyUSB0" << std::endl;
-#endif
+        sqlite3_bind_blob(stmt, index, data.data(), static_cast<int>(data.size()), SQLITE_TRANSIENT);
     }
-    
-    DeviceSimulator simulator(port_name, 9600);
-    simulator.set_temperature_range(18.0f, 30.0f);
-    
-    if (!simulator.start()) {
-        std::cerr << "Failed to start simulator" << std::endl;
-        return 1;
+}
+
+// false - скетча нет (NULL) или он повреждён
+bool read_sketch(sqlite3_stmt* stmt, int column, QuantileSketch& sketch) {
+    if (sqlite3_column_type(stmt, column) == SQLITE_NULL) return false;
+    const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, column));
+    return QuantileSketch::deserialize(data, static_cast<size_t>(sqlite3_column_bytes(stmt, column)), sketch);
+}
+
+// Декодирует блок, добавляя в out записи из диапазона [from, to]
+void decode_range(const uint8_t* data, size_t size, std::time_t from, std::time_t to,
+                  std::vector<TemperatureData>& out) {
+    GorillaDecoder decoder(data, size);
+    std::time_t timestamp;
+    float temperature;
+    while (decoder.next(timestamp, temperature)) {
+        if (timestamp >= from && timestamp <= to) {
+            out.push_back({timestamp, temperature});
+        }
+    }
+}
+
+// Раскладывает записи блока из [from, to) по интервалам шириной step
+void bucket_range(const uint8_t* data, size_t size, std::time_t from, std::time_t to,
+                  std::time_t step, BucketMap& out) {
+    GorillaDecoder decoder(data, size);
+    std::time_t timestamp;
+    float temperature;
+    while (decoder.next(timestamp, temperature)) {
+        if (timestamp >= from && timestamp < to) {
+            out[align_down(timestamp, step)].add(timestamp, temperature);
+        }
+    }
+}
+
+struct BlockRow {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> sketch; // пусто - скетча нет
+};
+
+// Читает блоки запроса (data в первом столбце, скетч - в sketch_column, если он >= 0;
+// данные блока со скетчем не копируются) и обрабатывает их порциями в общем пуле: каждая часть копит свой Partial,
+// части сливаются через merge в потоке вызова
+template <typename Partial, typename Process, typename Merge>
+void reduce_blocks(sqlite3_stmt* stmt, int sketch_column, Process process, Merge merge) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::shared();
+    std::vector<BlockRow> rows;
+
+    auto flush = [&]() {
+        if (rows.empty()) return;
+        size_t parts = std::min(rows.size(), pool->size() * PARALLEL_PARTS_PER_THREAD);
+        std::vector<Partial> partial(parts);
+        pool->parallel_for(parts, [&](size_t part) {
+            for (size_t i = part; i < rows.size(); i += parts) {
+                process(rows[i], partial[part]);
+            }
+        });
+        for (const auto& result : partial) {
+            merge(result);
+        }
+        rows.clear();
+    };
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        BlockRow row;
+        if (sketch_column >= 0 && sqlite3_column_type(stmt, sketch_column) != SQLITE_NULL) {
+            const uint8_t* sketch = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, sketch_column));
+            row.sketch.assign(sketch, sketch + sqlite3_column_bytes(stmt, sketch_column));
+        }
+        // Если есть скетч, данные блока не нужны
+        if (row.sketch.empty()) {
+            const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+            row.data.assign(data, data + sqlite3_column_bytes(stmt, 0));
+        }
+        rows.push_back(std::move(row));
+        if (rows.size() >= PARALLEL_BLOCK_BATCH) {
+            flush();
+        }
+    }
+    flush();
+}
+
+// Агрегирует записи блока из диапазона [from, to]: блок раскладывается
+// в массивы времени и значений, дальше работает векторное ядро
+void aggregate_range(const uint8_t* data, size_t size, std::time_t from, std::time_t to,
+                     TemperatureAggregate& out) {
+    thread_local std::vector<std::time_t> timestamps;
+    thread_local std::vector<float> temperatures;
+    timestamps.clear();
+    temperatures.clear();
+
+    GorillaDecoder decoder(data, size);
+    timestamps.reserve(decoder.count());
+    temperatures.reserve(decoder.count());
+    std::time_t timestamp;
+    float temperature;
+    while (decoder.next(timestamp, temperature)) {
+        timestamps.push_back(timestamp);
+        temperatures.push_back(temperature);
+    }
+
+    KernelStats stats = aggregate_values_in_range(timestamps.data(), temperatures.data(),
+                                                  timestamps.size(), from, to);
+    if (stats.count == 0) return;
+
+    TemperatureAggregate part;
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        if (timestamps[i] >= from && timestamps[i] <= to) {
+            part.sketch.add(temperatures[i]);
+        }
+    }
+    part.count = stats.count;
+    part.sum = stats.sum;
+    part.min_temp = stats.min;
+    part.max_temp = stats.max;
+    part.first_timestamp = stats.first_timestamp;
+    part.last_timestamp = stats.last_timestamp;
+    out.merge(part);
+}
+
+} // namespace
+
+void TemperatureAggregate::add(std::time_t timestamp, float temperature) {
+    if (count == 0) {
+        first_timestamp = last_timestamp = timestamp;
+        min_temp = max_temp = temperature;
+    } else {
+        first_timestamp = std::min(first_timestamp, timestamp);
+        last_timestamp = std::max(last_timestamp, timestamp);
+        min_temp = std::min(min_temp, temperature);
+        max_temp = std::max(max_temp, temperature);
+    }
+    ++count;
+    sum += temperature;
+    sketch.add(temperature);
+}
+
+void TemperatureAggregate::merge(const TemperatureAggregate& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    first_timestamp = std::min(first_timestamp, other.first_timestamp);
+    last_timestamp = std::max(last_timestamp, other.last_timestamp);
+    min_temp = std::min(min_temp, other.min_temp);
+    max_temp = std::max(max_temp, other.max_temp);
+    count += other.count;
+    sum += other.sum;
+    sketch.merge(other.sketch);
+}
+
+TemperaturePercentiles TemperatureAggregate::percentiles() const {
+    TemperaturePercentiles result = sketch.percentiles();
+    if (result.count == 0) return result;
+
+    // Крайние процентили не выходят за точные границы
+    for (float* value : {&result.p5, &result.p50, &result.p95, &result.p99}) {
+        *value = std::min(max_temp, std::max(min_temp, *value));
+    }
+    return result;
+}
+
+struct DatabaseManager::DatabaseImpl {
+    sqlite3* db{nullptr};
+    std::string db_path;
+    sqlite3_stmt* insert_tail{nullptr};
+    std::mutex mutex;
+
+    GorillaEncoder open_block;
+    TemperatureAggregate open_summary;
+
+    TemperatureData last{0, 0.0f};
+    MeasurementCache cache{HOT_CACHE_CAPACITY};
+    std::vector<StorageTier> tiers{DEFAULT_STORAGE_TIERS};
+
+    bool ensure_column(const char* table, const char* column, const char* type);
+
+    bool exec(const char* sql) {
+        char* error = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            std::cerr << "SQLite error: " << (error ? error : "unknown") << std::endl;
+            sqlite3_free(error);
+            return false;
+        }
+        return true;
+    }
+
+    bool insert_block(const GorillaEncoder& encoder, const TemperatureAggregate& summary);
+    bool seal_open_block();
+    bool append(std::time_t timestamp, float temperature, bool publish = true);
+    void publish(std::time_t timestamp, float temperature);
+    void load_tail();
+    void load_last();
+    void warm_cache();
+    std::vector<TemperatureData> query_measurements(std::time_t from, std::time_t to, int limit);
+
+    void raw_buckets(std::time_t from, std::time_t to, std::time_t step, BucketMap& out);
+    void rollup_buckets(std::time_t resolution, std::time_t from, std::time_t to,
+                        std::time_t step, BucketMap& out);
+    bool store_rollups(std::time_t resolution, const BucketMap& buckets, std::time_t compacted_until);
+    bool get_watermark(std::time_t resolution, std::time_t& until);
+    bool reopen_rollups(std::time_t oldest);
+    bool oldest_source(size_t tier_index, std::time_t& oldest);
+    bool delete_before(const char* sql, std::time_t resolution, std::time_t cutoff);
+};
+
+bool DatabaseManager::DatabaseImpl::ensure_column(const char* table, const char* column, const char* type) {
+    std::string info = std::string("PRAGMA table_info(") + table + ")";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, info.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        found = name && std::string(name) == column;
+    }
+    sqlite3_finalize(stmt);
+    if (found) return true;
+
+    std::string alter = std::string("ALTER TABLE ") + table + " ADD COLUMN " + column + " " + type;
+    return exec(alter.c_str());
+}
+
+bool DatabaseManager::DatabaseImpl::insert_block(const GorillaEncoder& encoder,
+                                                const TemperatureAggregate& summary) {
+    std::vector<uint8_t> block = encoder.finish();
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "INSERT INTO measurement_blocks "
+                      "(start_ts, end_ts, sample_count, sum_temp, min_temp, max_temp, data, sketch) "
+                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    sqlite3_bind_int64(stmt, 1, summary.first_timestamp);
+    sqlite3_bind_int64(stmt, 2, summary.last_timestamp);
+    sqlite3_bind_int(stmt, 3, static_cast<int>(encoder.count()));
+    sqlite3_bind_double(stmt, 4, summary.sum);
+    sqlite3_bind_double(stmt, 5, summary.min_temp);
+    sqlite3_bind_double(stmt, 6, summary.max_temp);
+    sqlite3_bind_blob(stmt, 7, block.data(), static_cast<int>(block.size()), SQLITE_TRANSIENT);
+    bind_sketch(stmt, 8, summary.sketch);
+
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool DatabaseManager::DatabaseImpl::seal_open_block() {
+    if (open_block.empty()) return true;
+
+    // SAVEPOINT, а не BEGIN: закрытие блока может идти внутри внешней транзакции
+    exec("SAVEPOINT seal_block");
+    bool ok = insert_block(open_block, open_summary);
+    ok = ok && exec("DELETE FROM measurement_tail");
+    if (!ok) {
+        exec("ROLLBACK TO seal_block");
+    }
+    exec("RELEASE seal_block");
+
+    if (ok) {
+        open_block.clear();
+        open_summary = TemperatureAggregate();
+    }
+    return ok;
+}
+
+bool DatabaseManager::DatabaseImpl::append(std::time_t timestamp, float temperature, bool publish) {
+    // Закрываем блок при переходе через границу часа или переполнении
+    if (!open_block.empty() &&
+        (timestamp / BLOCK_SPAN_SECONDS != open_block.first_timestamp() / BLOCK_SPAN_SECONDS ||
+         open_block.count() >= MAX_BLOCK_SAMPLES)) {
+        if (!seal_open_block()) return false;
+    }
+
+    sqlite3_reset(insert_tail);
+    sqlite3_bind_int64(insert_tail, 1, timestamp);
+    sqlite3_bind_double(insert_tail, 2, temperature);
+    if (sqlite3_step(insert_tail) != SQLITE_DONE) {
+        return false;
+    }
+
+    open_block.append(timestamp, temperature);
+    open_summary.add(timestamp, temperature);
+    if (publish) {
+        this->publish(timestamp, temperature);
+    }
+    return true;
+}
+
+void DatabaseManager::DatabaseImpl::publish(std::time_t timestamp, float temperature) {
+    cache.push(timestamp, temperature);
+    if (timestamp >= last.timestamp) {
+        last = {timestamp, temperature};
+    }
+}
+
+void DatabaseManager::DatabaseImpl::load_tail() {
+    std::vector<TemperatureData> tail;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT timestamp, temperature FROM measurement_tail ORDER BY rowid",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        tail.push_back({static_cast<std::time_t>(sqlite3_column_int64(stmt, 0)),
+                        static_cast<float>(sqlite3_column_double(stmt, 1))});
+    }
+    sqlite3_finalize(stmt);
+
+    // Перекладываем хвост заново: он может охватывать несколько блоков
+    exec("BEGIN");
+    exec("DELETE FROM measurement_tail");
+    for (const auto& data : tail) {
+        append(data.timestamp, data.temperature);
+    }
+    exec("COMMIT");
+}
+
+void DatabaseManager::DatabaseImpl::load_last() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT data FROM measurement_blocks ORDER BY end_ts DESC LIMIT 1",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        GorillaDecoder decoder(static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0)),
+                               static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+        std::time_t timestamp;
+        float temperature;
+        while (decoder.next(timestamp, temperature)) {
+            if (timestamp >= last.timestamp) {
+                last = {timestamp, temperature};
+            }
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+std::vector<TemperatureData> DatabaseManager::DatabaseImpl::query_measurements(std::time_t from, std::time_t to, int limit) {
+    std::vector<TemperatureData> result;
+    if (!db) return result;
+
+    to = upper_bound_or_max(to);
+
+    // Сначала незакрытый блок - в нём самые свежие данные
+    const TemperatureAggregate& open = open_summary;
+    if (open.count > 0 && open.last_timestamp >= from && open.first_timestamp <= to) {
+        std::vector<uint8_t> block = open_block.finish();
+        decode_range(block.data(), block.size(), from, to, result);
+        std::reverse(result.begin(), result.end());
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT data FROM measurement_blocks "
+                      "WHERE end_ts >= ? AND start_ts <= ? ORDER BY start_ts DESC";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+
+        std::vector<TemperatureData> block_rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (limit > 0 && result.size() >= static_cast<size_t>(limit)) break;
+
+            block_rows.clear();
+            decode_range(static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0)),
+                         static_cast<size_t>(sqlite3_column_bytes(stmt, 0)),
+                         from, to, block_rows);
+            result.insert(result.end(), block_rows.rbegin(), block_rows.rend());
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    // Блоки могли быть загружены не по порядку (импорт истории)
+    std::stable_sort(result.begin(), result.end(),
+        [](const TemperatureData& a, const TemperatureData& b) {
+            return a.timestamp > b.timestamp;
+        });
+
+    if (limit > 0 && result.size() > static_cast<size_t>(limit)) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+void DatabaseManager::DatabaseImpl::raw_buckets(std::time_t from, std::time_t to, std::time_t step,
+                                               BucketMap& out) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT data FROM measurement_blocks WHERE end_ts >= ? AND start_ts < ?";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        reduce_blocks<BucketMap>(stmt, -1,
+            [&](const BlockRow& row, BucketMap& partial) {
+                bucket_range(row.data.data(), row.data.size(), from, to, step, partial);
+            },
+            [&](const BucketMap& partial) {
+                for (const auto& bucket : partial) {
+                    out[bucket.first].merge(bucket.second);
+                }
+            });
+        sqlite3_finalize(stmt);
+    }
+
+    if (open_summary.count > 0 && open_summary.last_timestamp >= from && open_summary.first_timestamp < to) {
+        std::vector<uint8_t> block = open_block.finish();
+        bucket_range(block.data(), block.size(), from, to, step, out);
+    }
+}
+
+void DatabaseManager::DatabaseImpl::rollup_buckets(std::time_t resolution, std::time_t from, std::time_t to,
+                                                  std::time_t step, BucketMap& out) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT bucket_start, sample_count, sum_temp, min_temp, max_temp, first_ts, last_ts, sketch "
+                      "FROM rollups WHERE resolution = ? AND bucket_start >= ? AND bucket_start < ?";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    sqlite3_bind_int64(stmt, 1, resolution);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        TemperatureAggregate row;
+        row.count = sqlite3_column_int64(stmt, 1);
+        row.sum = sqlite3_column_double(stmt, 2);
+        row.min_temp = static_cast<float>(sqlite3_column_double(stmt, 3));
+        row.max_temp = static_cast<float>(sqlite3_column_double(stmt, 4));
+        row.first_timestamp = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
+        row.last_timestamp = static_cast<std::time_t>(sqlite3_column_int64(stmt, 6));
+        read_sketch(stmt, 7, row.sketch);
+
+        std::time_t bucket_start = static_cast<std::time_t>(sqlite3_column_int64(stmt, 0));
+        out[align_down(bucket_start, step)].merge(row);
+    }
+    sqlite3_finalize(stmt);
+}
+
+bool DatabaseManager::DatabaseImpl::store_rollups(std::time_t resolution, const BucketMap& buckets,
+                                                 std::time_t compacted_until) {
+    sqlite3_stmt* insert = nullptr;
+    const char* insert_sql = "INSERT OR REPLACE INTO rollups "
+                             "(resolution, bucket_start, sample_count, sum_temp, min_temp, max_temp, first_ts, last_ts, sketch) "
+                             "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    sqlite3_stmt* state = nullptr;
+    const char* state_sql = "INSERT OR REPLACE INTO rollup_state (resolution, compacted_until) VALUES (?, ?)";
+
+    if (sqlite3_prepare_v2(db, insert_sql, -1, &insert, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, state_sql, -1, &state, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(insert);
+        return false;
+    }
+
+    exec("SAVEPOINT store_rollups");
+    bool ok = true;
+    for (const auto& bucket : buckets) {
+        const TemperatureAggregate& agg = bucket.second;
+        sqlite3_reset(insert);
+        sqlite3_bind_int64(insert, 1, resolution);
+        sqlite3_bind_int64(insert, 2, bucket.first);
+        sqlite3_bind_int64(insert, 3, agg.count);
+        sqlite3_bind_double(insert, 4, agg.sum);
+        sqlite3_bind_double(insert, 5, agg.min_temp);
+        sqlite3_bind_double(insert, 6, agg.max_temp);
+        sqlite3_bind_int64(insert, 7, agg.first_timestamp);
+        sqlite3_bind_int64(insert, 8, agg.last_timestamp);
+        bind_sketch(insert, 9, agg.sketch);
+        if (sqlite3_step(insert) != SQLITE_DONE) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok) {
+        sqlite3_bind_int64(state, 1, resolution);
+        sqlite3_bind_int64(state, 2, compacted_until);
+        ok = sqlite3_step(state) == SQLITE_DONE;
+    }
+
+    if (!ok) {
+        exec("ROLLBACK TO store_rollups");
+    }
+    exec("RELEASE store_rollups");
+
+    sqlite3_finalize(insert);
+    sqlite3_finalize(state);
+    return ok;
+}
+
+bool DatabaseManager::DatabaseImpl::get_watermark(std::time_t resolution, std::time_t& until) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT compacted_until FROM rollup_state WHERE resolution = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, resolution);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        until = static_cast<std::time_t>(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Строки старше отметки уровня иначе так и не попали бы в прореженные данные
+bool DatabaseManager::DatabaseImpl::reopen_rollups(std::time_t oldest) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "UPDATE rollup_state SET compacted_until = (? / resolution) * resolution "
+                      "WHERE compacted_until > ?";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, oldest);
+    sqlite3_bind_int64(stmt, 2, oldest);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool DatabaseManager::DatabaseImpl::oldest_source(size_t tier_index, std::time_t& oldest) {
+    sqlite3_stmt* stmt = nullptr;
+    bool found = false;
+
+    if (tier_index == 1) {
+        if (sqlite3_prepare_v2(db, "SELECT MIN(start_ts) FROM measurement_blocks",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+    } else {
+        if (sqlite3_prepare_v2(db, "SELECT MIN(bucket_start) FROM rollups WHERE resolution = ?",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, tiers[tier_index - 1].resolution_seconds);
+    }
+
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        oldest = static_cast<std::time_t>(sqlite3_column_int64(stmt, 0));
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+
+    if (tier_index == 1 && open_summary.count > 0) {
+        oldest = found ? std::min(oldest, open_summary.first_timestamp) : open_summary.first_timestamp;
+        found = true;
+    }
+    return found;
+}
+
+bool DatabaseManager::DatabaseImpl::delete_before(const char* sql, std::time_t resolution, std::time_t cutoff) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, cutoff);
+    if (resolution > 0) {
+        sqlite3_bind_int64(stmt, 2, resolution);
+    }
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+void DatabaseManager::DatabaseImpl::warm_cache() {
+    std::time_t from = last.timestamp > HOT_CACHE_WARMUP_SECONDS ?
+        last.timestamp - HOT_CACHE_WARMUP_SECONDS : 0;
+    std::vector<TemperatureData> recent =
+        query_measurements(from, 0, static_cast<int>(cache.capacity()));
+
+    for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+        cache.push(it->timestamp, it->temperature);
+    }
+
+    // Если выборка упёрлась в ёмкость, кэш покрывает только её
+    if (recent.size() >= cache.capacity()) {
+        from = recent.back().timestamp + 1;
+    }
+    cache.set_coverage_start(from);
+}
+
+DatabaseManager& DatabaseManager::get_instance() {
+    static DatabaseManager instance;
+    return instance;
+}
+
+DatabaseManager::DatabaseManager() : impl_(std::make_unique<DatabaseImpl>()) {
+}
+
+DatabaseManager::~DatabaseManager() {
+    cleanup();
+}
+
+bool DatabaseManager::initialize(const std::string& db_path) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->db) return true;
+
+    if (sqlite3_open(db_path.c_str(), &impl_->db) != SQLITE_OK) {
+        std::cerr << "Failed to open database: " << db_path << std::endl;
+        sqlite3_close(impl_->db);
+        impl_->db = nullptr;
+        return false;
+    }
+
+    impl_->db_path = db_path;
+    impl_->exec("PRAGMA journal_mode=WAL");
+    impl_->exec("PRAGMA synchronous=NORMAL");
+
+    if (!impl_->exec(SCHEMA_SQL)) {
+        return false;
+    }
+    for (const char* table : SKETCH_TABLES) {
+        if (!impl_->ensure_column(table, "sketch", "BLOB")) {
+            return false;
+        }
+    }
+
+    if (sqlite3_prepare_v2(impl_->db,
+                           "INSERT INTO measurement_tail (timestamp, temperature) VALUES (?, ?)",
+                           -1, &impl_->insert_tail, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    impl_->load_last();
+    impl_->warm_cache();
+    impl_->load_tail();
+    return true;
+}
+
+void DatabaseManager::cleanup() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return;
+
+    impl_->seal_open_block();
+
+    sqlite3_finalize(impl_->insert_tail);
+    impl_->insert_tail = nullptr;
+    sqlite3_close(impl_->db);
+    impl_->db = nullptr;
+
+    // Следующая база может оказаться другим файлом
+    impl_->last = {0, 0.0f};
+    impl_->cache.clear();
+}
+
+bool DatabaseManager::add_measurement(std::time_t timestamp, float temperature) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+    return impl_->append(timestamp, temperature) && impl_->reopen_rollups(timestamp);
+}
+
+bool DatabaseManager::add_measurements(const std::vector<TemperatureData>& batch, size_t* stored) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (stored) *stored = 0;
+    if (!impl_->db) return false;
+
+    // Если фиксация не удастся, откатится и хвост, и закрытые по пути блоки -
+    // незакрытый блок возвращаем к снимку
+    GorillaEncoder open_block = impl_->open_block;
+    TemperatureAggregate open_summary = impl_->open_summary;
+
+    // Одна транзакция на пачку вместо фиксации каждой строки хвоста
+    impl_->exec("BEGIN");
+    size_t count = 0;
+    std::time_t oldest = 0;
+    while (count < batch.size() &&
+           impl_->append(batch[count].timestamp, batch[count].temperature, false)) {
+        oldest = count == 0 ? batch[0].timestamp : std::min(oldest, batch[count].timestamp);
+        ++count;
+    }
+    // Опоздавшие строки возвращают прореживание назад в той же транзакции
+    if ((count > 0 && !impl_->reopen_rollups(oldest)) || !impl_->exec("COMMIT")) {
+        impl_->exec("ROLLBACK");
+        impl_->open_block = std::move(open_block);
+        impl_->open_summary = std::move(open_summary);
+        return false;
+    }
+
+    // Кэш и последнее измерение видят только зафиксированные строки
+    for (size_t i = 0; i < count; ++i) {
+        impl_->publish(batch[i].timestamp, batch[i].temperature);
+    }
+    if (stored) *stored = count;
+    return count == batch.size();
+}
+
+bool DatabaseManager::add_hourly_average(std::time_t hour_start, float average_temp, int count,
+                                        const QuantileSketch& sketch) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "INSERT OR REPLACE INTO hourly_averages (hour_start, average_temp, count, sketch) "
+                      "VALUES (?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(impl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, hour_start);
+    sqlite3_bind_double(stmt, 2, average_temp);
+    sqlite3_bind_int(stmt, 3, count);
+    bind_sketch(stmt, 4, sketch);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool DatabaseManager::add_daily_average(std::time_t day_start, float average_temp, int count,
+                                        const QuantileSketch& sketch) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "INSERT OR REPLACE INTO daily_averages (day_start, average_temp, count, sketch) "
+                      "VALUES (?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(impl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, day_start);
+    sqlite3_bind_double(stmt, 2, average_temp);
+    sqlite3_bind_int(stmt, 3, count);
+    bind_sketch(stmt, 4, sketch);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+std::vector<TemperatureData> DatabaseManager::get_measurements(std::time_t from, std::time_t to, int limit) {
+    // Свежие диапазоны отдаются из кэша без блокировки потока записи
+    std::vector<TemperatureData> result;
+    if (impl_->cache.query(from, upper_bound_or_max(to), limit, result)) {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->query_measurements(from, to, limit);
+}
+
+std::vector<HourlyAverage> DatabaseManager::get_hourly_averages(std::time_t from, std::time_t to) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    std::vector<HourlyAverage> result;
+    if (!impl_->db) return result;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT hour_start, average_temp, count, sketch FROM hourly_averages "
+                      "WHERE hour_start >= ? AND hour_start <= ? ORDER BY hour_start";
+    if (sqlite3_prepare_v2(impl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return result;
+    }
+    sqlite3_bind_int64(stmt, 1, from);
+    sqlite3_bind_int64(stmt, 2, upper_bound_or_max(to));
+
+    QuantileSketch sketch;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (!read_sketch(stmt, 3, sketch)) sketch.clear();
+        result.push_back({static_cast<std::time_t>(sqlite3_column_int64(stmt, 0)),
+                          static_cast<float>(sqlite3_column_double(stmt, 1)),
+                          sqlite3_column_int(stmt, 2),
+                          sketch.percentiles()});
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+std::vector<DailyAverage> DatabaseManager::get_daily_averages(std::time_t from, std::time_t to) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    std::vector<DailyAverage> result;
+    if (!impl_->db) return result;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT day_start, average_temp, count, sketch FROM daily_averages "
+                      "WHERE day_start >= ? AND day_start <= ? ORDER BY day_start";
+    if (sqlite3_prepare_v2(impl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return result;
+    }
+    sqlite3_bind_int64(stmt, 1, from);
+    sqlite3_bind_int64(stmt, 2, upper_bound_or_max(to));
+
+    QuantileSketch sketch;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (!read_sketch(stmt, 3, sketch)) sketch.clear();
+        result.push_back({static_cast<std::time_t>(sqlite3_column_int64(stmt, 0)),
+                          static_cast<float>(sqlite3_column_double(stmt, 1)),
+                          sqlite3_column_int(stmt, 2),
+                          sketch.percentiles()});
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+TemperatureAggregate DatabaseManager::get_aggregate(std::time_t from, std::time_t to) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    TemperatureAggregate result;
+    if (!impl_->db) return result;
+
+    to = upper_bound_or_max(to);
+
+    // Блоки, целиком попавшие в диапазон, - только по сводкам
+    sqlite3_stmt* stmt = nullptr;
+    const char* whole_sql = "SELECT SUM(sample_count), SUM(sum_temp), MIN(min_temp), MAX(max_temp), "
+                            "MIN(start_ts), MAX(end_ts) FROM measurement_blocks "
+                            "WHERE start_ts >= ? AND end_ts <= ?";
+    if (sqlite3_prepare_v2(impl_->db, whole_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+            TemperatureAggregate whole;
+            whole.count = sqlite3_column_int64(stmt, 0);
+            whole.sum = sqlite3_column_double(stmt, 1);
+            whole.min_temp = static_cast<float>(sqlite3_column_double(stmt, 2));
+            whole.max_temp = static_cast<float>(sqlite3_column_double(stmt, 3));
+            whole.first_timestamp = static_cast<std::time_t>(sqlite3_column_int64(stmt, 4));
+            whole.last_timestamp = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
+            result.merge(whole);
+        }
+        sqlite3_finalize(stmt);
     }
     
-    std::cout << "Device simulator running. Press Enter to stop..." << std::endl;
-    std::cin.get();
-    
-    simulator.stop();
-    std::cout << "Device simulator stopped." << std::endl;
-    
-    return 0;
+    // Их распределения сливаются из сохранённых скетчей (параллельно); блоки,
+    // записанные до появления скетчей, декодируются
+    const char* sketch_sql = "SELECT data, sketch FROM measurement_blocks WHERE start_ts >= ? AND end_ts <= ?";
+    if (sqlite3_prepare_v2(impl_->db, sketch_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        reduce_blocks<QuantileSketch>(stmt, 1,
+            [](const BlockRow& row, QuantileSketch& partial) {
+                QuantileSketch sketch;
+                if (QuantileSketch::deserialize(row.sketch.data(), row.sketch.size(), sketch) && !sketch.empty()) {
+                    partial.merge(sketch);
+                    return;
+                }
+                GorillaDecoder decoder(row.data.data(), row.data.size());
+                std::time_t timestamp;
+                float temperature;
+                while (decoder.next(timestamp, temperature)) {
+                    partial.add(temperature);
+                }
+            },
+            [&](const QuantileSketch& partial) {
+                result.sketch.merge(partial);
+            });
+        sqlite3_finalize(stmt);
+    }
+
+    // Краевые блоки, пересекающие границы диапазона, - декодируем
+    const char* edge_sql = "SELECT data FROM measurement_blocks "
+                           "WHERE end_ts >= ? AND start_ts <= ? AND (start_ts < ? OR end_ts > ?)";
+    if (sqlite3_prepare_v2(impl_->db, edge_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        sqlite3_bind_int64(stmt, 3, from);
+        sqlite3_bind_int64(stmt, 4, to);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            aggregate_range(static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0)),
+                            static_cast<size_t>(sqlite3_column_bytes(stmt, 0)),
+                            from, to, result);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    const TemperatureAggregate& open = impl_->open_summary;
+    if (open.count > 0 && open.last_timestamp >= from && open.first_timestamp <= to) {
+        if (open.first_timestamp >= from && open.last_timestamp <= to) {
+            result.merge(open);
+        } else {
+            std::vector<uint8_t> block = impl_->open_block.finish();
+            aggregate_range(block.data(), block.size(), from, to, result);
+        }
+    }
+
+    return result;
+}
+
+std::vector<TemperatureBucket> DatabaseManager::get_downsampled(std::time_t from, std::time_t to,
+                                                               std::time_t resolution) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    std::vector<TemperatureBucket> result;
+    if (!impl_->db || resolution <= 0) return result;
+
+    from = align_down(from, resolution);
+    std::time_t end = to == 0 ? std::numeric_limits<std::time_t>::max() : to + 1;
+
+    // Самый грубый уровень, интервал которого укладывается в запрошенный целое число раз
+    const auto& tiers = impl_->tiers;
+    size_t coarsest = 0;
+    for (size_t i = 1; i < tiers.size(); ++i) {
+        if (resolution % tiers[i].resolution_seconds == 0) {
+            coarsest = i;
+        }
+    }
+
+    // Старшая часть диапазона - из грубого уровня, ещё не прореженный хвост - из более мелких
+    BucketMap buckets;
+    std::time_t start = from;
+    for (size_t i = coarsest; i >= 1 && start < end; --i) {
+        std::time_t until;
+        if (!impl_->get_watermark(tiers[i].resolution_seconds, until)) continue;
+
+        std::time_t tier_end = std::min(end, until);
+        if (start < tier_end) {
+            impl_->rollup_buckets(tiers[i].resolution_seconds, start, tier_end, resolution, buckets);
+            start = tier_end;
+        }
+    }
+    if (start < end) {
+        impl_->raw_buckets(start, end, resolution, buckets);
+    }
+
+    result.reserve(buckets.size());
+    for (const auto& bucket : buckets) {
+        result.push_back({bucket.first, bucket.second});
+    }
+    return result;
+}
+
+bool DatabaseManager::set_storage_tiers(const std::vector<StorageTier>& tiers) {
+    if (tiers.empty() || tiers[0].resolution_seconds != 0) return false;
+
+    for (size_t i = 0; i < tiers.size(); ++i) {
+        if (tiers[i].retention_seconds <= 0) return false;
+        if (i == 0) continue;
+
+        std::time_t prev = tiers[i - 1].resolution_seconds;
+        std::time_t res = tiers[i].resolution_seconds;
+        if (res <= prev || (prev > 0 && res % prev != 0)) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->tiers = tiers;
+    return true;
+}
+
+bool DatabaseManager::parse_storage_tiers(const std::string& spec, std::vector<StorageTier>& tiers) {
+    auto parse_duration = [](const std::string& text, std::time_t& seconds) {
+        if (text == "raw") {
+            seconds = 0;
+            return true;
+        }
+        size_t pos = 0;
+        long long value = 0;
+        try {
+            value = std::stoll(text, &pos);
+        } catch (...) {
+            return false;
+        }
+        std::string unit = text.substr(pos);
+        if (unit.empty() || unit == "s") seconds = value;
+        else if (unit == "m") seconds = value * 60;
+        else if (unit == "h") seconds = value * 3600;
+        else if (unit == "d") seconds = value * 86400;
+        else return false;
+        return value > 0;
+    };
+
+    std::vector<StorageTier> parsed;
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+
+        StorageTier tier;
+        if (!parse_duration(item.substr(0, colon), tier.resolution_seconds) ||
+            !parse_duration(item.substr(colon + 1), tier.retention_seconds)) {
+            return false;
+        }
+        parsed.push_back(tier);
+    }
+
+    if (parsed.empty()) return false;
+    tiers = parsed;
+    return true;
+}
+
+void DatabaseManager::maintain_storage(std::time_t now) {
+    std::vector<StorageTier> tiers;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->db) return;
+        tiers = impl_->tiers;
+    }
+
+    // Каждый уровень строится из предыдущего, начиная с сырых данных, и не
+    // дальше, чем построен сам источник
+    std::vector<bool> compacted(tiers.size(), true);
+    std::time_t source_until = now;
+    for (size_t i = 1; i < tiers.size(); ++i) {
+        std::time_t resolution = tiers[i].resolution_seconds;
+        std::time_t until = align_down(source_until, resolution);
+        std::time_t chunk = std::max(resolution, align_down(COMPACTION_CHUNK_SECONDS, resolution));
+
+        std::time_t watermark;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            if (!impl_->get_watermark(resolution, watermark)) {
+                std::time_t oldest;
+                watermark = impl_->oldest_source(i, oldest) ? align_down(oldest, resolution) : until;
+            }
+        }
+
+        while (watermark < until) {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            std::time_t chunk_end = std::min(until, watermark + chunk);
+
+            BucketMap buckets;
+            if (i == 1) {
+                impl_->raw_buckets(watermark, chunk_end, resolution, buckets);
+            } else {
+                impl_->rollup_buckets(tiers[i - 1].resolution_seconds, watermark, chunk_end,
+                                      resolution, buckets);
+            }
+            if (!impl_->store_rollups(resolution, buckets, chunk_end)) {
+                compacted[i] = false;
+                break;
+            }
+            watermark = chunk_end;
+        }
+        source_until = std::min(until, watermark);
+    }
+
+    // Сроки хранения: сырые блоки удаляются целиком, прореженные - по интервалам.
+    // Удаляется только то, что уже перенесено на следующий уровень; если его
+    // прореживание сейчас не удалось, уровень не трогаем
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    for (size_t i = 0; i < tiers.size(); ++i) {
+        std::time_t cutoff = now - tiers[i].retention_seconds;
+        if (i + 1 < tiers.size()) {
+            std::time_t until;
+            if (!compacted[i + 1] || !impl_->get_watermark(tiers[i + 1].resolution_seconds, until)) {
+                continue;
+            }
+            cutoff = std::min(cutoff, until);
+        }
+
+        if (i == 0) {
+            impl_->delete_before("DELETE FROM measurement_blocks WHERE end_ts < ?", 0, cutoff);
+        } else {
+            impl_->delete_before("DELETE FROM rollups WHERE bucket_start < ? AND resolution = ?",
+                                 tiers[i].resolution_seconds, cutoff);
+        }
+    }
+}
+
+bool DatabaseManager::import_measurements(const std::vector<TemperatureData>& batch) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db || batch.empty()) return impl_->db != nullptr;
+
+    // Пакет пишется сразу готовыми блоками, минуя построчный хвост
+    impl_->exec("BEGIN");
+
+    GorillaEncoder encoder;
+    TemperatureAggregate summary;
+    std::time_t oldest = batch.front().timestamp;
+    bool ok = true;
+
+    for (const auto& data : batch) {
+        if (!encoder.empty() &&
+            (data.timestamp / BLOCK_SPAN_SECONDS != encoder.first_timestamp() / BLOCK_SPAN_SECONDS ||
+             encoder.count() >= MAX_BLOCK_SAMPLES)) {
+            ok = ok && impl_->insert_block(encoder, summary);
+            encoder.clear();
+            summary = TemperatureAggregate();
+        }
+        encoder.append(data.timestamp, data.temperature);
+        summary.add(data.timestamp, data.temperature);
+        oldest = std::min(oldest, data.timestamp);
+    }
+    if (!encoder.empty()) {
+        ok = ok && impl_->insert_block(encoder, summary);
+    }
+
+    // Прореженные уровни пересчитаются начиная с самых старых загруженных данных
+    ok = ok && impl_->reopen_rollups(oldest);
+
+    impl_->exec(ok ? "COMMIT" : "ROLLBACK");
+    if (!ok) return false;
+
+    for (const auto& data : batch) {
+        impl_->cache.push(data.timestamp, data.temperature);
+        if (data.timestamp >= impl_->last.timestamp) {
+            impl_->last = data;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::export_measurements(std::time_t from, std::time_t to, int threads,
+                                          const ChunkFormatter& format, const ChunkSink& sink) {
+    std::vector<long long> block_ids;
+    std::vector<TemperatureData> open_rows;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->db) return false;
+
+        path = impl_->db_path;
+        to = upper_bound_or_max(to);
+
+        sqlite3_stmt* stmt = nullptr;
+        const char* sql = "SELECT id FROM measurement_blocks "
+                          "WHERE end_ts >= ? AND start_ts <= ? ORDER BY start_ts";
+        if (sqlite3_prepare_v2(impl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            block_ids.push_back(sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+
+        if (impl_->open_summary.count > 0) {
+            std::vector<uint8_t> block = impl_->open_block.finish();
+            decode_range(block.data(), block.size(), from, to, open_rows);
+        }
+    }
+
+    if (threads < 1) threads = 1;
+
+    // Окно готовых, но ещё не отданных блоков ограничивает расход памяти
+    const size_t window = static_cast<size_t>(threads) * 4;
+    std::vector<std::string> chunks(window);
+    std::vector<bool> ready(window, false);
+    std::mutex window_mutex;
+    std::condition_variable window_cv;
+    size_t emitted = 0;
+    std::atomic<size_t> next_block{0};
+    std::atomic<bool> failed{false};
+
+    auto worker = [&]() {
+        sqlite3* conn = nullptr;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_open_v2(path.c_str(), &conn, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(conn, "SELECT data FROM measurement_blocks WHERE id = ?",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            failed = true;
+            window_cv.notify_all();
+            sqlite3_close(conn);
+            return;
+        }
+
+        std::vector<TemperatureData> rows;
+        for (;;) {
+            size_t index = next_block++;
+            if (index >= block_ids.size()) break;
+
+            {
+                std::unique_lock<std::mutex> lock(window_mutex);
+                window_cv.wait(lock, [&]() { return failed || index < emitted + window; });
+                if (failed) break;
+            }
+
+            rows.clear();
+            sqlite3_reset(stmt);
+            sqlite3_bind_int64(stmt, 1, block_ids[index]);
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_ROW) {
+                // Блок удалён после составления списка (например, по сроку
+                // хранения) - выгрузка была бы неполной
+                std::cerr << (rc == SQLITE_DONE ? "Block removed during export: " : "Failed to read block: ")
+                          << block_ids[index] << std::endl;
+                std::lock_guard<std::mutex> lock(window_mutex);
+                failed = true;
+                window_cv.notify_all();
+                break;
+            }
+            decode_range(static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0)),
+                         static_cast<size_t>(sqlite3_column_bytes(stmt, 0)),
+                         from, to, rows);
+            std::string chunk = rows.empty() ? std::string() : format(rows);
+
+            std::lock_guard<std::mutex> lock(window_mutex);
+            chunks[index % window] = std::move(chunk);
+            ready[index % window] = true;
+            window_cv.notify_all();
+        }
+
+        sqlite3_finalize(stmt);
+        sqlite3_close(conn);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    // Отдаём блоки строго по порядку
+    while (emitted < block_ids.size()) {
+        std::string chunk;
+        {
+            std::unique_lock<std::mutex> lock(window_mutex);
+            window_cv.wait(lock, [&]() { return failed || ready[emitted % window]; });
+            if (failed) break;
+            chunk = std::move(chunks[emitted % window]);
+            ready[emitted % window] = false;
+        }
+
+        if (!chunk.empty() && !sink(chunk)) {
+            failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(window_mutex);
+        ++emitted;
+        window_cv.notify_all();
+        if (failed) break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(window_mutex);
+        if (emitted < block_ids.size()) failed = true;
+        window_cv.notify_all();
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (failed) return false;
+    return open_rows.empty() || sink(format(open_rows));
+}
+
+bool DatabaseManager::backup(const std::string& dest_path, const BackupOptions& options,
+                             BackupStats* stats) {
+    auto started = std::chrono::steady_clock::now();
+    std::string tmp_path = dest_path + ".tmp";
+    std::remove(tmp_path.c_str());
+
+    sqlite3* dest = nullptr;
+    if (sqlite3_open(tmp_path.c_str(), &dest) != SQLITE_OK) {
+        std::cerr << "Failed to open backup file: " << tmp_path << std::endl;
+        sqlite3_close(dest);
+        return false;
+    }
+
+    sqlite3_backup* backup = nullptr;
+    std::string source_path;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (impl_->db) {
+            backup = sqlite3_backup_init(dest, "main", impl_->db, "main");
+            source_path = impl_->db_path;
+        }
+    }
+    if (!backup) {
+        sqlite3_close(dest);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    // Копируем через то же соединение, что и пишет: изменения подхватываются
+    // без перезапуска копии, а запись ждёт не дольше одного шага
+    int pages = 16;
+    int steps = 0;
+    int restarts = 0;
+    int prev_copied = 0;
+    int best_copied = 0;
+    int rc;
+    for (;;) {
+        std::chrono::duration<double, std::milli> step_time;
+        int copied;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            auto step_start = std::chrono::steady_clock::now();
+            rc = sqlite3_backup_step(backup, pages);
+            step_time = std::chrono::steady_clock::now() - step_start;
+            copied = sqlite3_backup_pagecount(backup) - sqlite3_backup_remaining(backup);
+        }
+        ++steps;
+
+        if (rc == SQLITE_DONE) break;
+        if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) break;
+
+        // Запись из другого процесса начинает копию заново - скопированных
+        // страниц становится меньше (свои записи лишь увеличивают базу).
+        // Счётчик сбрасывается, когда копия продвинулась дальше прежнего
+        if (copied < prev_copied) {
+            if (++restarts >= BACKUP_MAX_RESTARTS) break;
+        } else if (copied > best_copied) {
+            best_copied = copied;
+            restarts = 0;
+        }
+        prev_copied = copied;
+
+        if (step_time.count() > options.latency_budget_ms) {
+            pages = std::max(BACKUP_MIN_PAGES, pages / 2);
+        } else if (step_time.count() * 2 < options.latency_budget_ms) {
+            pages = std::min(BACKUP_MAX_PAGES, pages * 2);
+        }
+
+        if (options.pause_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.pause_ms));
+        }
+    }
+
+    int total_pages;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        total_pages = sqlite3_backup_pagecount(backup);
+        sqlite3_backup_finish(backup);
+    }
+
+    // Другой процесс пишет чаще, чем успевает копия: копируем за один шаг через
+    // отдельное соединение. В режиме WAL его чтение не блокирует пишущих, а
+    // блокировка менеджера не берётся вовсе
+    if (restarts >= BACKUP_MAX_RESTARTS) {
+        sqlite3* source = nullptr;
+        rc = sqlite3_open_v2(source_path.c_str(), &source, SQLITE_OPEN_READONLY, nullptr);
+        if (rc == SQLITE_OK) {
+            sqlite3_backup* whole = sqlite3_backup_init(dest, "main", source, "main");
+            if (whole) {
+                rc = sqlite3_backup_step(whole, -1);
+                total_pages = sqlite3_backup_pagecount(whole);
+                sqlite3_backup_finish(whole);
+                ++steps;
+            } else {
+                rc = sqlite3_errcode(dest);
+            }
+        }
+        sqlite3_close(source);
+    }
+    sqlite3_close(dest);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Backup failed: " << sqlite3_errstr(rc) << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    std::remove(dest_path.c_str());
+    if (std::rename(tmp_path.c_str(), dest_path.c_str()) != 0) {
+        std::cerr << "Failed to move backup to " << dest_path << std::endl;
+        return false;
+    }
+
+    if (stats) {
+        stats->pages = total_pages;
+        stats->steps = steps;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+    return true;
+}
+
+TemperatureData DatabaseManager::get_last_measurement() {
+    TemperatureData data;
+    if (impl_->cache.get_last(data)) {
+        return data;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->last;
+}
+
+float DatabaseManager::get_current_temperature() {
+    return get_last_measurement().temperature;
+}
+
+bool DatabaseManager::delete_old_measurements(std::time_t cutoff_time) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+
+    // Удаляются только блоки, целиком лежащие до границы
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(impl_->db, "DELETE FROM measurement_blocks WHERE end_ts < ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, cutoff_time);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool DatabaseManager::delete_old_hourly_averages(std::time_t cutoff_time) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(impl_->db, "DELETE FROM hourly_averages WHERE hour_start < ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, cutoff_time);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool DatabaseManager::delete_old_daily_averages(std::time_t cutoff_time) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(impl_->db, "DELETE FROM daily_averages WHERE day_start < ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, cutoff_time);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
 }
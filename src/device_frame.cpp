@@ -0,0 +1,130 @@
+#include "device_frame.h"
+#include <cmath>
+
+static_assert(MAX_FRAME_SAMPLES <= 255, "count is one byte");
+static_assert(MAX_FRAME_SIZE <= LineSplitter::DEFAULT_MAX_LINE, "frame must fit the default buffer");
+
+namespace {
+
+// Таблица CRC на каждый байт, строится при компиляции
+struct Crc16Table {
+    uint16_t entries[256];
+
+    constexpr Crc16Table() : entries() {
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            uint16_t crc = static_cast<uint16_t>(byte << 8);
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = static_cast<uint16_t>(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
+            }
+            entries[byte] = crc;
+        }
+    }
+};
+
+constexpr Crc16Table CRC16_TABLE;
+
+void put_u16(unsigned char* out, uint16_t value) {
+    out[0] = static_cast<unsigned char>(value);
+    out[1] = static_cast<unsigned char>(value >> 8);
+}
+
+uint16_t get_u16(const unsigned char* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+void put_u48(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 6; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+uint64_t get_u48(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 5; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+} // namespace
+
+uint16_t crc16_ccitt(const unsigned char* data, size_t size, uint16_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = static_cast<uint16_t>((crc << 8) ^ CRC16_TABLE.entries[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+bool encode_device_frame(unsigned channel, const DeviceSample* samples, size_t count,
+                         std::vector<unsigned char>& out) {
+    if (count == 0 || count > MAX_FRAME_SAMPLES || channel > 255) return false;
+    if (samples[0].timestamp_ms < 0 || samples[0].timestamp_ms > MAX_FRAME_TIME_MS) return false;
+    for (size_t i = 0; i < count; ++i) {
+        if (std::isnan(samples[i].temperature)) return false;
+        if (i > 0) {
+            int64_t delta = samples[i].timestamp_ms - samples[i - 1].timestamp_ms;
+            if (delta < 0 || delta > 0xFFFF) return false;
+        }
+    }
+
+    size_t begin = out.size();
+    out.resize(begin + FRAME_HEADER_SIZE + count * FRAME_SAMPLE_SIZE + FRAME_CRC_SIZE);
+    unsigned char* p = out.data() + begin;
+    p[0] = FRAME_SYNC;
+    p[1] = static_cast<unsigned char>(channel);
+    p[2] = static_cast<unsigned char>(count);
+    put_u48(p + 3, static_cast<uint64_t>(samples[0].timestamp_ms));
+
+    unsigned char* sample = p + FRAME_HEADER_SIZE;
+    int64_t previous = samples[0].timestamp_ms;
+    for (size_t i = 0; i < count; ++i) {
+        double centi = std::round(static_cast<double>(samples[i].temperature) * 100.0);
+        centi = std::min(std::max(centi, -32768.0), 32767.0);
+        put_u16(sample, static_cast<uint16_t>(samples[i].timestamp_ms - previous));
+        put_u16(sample + 2, static_cast<uint16_t>(static_cast<int16_t>(centi)));
+        previous = samples[i].timestamp_ms;
+        sample += FRAME_SAMPLE_SIZE;
+    }
+
+    put_u16(sample, crc16_ccitt(p + 1, static_cast<size_t>(sample - p - 1)));
+    return true;
+}
+
+FrameStatus check_device_frame(const unsigned char* data, size_t size, size_t& consumed) {
+    if (size < 3) return FrameStatus::Incomplete;
+
+    size_t count = data[2];
+    if (count == 0 || count > MAX_FRAME_SAMPLES) return FrameStatus::Corrupt;
+    size_t length = FRAME_HEADER_SIZE + count * FRAME_SAMPLE_SIZE + FRAME_CRC_SIZE;
+    if (size < length) return FrameStatus::Incomplete;
+    if (crc16_ccitt(data + 1, length - 1 - FRAME_CRC_SIZE) != get_u16(data + length - FRAME_CRC_SIZE)) {
+        return FrameStatus::Corrupt;
+    }
+    consumed = length;
+    return FrameStatus::Ok;
+}
+
+FrameStatus decode_device_frame(const unsigned char* data, size_t size, DeviceFrame& frame, size_t& consumed) {
+    size_t length = 0;
+    FrameStatus status = check_device_frame(data, size, length);
+    if (status != FrameStatus::Ok) return status;
+
+    size_t count = data[2];
+    frame.channel = data[1];
+    frame.count = count;
+    int64_t timestamp = static_cast<int64_t>(get_u48(data + 3));
+    const unsigned char* sample = data + FRAME_HEADER_SIZE;
+    for (size_t i = 0; i < count; ++i) {
+        timestamp += get_u16(sample);
+        frame.samples[i].timestamp_ms = timestamp;
+        frame.samples[i].temperature = static_cast<int16_t>(get_u16(sample + 2)) / 100.0f;
+        sample += FRAME_SAMPLE_SIZE;
+    }
+    consumed = length;
+    return FrameStatus::Ok;
+}
+
+DeviceStreamSplitter::DeviceStreamSplitter(size_t max_line)
+    : buffer_(new char[std::max(max_line, MAX_FRAME_SIZE)]),
+      capacity_(std::max(max_line, MAX_FRAME_SIZE)) {
+}
@@ -0,0 +1,206 @@
+#include "device_line_parser.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Дней от 1970-01-01 до даты григорианского календаря
+constexpr int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t year_of_era = year - era * 400;
+    const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "epoch");
+static_assert(days_from_civil(2024, 3, 1) == 19783, "leap year");
+
+constexpr int days_in_month(int year, int month) {
+    constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : DAYS[month - 1];
+}
+
+inline bool starts_with(const char* p, const char* end, std::string_view prefix) {
+    return static_cast<size_t>(end - p) >= prefix.size() && std::string_view(p, prefix.size()) == prefix;
+}
+
+constexpr double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+
+constexpr uint32_t POW10_INT[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+constexpr uint64_t ASCII_ZEROS = 0x3030303030303030ULL;
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned>(static_cast<unsigned char>(c) - '0') <= 9;
+}
+
+// До восьми цифр за раз. Если до конца строки есть восемь байтов, они
+// читаются одним словом: недостающие старшие разряды дополняются нулями,
+// и байты сворачиваются умножениями (SWAR); иначе - по одной цифре.
+inline uint32_t parse_up_to_eight_digits(const char* p, int count, const char* end) {
+    if (end - p < 8) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value = value * 10 + static_cast<uint32_t>(p[i] - '0');
+        }
+        return value;
+    }
+
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+    // Первый символ - младший байт: сдвигаем цифры к старшим байтам
+    int shift = (8 - count) * 8;
+    if (shift > 0) {
+        chunk = (chunk << shift) | (ASCII_ZEROS >> (64 - shift));
+    }
+    chunk -= ASCII_ZEROS;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+// Быстрый путь для обычной записи "-ddd.ddd": мантисса и степень десяти точно
+// представимы в double, поэтому частное округлено верно. Второе округление до
+// float может ошибиться, только если частное попало ровно на середину между
+// соседними float, - тогда, как и для длинных чисел, разбирает from_chars.
+inline const char* parse_plain_decimal(const char* p, const char* end, float& value) {
+    const char* q = p;
+    bool negative = q < end && *q == '-';
+    if (negative) ++q;
+
+    const char* integer = q;
+    while (q < end && is_digit(*q)) ++q;
+    int integer_digits = static_cast<int>(q - integer);
+
+    const char* fraction = q;
+    int fraction_digits = 0;
+    if (q < end && *q == '.') {
+        fraction = ++q;
+        while (q < end && is_digit(*q)) ++q;
+        fraction_digits = static_cast<int>(q - fraction);
+    }
+
+    // Каждая часть - не длиннее восьми цифр
+    if (integer_digits + fraction_digits == 0 || integer_digits > 8 || fraction_digits > 8) {
+        return nullptr;
+    }
+
+    int64_t mantissa = integer_digits > 0 ? parse_up_to_eight_digits(integer, integer_digits, end) : 0;
+    if (fraction_digits > 0) {
+        mantissa = mantissa * POW10_INT[fraction_digits] + parse_up_to_eight_digits(fraction, fraction_digits, end);
+    }
+
+    // Не больше 16 цифр - мантисса точно представима в double
+    double quotient = static_cast<double>(mantissa) / POW10[fraction_digits];
+    uint64_t bits;
+    std::memcpy(&bits, &quotient, sizeof(bits));
+    if ((bits & 0x1FFFFFFF) == 0x10000000) return nullptr;
+
+    value = static_cast<float>(negative ? -quotient : quotient);
+    return q;
+}
+
+inline const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && *p == ' ') ++p;
+    return p;
+}
+
+} // namespace
+
+bool DeviceLineParser::parse(std::string_view line, DeviceReading& reading) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    // Перевод строки Windows
+    if (p < end && end[-1] == '\r') --end;
+
+    if (!starts_with(p, end, "TEMP:")) return false;
+    p += 5;
+
+    // Ведущий '+' и экспонента не принимаются ни одним из путей
+    float temperature;
+    const char* number_end = parse_plain_decimal(p, end, temperature);
+    if (number_end == nullptr) {
+        auto result = std::from_chars(p, end, temperature, std::chars_format::fixed);
+        if (result.ec != std::errc()) return false;
+        number_end = result.ptr;
+    }
+    if (!std::isfinite(temperature) || temperature < MIN_TEMPERATURE || temperature > MAX_TEMPERATURE) {
+        return false;
+    }
+    p = skip_spaces(number_end, end);
+
+    if (p == end) {
+        reading.temperature = temperature;
+        reading.timestamp_ms = 0;
+        reading.has_time = false;
+        return true;
+    }
+    if (number_end == p || !starts_with(p, end, "TIME:")) return false;
+    p += 5;
+
+    // YYYY-MM-DD HH:MM:SS, затем необязательно .mmm. Позиции фиксированы,
+    // поэтому все цифры проверяются без ветвлений, одной проверкой в конце.
+    if (end - p < 19) return false;
+    unsigned invalid = 0;
+    auto digit = [&](int offset) {
+        unsigned value = static_cast<unsigned>(static_cast<unsigned char>(p[offset]) - '0');
+        invalid |= value > 9;
+        return static_cast<int>(value);
+    };
+    int year = digit(0) * 1000 + digit(1) * 100 + digit(2) * 10 + digit(3);
+    int month = digit(5) * 10 + digit(6);
+    int day = digit(8) * 10 + digit(9);
+    int hour = digit(11) * 10 + digit(12);
+    int minute = digit(14) * 10 + digit(15);
+    int second = digit(17) * 10 + digit(18);
+    invalid |= (p[4] != '-') | (p[7] != '-') | (p[10] != ' ') | (p[13] != ':') | (p[16] != ':');
+    p += 19;
+
+    int milliseconds = 0;
+    if (p < end && *p == '.') {
+        if (end - p < 4) return false;
+        milliseconds = digit(1) * 100 + digit(2) * 10 + digit(3);
+        p += 4;
+    }
+    if (invalid || skip_spaces(p, end) != end) return false;
+
+    if (year < 1970 || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) ||
+        hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    int64_t civil_hour = days_from_civil(year, month, day) * 24 + hour;
+    int64_t civil_seconds = civil_hour * 3600 + minute * 60 + second;
+    int64_t seconds = civil_seconds - local_offset(civil_hour, year, month, day, hour);
+
+    reading.temperature = temperature;
+    reading.timestamp_ms = seconds * 1000 + milliseconds;
+    reading.has_time = true;
+    return true;
+}
+
+int64_t DeviceLineParser::local_offset(int64_t civil_hour, int year, int month, int day, int hour) {
+    if (civil_hour == cached_hour_) return cached_offset_;
+
+    // Переходы на летнее время происходят на границах часов, поэтому
+    // смещения, найденного для начала часа, хватает на весь час
+    std::tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_isdst = -1;
+    std::time_t utc = std::mktime(&tm);
+
+    cached_hour_ = civil_hour;
+    cached_offset_ = civil_hour * 3600 - static_cast<int64_t>(utc);
+    return cached_offset_;
+}
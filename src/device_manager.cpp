@@ -0,0 +1,367 @@
+#include "device_manager.h"
+#include "port_reader.h"
+#include "device_frame.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Событий за один epoll_wait
+constexpr int MAX_EVENTS = 64;
+// Чтений одного устройства за событие: остальные устройства потока не ждут
+// «болтливое» (epoll срабатывает по уровню и вернётся к нему)
+constexpr int READS_PER_EVENT = 8;
+
+} // namespace
+
+struct DeviceManager::Device {
+    DeviceConfig config;
+    int fd = -1;
+    DeviceStreamSplitter stream;
+    // Задержка до следующей попытки открыть устройство
+    std::chrono::milliseconds backoff = INITIAL_BACKOFF;
+    Clock::time_point next_attempt;
+    bool failure_reported = false;
+#ifdef _WIN32
+    std::unique_ptr<PortReader> reader;
+#endif
+};
+
+struct DeviceManager::EventLoop {
+    int epoll_fd = -1;
+    int stop_event = -1;
+    std::vector<Device*> devices;
+    std::thread thread;
+};
+
+DeviceManager::DeviceManager(size_t threads)
+    : threads_(threads > 0 ? threads : 1) {
+}
+
+DeviceManager::~DeviceManager() {
+    stop();
+}
+
+bool DeviceManager::add_device(const DeviceConfig& config) {
+    if (started_) {
+        std::cerr << "Cannot add device " << config.path << " after start" << std::endl;
+        return false;
+    }
+    auto device = std::make_unique<Device>();
+    device->config = config;
+    if (device->config.sensor_id.empty()) {
+        device->config.sensor_id = config.path;
+    }
+    devices_.push_back(std::move(device));
+    return true;
+}
+
+void DeviceManager::set_callback(LineCallback callback) {
+    callback_ = callback;
+}
+
+void DeviceManager::set_frame_callback(FrameCallback callback) {
+    frame_callback_ = callback;
+}
+
+bool DeviceManager::start() {
+    if (started_) return true;
+
+#ifdef _WIN32
+    // Без epoll: по потоку PortReader на устройство, без переподключения
+    for (auto& device : devices_) {
+        const std::string sensor_id = device->config.sensor_id;
+        device->reader = std::make_unique<PortReader>(device->config.path, device->config.settings.baud_rate);
+        device->reader->set_callback([this, sensor_id](std::string_view line) {
+            if (callback_) callback_(sensor_id, line);
+        });
+        device->reader->set_frame_callback([this, sensor_id](std::string_view frame) {
+            if (frame_callback_) frame_callback_(sensor_id, frame);
+        });
+        if (device->reader->start()) {
+            ++connected_;
+        } else {
+            std::cerr << "Warning: Failed to open device " << sensor_id << std::endl;
+        }
+    }
+#else
+    size_t loop_count = std::min(threads_, devices_.size());
+    for (size_t i = 0; i < loop_count; ++i) {
+        auto loop = std::make_unique<EventLoop>();
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->stop_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        // Сигнал остановки регистрируется с пустым указателем
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        bool ok = loop->epoll_fd != -1 && loop->stop_event != -1 &&
+                  epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->stop_event, &event) == 0;
+        loops_.push_back(std::move(loop));
+        if (!ok) {
+            std::cerr << "Failed to create device event loop: " << strerror(errno) << std::endl;
+            started_ = true;
+            stop();
+            return false;
+        }
+    }
+
+    // Устройства распределяются между потоками по кругу
+    for (size_t i = 0; i < devices_.size(); ++i) {
+        loops_[i % loop_count]->devices.push_back(devices_[i].get());
+    }
+    for (auto& loop : loops_) {
+        loop->thread = std::thread(&DeviceManager::event_loop, this, std::ref(*loop));
+    }
+#endif
+
+    started_ = true;
+#ifdef _WIN32
+    size_t thread_count = devices_.size();
+#else
+    size_t thread_count = loops_.size();
+#endif
+    std::cout << "Device manager started: " << devices_.size() << " devices on "
+              << thread_count << " threads" << std::endl;
+    return true;
+}
+
+void DeviceManager::stop() {
+    if (!started_) return;
+
+#ifdef _WIN32
+    for (auto& device : devices_) {
+        if (device->reader) {
+            device->reader->stop();
+            device->reader.reset();
+        }
+    }
+#else
+    for (auto& loop : loops_) {
+        if (loop->stop_event != -1) {
+            uint64_t one = 1;
+            ssize_t written = write(loop->stop_event, &one, sizeof(one));
+            (void)written; // счётчик eventfd переполниться не может
+        }
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+        if (loop->epoll_fd != -1) close(loop->epoll_fd);
+        if (loop->stop_event != -1) close(loop->stop_event);
+    }
+    loops_.clear();
+
+    for (auto& device : devices_) {
+        if (device->fd != -1) {
+            close(device->fd);
+            device->fd = -1;
+        }
+        device->stream.clear();
+        device->backoff = INITIAL_BACKOFF;
+        device->failure_reported = false;
+    }
+#endif
+
+    connected_ = 0;
+    started_ = false;
+}
+
+#ifndef _WIN32
+void DeviceManager::event_loop(EventLoop& loop) {
+    for (Device* device : loop.devices) {
+        try_connect(loop, *device);
+    }
+
+    epoll_event events[MAX_EVENTS];
+    for (;;) {
+        // Спим до данных, остановки или ближайшей попытки переподключения
+        int timeout = -1;
+        Clock::time_point now = Clock::now();
+        for (Device* device : loop.devices) {
+            if (device->fd != -1) continue;
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(device->next_attempt - now).count();
+            wait = std::max<long long>(wait, 0);
+            if (timeout < 0 || wait < timeout) {
+                timeout = static_cast<int>(wait);
+            }
+        }
+
+        int count = epoll_wait(loop.epoll_fd, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Device event loop error: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            Device* device = static_cast<Device*>(events[i].data.ptr);
+            if (device == nullptr) return;
+
+            uint32_t flags = events[i].events;
+            if (flags & EPOLLIN) {
+                read_device(loop, *device);
+            } else if (flags & (EPOLLERR | EPOLLHUP)) {
+                disconnect(loop, *device);
+            }
+        }
+
+        now = Clock::now();
+        for (Device* device : loop.devices) {
+            if (device->fd == -1 && device->next_attempt <= now) {
+                try_connect(loop, *device);
+            }
+        }
+    }
+}
+
+void DeviceManager::try_connect(EventLoop& loop, Device& device) {
+    int fd = open_serial_port(device.config.path, device.config.settings);
+    if (fd != -1) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = &device;
+        if (epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            int error = errno;
+            close(fd);
+            fd = -1;
+            errno = error;
+        }
+    }
+
+    if (fd == -1) {
+        // Об ошибке сообщаем один раз, дальше молча ждём появления устройства
+        if (!device.failure_reported) {
+            std::cerr << "Device " << device.config.sensor_id << " (" << device.config.path
+                      << ") unavailable: " << strerror(errno) << ", retrying" << std::endl;
+            device.failure_reported = true;
+        }
+        device.next_attempt = Clock::now() + device.backoff;
+        device.backoff = std::min(device.backoff * 2, MAX_BACKOFF);
+        return;
+    }
+
+    device.fd = fd;
+    device.stream.clear();
+    device.backoff = INITIAL_BACKOFF;
+    device.failure_reported = false;
+    ++connected_;
+    std::cout << "Device connected: " << device.config.sensor_id << " (" << device.config.path << ")" << std::endl;
+}
+
+void DeviceManager::disconnect(EventLoop& loop, Device& device) {
+    epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, device.fd, nullptr);
+    close(device.fd);
+    device.fd = -1;
+    --connected_;
+
+    device.next_attempt = Clock::now() + device.backoff;
+    device.backoff = std::min(device.backoff * 2, MAX_BACKOFF);
+    std::cerr << "Device disconnected: " << device.config.sensor_id << " (" << device.config.path
+              << "), reconnecting" << std::endl;
+}
+
+void DeviceManager::read_device(EventLoop& loop, Device& device) {
+    auto on_line = [this, &device](std::string_view line) {
+        if (callback_) callback_(device.config.sensor_id, line);
+    };
+    auto on_frame = [this, &device](std::string_view frame) {
+        if (frame_callback_) frame_callback_(device.config.sensor_id, frame);
+    };
+
+    for (int reads = 0; reads < READS_PER_EVENT; ++reads) {
+        ssize_t bytes_read = read(device.fd, device.stream.write_area(), device.stream.write_space());
+        if (bytes_read > 0) {
+            device.stream.commit(static_cast<size_t>(bytes_read), on_line, on_frame);
+            continue;
+        }
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        // Конец потока или ошибка (устройство выдернули)
+        if (bytes_read < 0) {
+            std::cerr << "Read error on " << device.config.path << ": " << strerror(errno) << std::endl;
+        }
+        disconnect(loop, device);
+        return;
+    }
+}
+#else
+void DeviceManager::event_loop(EventLoop&) {}
+void DeviceManager::try_connect(EventLoop&, Device&) {}
+void DeviceManager::disconnect(EventLoop&, Device&) {}
+void DeviceManager::read_device(EventLoop&, Device&) {}
+#endif
+
+bool DeviceManager::parse_device_line(const std::string& line, DeviceConfig& config) {
+    std::istringstream iss(line);
+    DeviceConfig parsed;
+    if (!(iss >> parsed.path)) return false;
+
+    std::string baud;
+    if (iss >> baud) {
+        size_t pos = 0;
+        try {
+            parsed.settings.baud_rate = std::stoi(baud, &pos);
+        } catch (...) {
+            return false;
+        }
+        if (pos != baud.size() || parsed.settings.baud_rate <= 0) return false;
+    }
+
+    std::string framing;
+    if (iss >> framing && !parse_serial_framing(framing, parsed.settings)) {
+        return false;
+    }
+
+    iss >> parsed.sensor_id;
+    std::string extra;
+    if (iss >> extra) return false;
+    if (parsed.sensor_id.empty()) {
+        parsed.sensor_id = parsed.path;
+    }
+
+    config = parsed;
+    return true;
+}
+
+bool DeviceManager::load_config(const std::string& path, std::vector<DeviceConfig>& devices) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open device config: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<DeviceConfig> parsed;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        DeviceConfig config;
+        if (!parse_device_line(line, config)) {
+            std::cerr << "Invalid device config at " << path << ":" << line_number << ": " << line << std::endl;
+            return false;
+        }
+        parsed.push_back(config);
+    }
+
+    devices.insert(devices.end(), parsed.begin(), parsed.end());
+    return true;
+}
@@ -1,10 +1,12 @@
 #include "device_simulation.h"
+#include "device_frame.h"
 #include <iostream>
 #include <chrono>
 #include <random>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -113,6 +115,14 @@ void DeviceSimulator::set_temperature_range(float min, float max) {
     max_temp_ = max;
 }
 
+void DeviceSimulator::set_binary_frames(size_t samples_per_frame) {
+    samples_per_frame_ = std::min(samples_per_frame, MAX_FRAME_SAMPLES);
+}
+
+void DeviceSimulator::set_sample_interval(std::chrono::milliseconds interval) {
+    sample_interval_ = interval;
+}
+
 float DeviceSimulator::generate_temperature() {
     static std::random_device rd;
     static std::mt19937 gen(rd());
@@ -120,34 +130,61 @@ float DeviceSimulator::generate_temperature() {
     return dis(gen);
 }
 
+void DeviceSimulator::write_message(const void* data, size_t size) {
+#ifdef _WIN32
+    DWORD bytes_written;
+    WriteFile(handle_, data, static_cast<DWORD>(size), &bytes_written, NULL);
+#else
+    write(file_descriptor_, data, size);
+#endif
+}
+
 void DeviceSimulator::simulation_loop() {
     std::cout << "Simulation loop started" << std::endl;
     
+    std::vector<DeviceSample> batch;
+    std::vector<unsigned char> frame;
+    
     while (running_) {
         float temperature = generate_temperature();
         
         auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-        
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
-        ss << "." << std::setfill('0') << std::setw(3) << ms.count();
-        
-        std::string message = "TEMP:" + std::to_string(temperature) +
-                             " TIME:" + ss.str() + "\n";
-        
-#ifdef _WIN32
-        DWORD bytes_written;
-        WriteFile(handle_, message.c_str(), message.length(), &bytes_written, NULL);
-#else
-        write(file_descriptor_, message.c_str(), message.length());
-#endif
         
-        std::cout << "Sent: " << message;
+        if (samples_per_frame_ > 0) {
+            // Показания копятся и уходят одним кадром
+            DeviceSample sample;
+            sample.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now.time_since_epoch()).count();
+            sample.temperature = temperature;
+            batch.push_back(sample);
+            
+            if (batch.size() >= samples_per_frame_) {
+                frame.clear();
+                if (encode_device_frame(0, batch.data(), batch.size(), frame)) {
+                    write_message(frame.data(), frame.size());
+                    std::cout << "Sent frame: " << batch.size() << " samples, " << frame.size()
+                              << " bytes" << std::endl;
+                }
+                batch.clear();
+            }
+        } else {
+            auto time_t_now = std::chrono::system_clock::to_time_t(now);
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now.time_since_epoch()) % 1000;
+            
+            std::stringstream ss;
+            ss << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
+            ss << "." << std::setfill('0') << std::setw(3) << ms.count();
+            
+            std::string message = "TEMP:" + std::to_string(temperature) +
+                                 " TIME:" + ss.str() + "\n";
+            
+            write_message(message.c_str(), message.length());
+            
+            std::cout << "Sent: " << message;
+        }
         
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        std::this_thread::sleep_for(sample_interval_);
     }
     
     std::cout << "Simulation loop stopped" << std::endl;
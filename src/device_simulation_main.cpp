@@ -1,28 +1,51 @@
 #include "device_simulation.h"
 #include <iostream>
 #include <string>
+#include <chrono>
 
 int main(int argc, char* argv[]) {
     std::string port_name;
+    size_t samples_per_frame = 0;
+    int interval_ms = 5000;
     
-    if (argc > 1) {
-        port_name = argv[1];
-    } else {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--binary" && i + 1 < argc) {
+            int samples = std::stoi(argv[++i]);
+            if (samples <= 0) {
+                std::cerr << "Invalid samples per frame: " << argv[i] << std::endl;
+                return 1;
+            }
+            samples_per_frame = static_cast<size_t>(samples);
+        } else if (arg == "--interval" && i + 1 < argc) {
+            interval_ms = std::stoi(argv[++i]);
+            if (interval_ms <= 0) {
+                std::cerr << "Invalid sample interval: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            port_name = arg;
+        }
+    }
+    
+    if (port_name.empty()) {
 #ifdef _WIN32
         port_name = "COM3";
         std::cout << "Using default port: COM3" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <port_name>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <port_name> [--binary <samples per frame>] [--interval <ms>]" << std::endl;
         std::cout << "Example: " << argv[0] << " COM3" << std::endl;
 #else
         port_name = "/dev/ttyS0";
         std::cout << "Using default port: /dev/ttyS0" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <port_name>" << std::endl;
-        std::cout << "Example: " << argv[0] << " /dev/ttyUSB0" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <port_name> [--binary <samples per frame>] [--interval <ms>]" << std::endl;
+        std::cout << "Example: " << argv[0] << " /dev/ttyUSB0 --binary 16 --interval 50" << std::endl;
 #endif
     }
     
     DeviceSimulator simulator(port_name, 9600);
     simulator.set_temperature_range(18.0f, 30.0f);
+    simulator.set_binary_frames(samples_per_frame);
+    simulator.set_sample_interval(std::chrono::milliseconds(interval_ms));
     
     if (!simulator.start()) {
         std::cerr << "Failed to start simulator" << std::endl;
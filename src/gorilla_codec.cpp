@@ -0,0 +1,238 @@
+#include "gorilla_codec.h"
+#include <cstring>
+
+namespace {
+
+const size_t HEADER_SIZE = sizeof(uint32_t);
+
+uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int leading_zeros(uint32_t x) {
+#if defined(__GNUC__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+    while (!(x & 0x80000000u)) { x <<= 1; ++n; }
+    return n;
+#endif
+}
+
+int trailing_zeros(uint32_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while (!(x & 1u)) { x >>= 1; ++n; }
+    return n;
+#endif
+}
+
+} // namespace
+
+GorillaEncoder::GorillaEncoder() {
+}
+
+void GorillaEncoder::clear() {
+    stream_.clear();
+    bit_pos_ = 0;
+    count_ = 0;
+    first_timestamp_ = 0;
+    prev_timestamp_ = 0;
+    prev_delta_ = 0;
+    prev_value_ = 0;
+    prev_leading_ = -1;
+    prev_trailing_ = 0;
+}
+
+void GorillaEncoder::write_bits(uint64_t value, int bits) {
+    while (bits > 0) {
+        if (bit_pos_ == 0) {
+            stream_.push_back(0);
+        }
+
+        int free_bits = 8 - bit_pos_;
+        int take = bits < free_bits ? bits : free_bits;
+        uint8_t chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+        stream_.back() |= static_cast<uint8_t>(chunk << (free_bits - take));
+
+        bit_pos_ = (bit_pos_ + take) % 8;
+        bits -= take;
+    }
+}
+
+void GorillaEncoder::append(std::time_t timestamp, float temperature) {
+    uint32_t value = float_bits(temperature);
+
+    if (count_ == 0) {
+        // Первая запись блока хранится целиком
+        write_bits(static_cast<uint64_t>(timestamp), 64);
+        write_bits(value, 32);
+
+        first_timestamp_ = timestamp;
+        prev_timestamp_ = timestamp;
+        prev_value_ = value;
+        count_ = 1;
+        return;
+    }
+
+    // Метка времени: delta-of-delta
+    int64_t delta = static_cast<int64_t>(timestamp - prev_timestamp_);
+    int64_t dod = delta - prev_delta_;
+
+    if (dod == 0) {
+        write_bits(0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        write_bits(0x2, 2);
+        write_bits(static_cast<uint64_t>(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        write_bits(0x6, 3);
+        write_bits(static_cast<uint64_t>(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        write_bits(0xE, 4);
+        write_bits(static_cast<uint64_t>(dod + 2047), 12);
+    } else {
+        write_bits(0xF, 4);
+        write_bits(static_cast<uint64_t>(dod) >> 32, 32);
+        write_bits(static_cast<uint64_t>(dod) & 0xFFFFFFFFu, 32);
+    }
+
+    prev_delta_ = delta;
+    prev_timestamp_ = timestamp;
+
+    // Температура: XOR с предыдущим значением
+    uint32_t x = value ^ prev_value_;
+    if (x == 0) {
+        write_bits(0, 1);
+    } else {
+        int leading = leading_zeros(x);
+        int trailing = trailing_zeros(x);
+
+        if (prev_leading_ >= 0 && leading >= prev_leading_ && trailing >= prev_trailing_) {
+            // Значащие биты помещаются в окно предыдущего значения
+            write_bits(0x2, 2);
+            write_bits(x >> prev_trailing_, 32 - prev_leading_ - prev_trailing_);
+        } else {
+            int length = 32 - leading - trailing;
+            write_bits(0x3, 2);
+            write_bits(static_cast<uint64_t>(leading), 5);
+            write_bits(static_cast<uint64_t>(length - 1), 5);
+            write_bits(x >> trailing, length);
+
+            prev_leading_ = leading;
+            prev_trailing_ = trailing;
+        }
+    }
+
+    prev_value_ = value;
+    ++count_;
+}
+
+size_t GorillaEncoder::size_bytes() const {
+    return HEADER_SIZE + stream_.size();
+}
+
+std::vector<uint8_t> GorillaEncoder::finish() const {
+    std::vector<uint8_t> block(HEADER_SIZE + stream_.size());
+    block[0] = static_cast<uint8_t>(count_);
+    block[1] = static_cast<uint8_t>(count_ >> 8);
+    block[2] = static_cast<uint8_t>(count_ >> 16);
+    block[3] = static_cast<uint8_t>(count_ >> 24);
+    if (!stream_.empty()) {
+        std::memcpy(block.data() + HEADER_SIZE, stream_.data(), stream_.size());
+    }
+    return block;
+}
+
+GorillaDecoder::GorillaDecoder(const uint8_t* data, size_t size)
+    : data_(data), end_(data + size) {
+    if (size < HEADER_SIZE) {
+        data_ = end_;
+        return;
+    }
+
+    count_ = static_cast<uint32_t>(data[0]) |
+             (static_cast<uint32_t>(data[1]) << 8) |
+             (static_cast<uint32_t>(data[2]) << 16) |
+             (static_cast<uint32_t>(data[3]) << 24);
+    data_ += HEADER_SIZE;
+}
+
+void GorillaDecoder::refill() {
+    while (available_ <= 56 && data_ < end_) {
+        window_ = (window_ << 8) | *data_++;
+        available_ += 8;
+    }
+}
+
+uint64_t GorillaDecoder::read_bits(int bits) {
+    if (available_ < bits) {
+        refill();
+        if (available_ < bits) {
+            // Обрезанный блок - дополняем нулями
+            window_ <<= (bits - available_);
+            available_ = bits;
+        }
+    }
+
+    available_ -= bits;
+    return (window_ >> available_) & ((uint64_t(1) << bits) - 1);
+}
+
+bool GorillaDecoder::read_bit() {
+    return read_bits(1) != 0;
+}
+
+bool GorillaDecoder::next(std::time_t& timestamp, float& temperature) {
+    if (decoded_ >= count_) return false;
+
+    if (decoded_ == 0) {
+        uint64_t ts = read_bits(32) << 32;
+        ts |= read_bits(32);
+        prev_timestamp_ = static_cast<std::time_t>(ts);
+        prev_value_ = static_cast<uint32_t>(read_bits(32));
+    } else {
+        int64_t dod;
+        if (!read_bit()) {
+            dod = 0;
+        } else if (!read_bit()) {
+            dod = static_cast<int64_t>(read_bits(7)) - 63;
+        } else if (!read_bit()) {
+            dod = static_cast<int64_t>(read_bits(9)) - 255;
+        } else if (!read_bit()) {
+            dod = static_cast<int64_t>(read_bits(12)) - 2047;
+        } else {
+            uint64_t raw = read_bits(32) << 32;
+            raw |= read_bits(32);
+            dod = static_cast<int64_t>(raw);
+        }
+
+        prev_delta_ += dod;
+        prev_timestamp_ += static_cast<std::time_t>(prev_delta_);
+
+        if (read_bit()) {
+            if (read_bit()) {
+                prev_leading_ = static_cast<int>(read_bits(5));
+                int length = static_cast<int>(read_bits(5)) + 1;
+                prev_trailing_ = 32 - prev_leading_ - length;
+            }
+            int length = 32 - prev_leading_ - prev_trailing_;
+            uint32_t x = static_cast<uint32_t>(read_bits(length)) << prev_trailing_;
+            prev_value_ ^= x;
+        }
+    }
+
+    ++decoded_;
+    timestamp = prev_timestamp_;
+    temperature = bits_float(prev_value_);
+    return true;
+}
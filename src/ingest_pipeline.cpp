@@ -0,0 +1,418 @@
+#include "ingest_pipeline.h"
+#include "device_frame.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+static_assert(MAX_FRAME_SIZE <= IngestPipeline::MAX_RAW_MESSAGE, "raw slot must hold any frame");
+
+namespace {
+
+std::atomic<uint64_t> next_pipeline_id{1};
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Целые секунды с округлением вниз
+std::time_t to_seconds(int64_t ms) {
+    int64_t rem = ms % 1000;
+    return static_cast<std::time_t>((ms - rem) / 1000 - (rem < 0 ? 1 : 0));
+}
+
+void raise_high_water(std::atomic<size_t>& high_water, size_t depth) {
+    size_t seen = high_water.load(std::memory_order_relaxed);
+    while (depth > seen && !high_water.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+    }
+}
+
+// Будит спящую стадию. Барьер не даёт прочитать флаг раньше, чем станет
+// видна опубликованная запись, а мьютекс - разбудить до начала ожидания.
+void wake(std::atomic<bool>& sleeping, std::mutex& mutex, std::condition_variable& cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cv.notify_one();
+    }
+}
+
+} // namespace
+
+IngestPipeline::IngestPipeline(const IngestOptions& options)
+    : options_(options),
+      id_(next_pipeline_id.fetch_add(1)),
+      samples_(options.sample_capacity) {
+}
+
+IngestPipeline::~IngestPipeline() {
+    stop();
+}
+
+void IngestPipeline::set_sink(BatchSink sink) {
+    sink_ = sink;
+}
+
+bool IngestPipeline::start() {
+    if (started_) return true;
+    if (options_.raw_overflow == OverflowPolicy::Spill) {
+        std::cerr << "Spill overflow policy is not supported for reader threads" << std::endl;
+        return false;
+    }
+
+    started_ = true;
+    stopping_ = false;
+    parser_done_ = false;
+    running_ = true;
+    parser_thread_ = std::thread(&IngestPipeline::parser_loop, this);
+    writer_thread_ = std::thread(&IngestPipeline::writer_loop, this);
+    return true;
+}
+
+void IngestPipeline::stop() {
+    if (!started_) return;
+
+    // Новые сообщения не принимаются; принятые дописываются
+    running_ = false;
+    stopping_ = true;
+    {
+        std::lock_guard<std::mutex> lock(parser_mutex_);
+        parser_cv_.notify_one();
+    }
+    if (parser_thread_.joinable()) {
+        parser_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_cv_.notify_one();
+    }
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    started_ = false;
+}
+
+bool IngestPipeline::push_line(const std::string& sensor_id, std::string_view line) {
+    return push_raw(sensor_id, line, false);
+}
+
+bool IngestPipeline::push_frame(const std::string& sensor_id, std::string_view frame) {
+    return push_raw(sensor_id, frame, true);
+}
+
+IngestPipeline::Producer* IngestPipeline::current_producer() {
+    // Последний конвейер, в который писал этот поток
+    thread_local uint64_t cached_id = 0;
+    thread_local Producer* cached = nullptr;
+    if (cached_id == id_) return cached;
+
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    std::thread::id self = std::this_thread::get_id();
+    size_t count = producer_count_.load(std::memory_order_relaxed);
+    Producer* producer = nullptr;
+    for (size_t i = 0; i < count && producer == nullptr; ++i) {
+        if (producers_[i]->thread == self) producer = producers_[i].get();
+    }
+    if (producer == nullptr) {
+        if (count == MAX_PRODUCERS) return nullptr;
+        producers_[count] = std::make_unique<Producer>(options_.raw_capacity);
+        producers_[count]->thread = self;
+        producer = producers_[count].get();
+        producer_count_.store(count + 1, std::memory_order_release);
+    }
+    cached_id = id_;
+    cached = producer;
+    return producer;
+}
+
+bool IngestPipeline::push_raw(const std::string& sensor_id, std::string_view data, bool frame) {
+    if (!running_.load(std::memory_order_relaxed)) return false;
+
+    Producer* producer = current_producer();
+    if (producer == nullptr) {
+        unregistered_drops_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (data.size() > MAX_RAW_MESSAGE) {
+        producer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    RawMessage* slot = producer->ring.try_claim();
+    if (slot == nullptr && options_.raw_overflow == OverflowPolicy::Block) {
+        while (slot == nullptr && running_.load(std::memory_order_relaxed)) {
+            wake(parser_sleeping_, parser_mutex_, parser_cv_);
+            std::this_thread::yield();
+            slot = producer->ring.try_claim();
+        }
+    }
+    if (slot == nullptr) {
+        producer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Копируется только сама строка или кадр, а не весь слот
+    slot->sensor_id = &sensor_id;
+    slot->received_ms = now_ms();
+    slot->size = static_cast<uint16_t>(data.size());
+    slot->frame = frame;
+    std::memcpy(slot->data, data.data(), data.size());
+    producer->ring.publish();
+
+    producer->accepted.fetch_add(1, std::memory_order_relaxed);
+    raise_high_water(producer->high_water, producer->ring.size());
+    wake(parser_sleeping_, parser_mutex_, parser_cv_);
+    return true;
+}
+
+bool IngestPipeline::raw_empty() const {
+    size_t count = producer_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (!producers_[i]->ring.empty()) return false;
+    }
+    return true;
+}
+
+void IngestPipeline::parser_loop() {
+    for (;;) {
+        // По кругу по кольцам, не больше max_batch сообщений из каждого за проход
+        size_t handled = 0;
+        size_t count = producer_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            SpscRing<RawMessage>& ring = producers_[i]->ring;
+            for (size_t n = 0; n < options_.max_batch; ++n) {
+                const RawMessage* message = ring.front();
+                if (message == nullptr) break;
+                handle_message(*message);
+                ring.pop();
+                ++handled;
+            }
+        }
+        raw_processed_.fetch_add(handled, std::memory_order_relaxed);
+
+        bool spill_empty = drain_spill();
+        if (handled > 0) continue;
+        if (stopping_.load() && spill_empty && raw_empty()) break;
+
+        std::unique_lock<std::mutex> lock(parser_mutex_);
+        parser_sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (raw_empty() && !stopping_.load()) {
+            // Пока есть запас, поток записи опрашивается чаще
+            parser_cv_.wait_for(lock, std::chrono::milliseconds(spill_empty ? IDLE_WAIT_MS : SPILL_RETRY_MS));
+        } else if (!spill_empty) {
+            parser_cv_.wait_for(lock, std::chrono::milliseconds(SPILL_RETRY_MS));
+        }
+        parser_sleeping_.store(false);
+    }
+
+    parser_done_ = true;
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    writer_cv_.notify_one();
+}
+
+void IngestPipeline::handle_message(const RawMessage& message) {
+    const int64_t max_skew_ms = options_.max_clock_skew_seconds * 1000;
+
+    if (message.frame) {
+        DeviceFrame frame;
+        size_t consumed = 0;
+        if (decode_device_frame(reinterpret_cast<const unsigned char*>(message.data), message.size,
+                                frame, consumed) != FrameStatus::Ok) {
+            parse_errors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Каналы многоканального устройства различаются суффиксом
+        const std::string* sensor_id = message.sensor_id;
+        if (frame.channel != 0) {
+            auto key = std::make_pair(message.sensor_id, frame.channel);
+            auto it = channel_names_.find(key);
+            if (it == channel_names_.end()) {
+                it = channel_names_.emplace(key, *message.sensor_id + "/" + std::to_string(frame.channel)).first;
+            }
+            sensor_id = &it->second;
+        }
+
+        // При сбитых часах устройства весь кадр сдвигается ко времени приёма,
+        // интервалы между показаниями сохраняются
+        int64_t shift_ms = 0;
+        int64_t last_ms = frame.samples[frame.count - 1].timestamp_ms;
+        if (std::llabs(static_cast<long long>(last_ms - message.received_ms)) > max_skew_ms) {
+            std::cerr << "Device clock of " << *sensor_id << " is off by "
+                      << (last_ms - message.received_ms) / 1000 << " s, using server time" << std::endl;
+            shift_ms = message.received_ms - last_ms;
+            clock_corrections_.fetch_add(frame.count, std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < frame.count; ++i) {
+            const DeviceSample& sample = frame.samples[i];
+            if (sample.temperature < DeviceLineParser::MIN_TEMPERATURE ||
+                sample.temperature > DeviceLineParser::MAX_TEMPERATURE) {
+                parse_errors_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // Хранилище посекундное: миллисекунды кадра дальше не идут
+            emit_sample(sensor_id, to_seconds(sample.timestamp_ms + shift_ms), sample.temperature);
+        }
+        return;
+    }
+
+    // Строки без TEMP: (служебные сообщения устройства) пропускаем молча
+    std::string_view line(message.data, message.size);
+    if (line.substr(0, 5) != "TEMP:") return;
+
+    DeviceReading reading;
+    if (!line_parser_.parse(line, reading)) {
+        std::cerr << "Failed to parse temperature from: " << line << std::endl;
+        parse_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Время берётся с устройства; без поля TIME или при сбитых часах - время приёма
+    int64_t timestamp_ms = reading.has_time ? reading.timestamp_ms : message.received_ms;
+    if (reading.has_time && std::llabs(static_cast<long long>(timestamp_ms - message.received_ms)) > max_skew_ms) {
+        std::cerr << "Device clock of " << *message.sensor_id << " is off by "
+                  << (timestamp_ms - message.received_ms) / 1000 << " s, using server time" << std::endl;
+        timestamp_ms = message.received_ms;
+        clock_corrections_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Как и у кадров, миллисекунды отбрасываются только здесь
+    emit_sample(message.sensor_id, to_seconds(timestamp_ms), reading.temperature);
+}
+
+void IngestPipeline::emit_sample(const std::string* sensor_id, std::time_t timestamp, float temperature) {
+    IngestSample sample;
+    sample.sensor_id = sensor_id;
+    sample.timestamp = timestamp;
+    sample.temperature = temperature;
+
+    // Запас опустошается первым, чтобы не нарушить порядок показаний
+    if (drain_spill() && samples_.try_push(sample)) {
+        samples_accepted_.fetch_add(1, std::memory_order_relaxed);
+        raise_high_water(samples_high_water_, samples_.size());
+        wake(writer_sleeping_, writer_mutex_, writer_cv_);
+        return;
+    }
+
+    switch (options_.sample_overflow) {
+        case OverflowPolicy::Block:
+            while (!samples_.try_push(sample)) {
+                wake(writer_sleeping_, writer_mutex_, writer_cv_);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            samples_accepted_.fetch_add(1, std::memory_order_relaxed);
+            raise_high_water(samples_high_water_, samples_.size());
+            wake(writer_sleeping_, writer_mutex_, writer_cv_);
+            return;
+        case OverflowPolicy::Spill:
+            if (spill_.size() < options_.spill_limit) {
+                spill_.push_back(sample);
+                spilled_.store(spill_.size(), std::memory_order_relaxed);
+                samples_accepted_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            break;
+        case OverflowPolicy::DropNewest:
+            break;
+    }
+    samples_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool IngestPipeline::drain_spill() {
+    if (spill_.empty()) return true;
+
+    size_t moved = 0;
+    while (!spill_.empty() && samples_.try_push(spill_.front())) {
+        spill_.pop_front();
+        ++moved;
+    }
+    spilled_.store(spill_.size(), std::memory_order_relaxed);
+    if (moved > 0) {
+        raise_high_water(samples_high_water_, samples_.size());
+        wake(writer_sleeping_, writer_mutex_, writer_cv_);
+    }
+    return spill_.empty();
+}
+
+void IngestPipeline::writer_loop() {
+    std::vector<IngestSample> batch;
+    batch.reserve(options_.max_batch);
+
+    for (;;) {
+        IngestSample sample;
+        while (batch.size() < options_.max_batch && samples_.try_pop(sample)) {
+            batch.push_back(sample);
+        }
+        if (!batch.empty()) {
+            samples_processed_.fetch_add(batch.size(), std::memory_order_relaxed);
+            // Часы датчиков расходятся: без сортировки время в пачке скакало бы
+            // назад и вперёд. Устойчивая - порядок показаний датчика не меняется
+            std::stable_sort(batch.begin(), batch.end(), [](const IngestSample& a, const IngestSample& b) {
+                return a.timestamp < b.timestamp;
+            });
+            write_batch(batch);
+            continue;
+        }
+
+        // Разборщик закончил и всё передал
+        if (parser_done_.load() && samples_.empty()) break;
+
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (samples_.empty() && !parser_done_.load()) {
+            writer_cv_.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+        }
+        writer_sleeping_.store(false);
+    }
+}
+
+void IngestPipeline::write_batch(std::vector<IngestSample>& batch) {
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    for (;;) {
+        size_t stored = sink_ ? std::min(sink_(batch), batch.size()) : batch.size();
+        batch.erase(batch.begin(), batch.begin() + static_cast<std::ptrdiff_t>(stored));
+        if (batch.empty()) return;
+
+        // После остановки повторять некому: остаток теряется, но учитывается
+        if (stopping_.load()) {
+            std::cerr << "Failed to store " << batch.size() << " measurements on shutdown" << std::endl;
+            samples_dropped_.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+            return;
+        }
+
+        write_retries_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(RETRY_MS), [this]() { return stopping_.load(); });
+    }
+}
+
+IngestStats IngestPipeline::stats() const {
+    IngestStats stats;
+    size_t count = producer_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const Producer& producer = *producers_[i];
+        stats.raw.accepted += producer.accepted.load(std::memory_order_relaxed);
+        stats.raw.dropped += producer.dropped.load(std::memory_order_relaxed);
+        stats.raw.queued += producer.ring.size();
+        stats.raw.high_water = std::max(stats.raw.high_water, producer.high_water.load(std::memory_order_relaxed));
+    }
+    stats.raw.dropped += unregistered_drops_.load(std::memory_order_relaxed);
+    stats.raw.processed = raw_processed_.load(std::memory_order_relaxed);
+
+    stats.samples.accepted = samples_accepted_.load(std::memory_order_relaxed);
+    stats.samples.processed = samples_processed_.load(std::memory_order_relaxed);
+    stats.samples.dropped = samples_dropped_.load(std::memory_order_relaxed);
+    stats.samples.queued = samples_.size() + spilled_.load(std::memory_order_relaxed);
+    stats.samples.high_water = samples_high_water_.load(std::memory_order_relaxed);
+
+    stats.parse_errors = parse_errors_.load(std::memory_order_relaxed);
+    stats.clock_corrections = clock_corrections_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.write_retries = write_retries_.load(std::memory_order_relaxed);
+    return stats;
+}
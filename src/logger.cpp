@@ -1,168 +1,416 @@
 #include "logger.h"
+#include "binary_log.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <filesystem>
+#include <chrono>
+
+namespace {
+
+void write_measurement(std::ostream& out, const TemperatureRecord& record) {
+    std::tm* tm = std::localtime(&record.timestamp);
+    out << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << " "
+        << record.temperature << '\n';
+}
+
+void write_hourly_average(std::ostream& out, const TemperatureRecord& record) {
+    std::tm* tm = std::localtime(&record.timestamp);
+    out << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << " "
+        << "HOURLY_AVG " << record.temperature << '\n';
+}
+
+void write_daily_average(std::ostream& out, const TemperatureRecord& record) {
+    std::tm* tm = std::localtime(&record.timestamp);
+    out << std::put_time(tm, "%Y-%m-%d") << " "
+        << "DAILY_AVG " << record.temperature << '\n';
+}
+
+const char* segment_extension(LogFormat format) {
+    return format == LogFormat::BINARY ? ".bin" : ".log";
+}
+
+size_t segment_record_size(LogFormat format) {
+    return format == LogFormat::BINARY ? BINARY_LOG_RECORD_SIZE : 0;
+}
+
+// Границы часа и суток по местному времени; mktime учитывает переход
+// на летнее время, поэтому сутки могут длиться 23 или 25 часов
+void local_hour_bounds(std::time_t timestamp, std::time_t& start, std::time_t& end) {
+    std::tm tm = *std::localtime(&timestamp);
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    start = std::mktime(&tm);
+    if (start > timestamp) start -= 3600;
+    end = start + 3600;
+}
+
+void local_day_bounds(std::time_t timestamp, std::time_t& start, std::time_t& end) {
+    std::tm tm = *std::localtime(&timestamp);
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    start = std::mktime(&tm);
+    tm.tm_mday += 1;
+    tm.tm_isdst = -1;
+    end = std::mktime(&tm);
+}
+
+// Читает сегменты бинарного журнала подряд, выделив память под все записи сразу
+void load_binary_segments(const std::vector<std::string>& paths, std::vector<TemperatureRecord>& out) {
+    size_t count = 0;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (!ec) count += static_cast<size_t>(size / BINARY_LOG_RECORD_SIZE);
+    }
+    out.reserve(out.size() + count);
+    
+    for (const auto& path : paths) {
+        load_binary_log(path, out);
+    }
+}
+
+void sort_by_time(std::vector<TemperatureRecord>& records) {
+    auto earlier = [](const TemperatureRecord& a, const TemperatureRecord& b) {
+        return a.timestamp < b.timestamp;
+    };
+    if (!std::is_sorted(records.begin(), records.end(), earlier)) {
+        std::stable_sort(records.begin(), records.end(), earlier);
+    }
+}
+
+} // namespace
+
+LogFormat Logger::configured_format_ = LogFormat::TEXT;
 
 Logger& Logger::get_instance() {
     static Logger instance;
     return instance;
 }
 
-Logger::Logger() {
-    load_measurements_from_file();
-    load_hourly_averages_from_file();
-    load_daily_averages_from_file();
+void Logger::set_format(LogFormat format) {
+    configured_format_ = format;
+}
+
+Logger::Logger()
+    : format_(configured_format_),
+      measurements_log_(LOG_DIR, "measurements", SegmentSpan::HOUR, MEASUREMENTS_RETENTION_SECONDS,
+                        segment_extension(format_), segment_record_size(format_)),
+      hourly_log_(LOG_DIR, "hourly", SegmentSpan::MONTH, HOURLY_RETENTION_SECONDS,
+                  segment_extension(format_), segment_record_size(format_)),
+      daily_log_(LOG_DIR, "daily", SegmentSpan::YEAR, DAILY_RETENTION_SECONDS,
+                 segment_extension(format_), segment_record_size(format_)) {
+    measurements_log_.open();
+    hourly_log_.open();
+    daily_log_.open();
+    
+    std::vector<TemperatureRecord> measurements;
+    load_segments(measurements);
+    migrate_legacy_files(measurements);
+    if (format_ == LogFormat::BINARY) {
+        convert_text_segments(measurements);
+    }
+    
+    // Перенесённые записи могли оказаться после более свежих
+    sort_by_time(measurements);
+    
+    // Продолжаем незакрытые час и сутки; их средние уже не записывались
+    for (const auto& record : measurements) {
+        update_windows(record, false);
+    }
+    
     last_cleanup_ = std::time(nullptr);
+    last_flush_ = last_cleanup_;
+    remove_old_data();
+    
+    flusher_thread_ = std::thread(&Logger::flusher_loop, this);
 }
 
 Logger::~Logger() {
-    save_measurements_to_file();
-    save_hourly_averages_to_file();
-    save_daily_averages_to_file();
+    // Поток разбирает очередь до конца и только потом завершается
+    stopping_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+    if (flusher_thread_.joinable()) {
+        flusher_thread_.join();
+    }
 }
 
-void Logger::log_measurement(std::time_t timestamp, float temperature) {
-    std::lock_guard<std::mutex> lock(measurements_mutex_);
-    measurements_.emplace_back(timestamp, temperature);
+void Logger::enqueue(const LogRecord& record) {
+    // Диск здесь не трогаем; при переполнении ждём, пока поток освободит место
+    while (!queue_.try_push(record)) {
+        std::this_thread::yield();
+    }
+    enqueued_.fetch_add(1, std::memory_order_release);
     
-    // Сохраняем в файл каждые 10 записей
-    if (measurements_.size() % 10 == 0) {
-        save_measurements_to_file();
+    // Поток мог проверить очередь, но ещё не уснуть: под мьютексом сигнал
+    // дойдёт либо после засыпания, либо до проверки
+    if (flusher_sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
     }
+}
+
+void Logger::flush() {
+    uint64_t target = enqueued_.load(std::memory_order_acquire);
     
-    // Проверяем необходимость вычисления средних
-    std::time_t now = std::time(nullptr);
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (flushed_.load() < target && flusher_thread_.joinable()) {
+        flush_requested_.store(true);
+        wake_cv_.notify_one();
+        flushed_cv_.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+    }
+}
+
+void Logger::log_measurement(std::time_t timestamp, float temperature) {
+    enqueue({timestamp, temperature, LogRecord::MEASUREMENT});
+}
+
+void Logger::log_hourly_average(std::time_t timestamp, float average_temp) {
+    enqueue({timestamp, average_temp, LogRecord::HOURLY_AVERAGE});
+}
+
+void Logger::log_daily_average(std::time_t timestamp, float average_temp) {
+    enqueue({timestamp, average_temp, LogRecord::DAILY_AVERAGE});
+}
+
+void Logger::cleanup_old_data() {
+    enqueue({std::time(nullptr), 0.0f, LogRecord::CLEANUP});
+}
+
+void Logger::flusher_loop() {
+    std::vector<LogRecord> batch;
+    batch.reserve(MAX_BATCH);
     
-    // Ежечасное среднее
-    if (last_hourly_save_ == 0 || (now - last_hourly_save_) >= 3600) {
-        // Вычисляем среднее за последний час
-        float sum = 0;
-        int count = 0;
-        for (const auto& record : measurements_) {
-            if (now - record.timestamp <= 3600) {
-                sum += record.temperature;
-                count++;
-            }
+    while (true) {
+        batch.clear();
+        LogRecord record;
+        while (batch.size() < MAX_BATCH && queue_.try_pop(record)) {
+            batch.push_back(record);
         }
         
-        if (count > 0) {
-            log_hourly_average(now, sum / count);
+        for (const auto& item : batch) {
+            process(item);
         }
-        last_hourly_save_ = now;
-    }
-    
-    // Ежедневное среднее
-    if (last_daily_save_ == 0 || (now - last_daily_save_) >= 86400) {
-        // Вычисляем среднее за последние 24 часа
-        float sum = 0;
-        int count = 0;
-        for (const auto& record : measurements_) {
-            if (now - record.timestamp <= 86400) {
-                sum += record.temperature;
-                count++;
-            }
+        processed_ += batch.size();
+        
+        std::time_t now = std::time(nullptr);
+        if (flush_requested_.exchange(false) || now - last_flush_ >= FLUSH_INTERVAL_SECONDS) {
+            flush_streams();
+            last_flush_ = now;
         }
         
-        if (count > 0) {
-            log_daily_average(now, sum / count);
+        if (!batch.empty()) continue;
+        
+        // Очередь пуста: при остановке всё уже записано
+        if (stopping_.load()) {
+            flush_streams();
+            break;
         }
-        last_daily_save_ = now;
+        
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flusher_sleeping_.store(true);
+        if (queue_.empty() && !stopping_.load() && !flush_requested_.load()) {
+            wake_cv_.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+        }
+        flusher_sleeping_.store(false);
+    }
+}
+
+void Logger::flush_streams() {
+    measurements_log_.flush();
+    hourly_log_.flush();
+    daily_log_.flush();
+    
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    flushed_.store(processed_);
+    flushed_cv_.notify_all();
+}
+
+void Logger::process(const LogRecord& record) {
+    switch (record.kind) {
+        case LogRecord::MEASUREMENT:
+            process_measurement(record.timestamp, record.value);
+            break;
+        case LogRecord::HOURLY_AVERAGE:
+            append_hourly_average(record.timestamp, record.value);
+            break;
+        case LogRecord::DAILY_AVERAGE:
+            append_daily_average(record.timestamp, record.value);
+            break;
+        case LogRecord::CLEANUP:
+            remove_old_data();
+            last_cleanup_ = record.timestamp;
+            break;
     }
+}
+
+void Logger::process_measurement(std::time_t timestamp, float temperature) {
+    TemperatureRecord record(timestamp, temperature);
+    
+    // Дописываем одну строку в буфер текущего сегмента
+    write_record(measurements_log_, record, write_measurement);
+    
+    update_windows(record, true);
     
     // Очистка старых данных
+    std::time_t now = std::time(nullptr);
     if (now - last_cleanup_ >= 300) { // Каждые 5 минут
-        cleanup_old_data();
+        remove_old_data();
         last_cleanup_ = now;
     }
 }
 
-void Logger::log_hourly_average(std::time_t timestamp, float average_temp) {
-    std::lock_guard<std::mutex> lock(hourly_mutex_);
-    hourly_averages_.emplace_back(timestamp, average_temp);
-    save_hourly_averages_to_file();
+void Logger::update_windows(const TemperatureRecord& record, bool emit) {
+    // Измерение из следующего часа закрывает текущий
+    if (record.timestamp >= hour_window_.end) {
+        if (emit && hour_window_.count > 0) {
+            append_hourly_average(hour_window_.start,
+                                  static_cast<float>(hour_window_.sum / hour_window_.count));
+        }
+        local_hour_bounds(record.timestamp, hour_window_.start, hour_window_.end);
+        hour_window_.sum = 0.0;
+        hour_window_.count = 0;
+    }
+    
+    // Опоздавшие измерения из уже закрытых окон в средние не попадают
+    if (record.timestamp >= hour_window_.start) {
+        hour_window_.sum += record.temperature;
+        ++hour_window_.count;
+    }
+    
+    if (record.timestamp >= day_window_.end) {
+        if (emit && day_window_.count > 0) {
+            append_daily_average(day_window_.start,
+                                 static_cast<float>(day_window_.sum / day_window_.count));
+        }
+        local_day_bounds(record.timestamp, day_window_.start, day_window_.end);
+        day_window_.sum = 0.0;
+        day_window_.count = 0;
+    }
+    
+    if (record.timestamp >= day_window_.start) {
+        day_window_.sum += record.temperature;
+        ++day_window_.count;
+    }
 }
 
-void Logger::log_daily_average(std::time_t timestamp, float average_temp) {
-    std::lock_guard<std::mutex> lock(daily_mutex_);
-    daily_averages_.emplace_back(timestamp, average_temp);
-    save_daily_averages_to_file();
+void Logger::append_hourly_average(std::time_t timestamp, float average_temp) {
+    write_record(hourly_log_, TemperatureRecord(timestamp, average_temp), write_hourly_average);
+    hourly_log_.flush();
 }
 
-void Logger::cleanup_old_data() {
+void Logger::append_daily_average(std::time_t timestamp, float average_temp) {
+    write_record(daily_log_, TemperatureRecord(timestamp, average_temp), write_daily_average);
+    daily_log_.flush();
+}
+
+void Logger::remove_old_data() {
+    // Устаревшие записи удаляются целыми сегментами
     std::time_t now = std::time(nullptr);
+    measurements_log_.remove_expired(now);
+    hourly_log_.remove_expired(now);
+    daily_log_.remove_expired(now);
+}
+
+void Logger::write_record(SegmentedLog& log, const TemperatureRecord& record, TextWriter text_writer) {
+    std::ostream* out = log.stream_for(record.timestamp);
+    if (!out) return;
     
-    // Очистка измерений старше 24 часов
-    {
-        std::lock_guard<std::mutex> lock(measurements_mutex_);
-        auto it = std::remove_if(measurements_.begin(), measurements_.end(),
-            [now](const TemperatureRecord& record) {
-                return (now - record.timestamp) > 86400; // 24 часа
-            });
-        measurements_.erase(it, measurements_.end());
-        save_measurements_to_file();
-    }
-    
-    // Очистка средних за час старше 30 дней
-    {
-        std::lock_guard<std::mutex> lock(hourly_mutex_);
-        auto it = std::remove_if(hourly_averages_.begin(), hourly_averages_.end(),
-            [now](const TemperatureRecord& record) {
-                return (now - record.timestamp) > 2592000; // 30 дней
-            });
-        hourly_averages_.erase(it, hourly_averages_.end());
-        save_hourly_averages_to_file();
+    if (format_ == LogFormat::BINARY) {
+        write_binary_record(*out, record.timestamp, record.temperature);
+    } else {
+        text_writer(*out, record);
     }
-    
-    // Очистка средних за день старше 365 дней
-    {
-        std::lock_guard<std::mutex> lock(daily_mutex_);
-        auto it = std::remove_if(daily_averages_.begin(), daily_averages_.end(),
-            [now](const TemperatureRecord& record) {
-                return (now - record.timestamp) > 31536000; // 365 дней
-            });
-        daily_averages_.erase(it, daily_averages_.end());
-        save_daily_averages_to_file();
+}
+
+void Logger::append_records(const std::vector<TemperatureRecord>& records,
+                            SegmentedLog& log, TextWriter text_writer) {
+    for (const auto& record : records) {
+        write_record(log, record, text_writer);
     }
+    log.flush();
 }
 
-void Logger::save_measurements_to_file() {
-    std::ofstream file(measurements_file_, std::ios::trunc);
-    if (!file.is_open()) return;
+void Logger::load_segments(std::vector<TemperatureRecord>& measurements) {
+    if (format_ == LogFormat::BINARY) {
+        load_binary_segments(measurements_log_.segment_paths(), measurements);
+        return;
+    }
     
-    for (const auto& record : measurements_) {
-        std::tm* tm = std::localtime(&record.timestamp);
-        file << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << " "
-             << record.temperature << std::endl;
+    for (const auto& path : measurements_log_.segment_paths()) {
+        load_measurements_from_file(path, measurements);
     }
 }
 
-void Logger::save_hourly_averages_to_file() {
-    std::ofstream file(hourly_file_, std::ios::trunc);
-    if (!file.is_open()) return;
+void Logger::migrate_legacy_files(std::vector<TemperatureRecord>& measurements) {
+    std::vector<TemperatureRecord> records;
+    
+    if (std::filesystem::exists(legacy_measurements_file_)) {
+        load_measurements_from_file(legacy_measurements_file_, records);
+        append_records(records, measurements_log_, write_measurement);
+        measurements.insert(measurements.end(), records.begin(), records.end());
+        std::filesystem::remove(legacy_measurements_file_);
+        records.clear();
+    }
     
-    for (const auto& record : hourly_averages_) {
-        std::tm* tm = std::localtime(&record.timestamp);
-        file << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << " "
-             << "HOURLY_AVG " << record.temperature << std::endl;
+    if (std::filesystem::exists(legacy_hourly_file_)) {
+        load_hourly_averages_from_file(legacy_hourly_file_, records);
+        append_records(records, hourly_log_, write_hourly_average);
+        std::filesystem::remove(legacy_hourly_file_);
+        records.clear();
+    }
+    
+    if (std::filesystem::exists(legacy_daily_file_)) {
+        load_daily_averages_from_file(legacy_daily_file_, records);
+        append_records(records, daily_log_, write_daily_average);
+        std::filesystem::remove(legacy_daily_file_);
     }
 }
 
-void Logger::save_daily_averages_to_file() {
-    std::ofstream file(daily_file_, std::ios::trunc);
-    if (!file.is_open()) return;
+void Logger::convert_text_segments(std::vector<TemperatureRecord>& measurements) {
+    std::vector<TemperatureRecord> records;
     
-    for (const auto& record : daily_averages_) {
-        std::tm* tm = std::localtime(&record.timestamp);
-        file << std::put_time(tm, "%Y-%m-%d") << " "
-             << "DAILY_AVG " << record.temperature << std::endl;
+    SegmentedLog text_measurements(LOG_DIR, "measurements", SegmentSpan::HOUR, MEASUREMENTS_RETENTION_SECONDS);
+    if (text_measurements.open()) {
+        for (const auto& path : text_measurements.segment_paths()) {
+            load_measurements_from_file(path, records);
+        }
+        append_records(records, measurements_log_, write_measurement);
+        measurements.insert(measurements.end(), records.begin(), records.end());
+        text_measurements.remove_all();
+        records.clear();
+    }
+    
+    SegmentedLog text_hourly(LOG_DIR, "hourly", SegmentSpan::MONTH, HOURLY_RETENTION_SECONDS);
+    if (text_hourly.open()) {
+        for (const auto& path : text_hourly.segment_paths()) {
+            load_hourly_averages_from_file(path, records);
+        }
+        append_records(records, hourly_log_, write_hourly_average);
+        text_hourly.remove_all();
+        records.clear();
+    }
+    
+    SegmentedLog text_daily(LOG_DIR, "daily", SegmentSpan::YEAR, DAILY_RETENTION_SECONDS);
+    if (text_daily.open()) {
+        for (const auto& path : text_daily.segment_paths()) {
+            load_daily_averages_from_file(path, records);
+        }
+        append_records(records, daily_log_, write_daily_average);
+        text_daily.remove_all();
     }
 }
 
-void Logger::load_measurements_from_file() {
-    std::ifstream file(measurements_file_);
+void Logger::load_measurements_from_file(const std::string& path, std::vector<TemperatureRecord>& out) {
+    std::ifstream file(path);
     if (!file.is_open()) return;
     
     std::string line;
@@ -172,14 +420,16 @@ void Logger::load_measurements_from_file() {
         float temp;
         
         if (iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S") >> temp) {
+            // Строки записаны в местном времени; летнее время определяет mktime
+            tm.tm_isdst = -1;
             std::time_t timestamp = std::mktime(&tm);
-            measurements_.emplace_back(timestamp, temp);
+            out.emplace_back(timestamp, temp);
         }
     }
 }
 
-void Logger::load_hourly_averages_from_file() {
-    std::ifstream file(hourly_file_);
+void Logger::load_hourly_averages_from_file(const std::string& path, std::vector<TemperatureRecord>& out) {
+    std::ifstream file(path);
     if (!file.is_open()) return;
     
     std::string line;
@@ -191,15 +441,16 @@ void Logger::load_hourly_averages_from_file() {
         
         if (iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S") >> type >> temp) {
             if (type == "HOURLY_AVG") {
+                tm.tm_isdst = -1;
                 std::time_t timestamp = std::mktime(&tm);
-                hourly_averages_.emplace_back(timestamp, temp);
+                out.emplace_back(timestamp, temp);
             }
         }
     }
 }
 
-void Logger::load_daily_averages_from_file() {
-    std::ifstream file(daily_file_);
+void Logger::load_daily_averages_from_file(const std::string& path, std::vector<TemperatureRecord>& out) {
+    std::ifstream file(path);
     if (!file.is_open()) return;
     
     std::string line;
@@ -214,8 +465,9 @@ void Logger::load_daily_averages_from_file() {
                 tm.tm_hour = 12;
                 tm.tm_min = 0;
                 tm.tm_sec = 0;
+                tm.tm_isdst = -1;
                 std::time_t timestamp = std::mktime(&tm);
-                daily_averages_.emplace_back(timestamp, temp);
+                out.emplace_back(timestamp, temp);
             }
         }
     }
@@ -1,4 +1,7 @@
 #include "temperature_server.h"
+#include "database_manager.h"
+#include "thread_pool.h"
+#include "device_manager.h"
 #include <iostream>
 #include <csignal>
 #include <atomic>
@@ -20,43 +23,98 @@ int main(int argc, char* argv[]) {
 #endif
     
     std::string port_name;
+    std::vector<DeviceConfig> devices;
+    size_t device_threads = 1;
     int http_port = 8080;
+    int udp_port = -1;
+    int tcp_port = -1;
+    std::string admin_token;
     
     // Парсим аргументы командной строки
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--port" && i + 1 < argc) {
             port_name = argv[++i];
+        } else if (arg == "--devices" && i + 1 < argc) {
+            if (!DeviceManager::load_config(argv[++i], devices)) {
+                return 1;
+            }
+        } else if (arg == "--device-threads" && i + 1 < argc) {
+            int threads = std::stoi(argv[++i]);
+            if (threads <= 0) {
+                std::cerr << "Invalid device thread count: " << argv[i] << std::endl;
+                return 1;
+            }
+            device_threads = static_cast<size_t>(threads);
         } else if (arg == "--http-port" && i + 1 < argc) {
             http_port = std::stoi(argv[++i]);
+        } else if ((arg == "--udp-port" || arg == "--tcp-port") && i + 1 < argc) {
+            int port = std::stoi(argv[++i]);
+            if (port < 0 || port > 65535) {
+                std::cerr << "Invalid network port: " << argv[i] << std::endl;
+                return 1;
+            }
+            (arg == "--udp-port" ? udp_port : tcp_port) = port;
+        } else if (arg == "--tiers" && i + 1 < argc) {
+            std::vector<StorageTier> tiers;
+            if (!DatabaseManager::parse_storage_tiers(argv[++i], tiers) ||
+                !DatabaseManager::get_instance().set_storage_tiers(tiers)) {
+                std::cerr << "Invalid storage tiers: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--query-threads" && i + 1 < argc) {
+            int threads = std::stoi(argv[++i]);
+            if (threads < 0) {
+                std::cerr << "Invalid query thread count: " << argv[i] << std::endl;
+                return 1;
+            }
+            ThreadPool::set_shared_size(static_cast<size_t>(threads));
+        } else if (arg == "--admin-token" && i + 1 < argc) {
+            admin_token = argv[++i];
         } else if (arg == "--help") {
             std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
             std::cout << "Options:" << std::endl;
             std::cout << "  --port <name>      Serial port name (e.g., COM3 or /dev/ttyUSB0)" << std::endl;
+            std::cout << "  --devices <file>   Device list: '<path> [baud] [8N1] [sensor-id]' per line" << std::endl;
+            std::cout << "  --device-threads <n> Event threads for all devices (default: 1)" << std::endl;
             std::cout << "  --http-port <num>  HTTP server port (default: 8080)" << std::endl;
+            std::cout << "  --udp-port <num>   Accept '<sensor-id> TEMP:...' datagrams from network sensors" << std::endl;
+            std::cout << "  --tcp-port <num>   Accept '<sensor-id> TEMP:...' lines over TCP" << std::endl;
+            std::cout << "  --tiers <spec>     Storage tiers, e.g. raw:7d,1m:30d,15m:90d,1h:365d,1d:3650d" << std::endl;
+            std::cout << "  --query-threads <n> Threads for large range queries (default: CPU count)" << std::endl;
+            std::cout << "  --admin-token <t>  Enable /api/admin/* for requests with token=<t>" << std::endl;
             std::cout << "  --help             Show this help message" << std::endl;
             return 0;
         }
     }
     
-    // Если порт не указан, спросим пользователя
-    if (port_name.empty()) {
+    bool network = udp_port >= 0 || tcp_port >= 0;
+    
+    // Если не указаны ни порт, ни список устройств, ни сетевой приём, спросим пользователя
+    if (port_name.empty() && devices.empty() && !network) {
         std::cout << "Enter serial port name (or press Enter to skip): ";
         std::getline(std::cin, port_name);
     }
+    if (!port_name.empty()) {
+        DeviceConfig device;
+        device.path = port_name;
+        device.sensor_id = port_name;
+        devices.push_back(device);
+    }
     
     std::cout << "Starting Temperature Monitoring Server v2.0" << std::endl;
     std::cout << "HTTP Server will be available at http://localhost:" << http_port << std::endl;
     
     TemperatureServer server;
+    server.set_admin_token(admin_token);
     
-    if (!server.initialize(port_name, http_port)) {
+    if (!server.initialize(devices, http_port, device_threads, udp_port, tcp_port)) {
         std::cerr << "Failed to initialize server" << std::endl;
         return 1;
     }
     
     // Если мы не подключены к порту, можно генерировать тестовые данные
-    if (port_name.empty()) {
+    if (devices.empty() && !network) {
         std::cout << "No serial port specified. Running in simulation mode." << std::endl;
         std::cout << "Test data will be generated automatically." << std::endl;
     }
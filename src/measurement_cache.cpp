@@ -0,0 +1,119 @@
+#include "measurement_cache.h"
+#include <limits>
+
+namespace {
+
+// Запас слотов на случай, если писатель продвинется во время чтения
+const uint64_t GUARD_SLOTS = 64;
+
+} // namespace
+
+MeasurementCache::MeasurementCache(size_t capacity)
+    : capacity_(capacity < 2 * GUARD_SLOTS ? 2 * GUARD_SLOTS : capacity),
+      timestamps_(new std::atomic<std::time_t>[capacity_]()),
+      temperatures_(new std::atomic<float>[capacity_]()),
+      coverage_start_(std::numeric_limits<std::time_t>::max()) {
+}
+
+void MeasurementCache::push(std::time_t timestamp, float temperature) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+
+    // Запись не по порядку в кэш не попадает: диапазон до неё отдаём хранилищу
+    if (head > 0 && timestamp < last_pushed_) {
+        std::time_t coverage = coverage_start_.load(std::memory_order_relaxed);
+        if (timestamp + 1 > coverage) {
+            coverage_start_.store(timestamp + 1, std::memory_order_release);
+        }
+        return;
+    }
+
+    reserved_.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t slot = head % capacity_;
+    timestamps_[slot].store(timestamp, std::memory_order_relaxed);
+    temperatures_[slot].store(temperature, std::memory_order_relaxed);
+
+    head_.store(head + 1, std::memory_order_release);
+    last_pushed_ = timestamp;
+}
+
+void MeasurementCache::clear() {
+    coverage_start_.store(std::numeric_limits<std::time_t>::max(), std::memory_order_release);
+    head_.store(0, std::memory_order_release);
+    reserved_.store(0, std::memory_order_relaxed);
+    last_pushed_ = 0;
+}
+
+void MeasurementCache::set_coverage_start(std::time_t from) {
+    coverage_start_.store(from, std::memory_order_release);
+}
+
+std::time_t MeasurementCache::timestamp_at(uint64_t index) const {
+    return timestamps_[index % capacity_].load(std::memory_order_relaxed);
+}
+
+bool MeasurementCache::get_last(TemperatureData& out) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (head == 0) return false;
+
+    size_t slot = (head - 1) % capacity_;
+    out.timestamp = timestamps_[slot].load(std::memory_order_relaxed);
+    out.temperature = temperatures_[slot].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t reserved = reserved_.load(std::memory_order_relaxed);
+    return reserved < head + capacity_;
+}
+
+bool MeasurementCache::query(std::time_t from, std::time_t to, int limit,
+                             std::vector<TemperatureData>& out) const {
+    std::time_t coverage = coverage_start_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t lo = head + GUARD_SLOTS > capacity_ ? head + GUARD_SLOTS - capacity_ : 0;
+
+    // Записи упорядочены по времени - ищем границы двоичным поиском
+    uint64_t left = lo, right = head;
+    while (left < right) {
+        uint64_t mid = left + (right - left) / 2;
+        if (timestamp_at(mid) < from) left = mid + 1; else right = mid;
+    }
+    uint64_t lower = left;
+
+    right = head;
+    while (left < right) {
+        uint64_t mid = left + (right - left) / 2;
+        if (timestamp_at(mid) <= to) left = mid + 1; else right = mid;
+    }
+    uint64_t upper = left;
+
+    uint64_t stop = lower;
+    if (limit > 0 && upper - lower > static_cast<uint64_t>(limit)) {
+        stop = upper - limit;
+    }
+
+    std::vector<TemperatureData> rows;
+    rows.reserve(upper - stop);
+    for (uint64_t i = upper; i > stop; --i) {
+        size_t slot = (i - 1) % capacity_;
+        rows.push_back({timestamps_[slot].load(std::memory_order_relaxed),
+                        temperatures_[slot].load(std::memory_order_relaxed)});
+    }
+    std::time_t oldest_cached = lo > 0 ? timestamp_at(lo) : 0;
+
+    // Всё, что прочитано, не должно было перезаписаться
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t reserved = reserved_.load(std::memory_order_relaxed);
+    if (reserved > lo + capacity_) return false;
+
+    if (!rows.empty() && rows.back().timestamp < coverage) return false;
+
+    bool limit_reached = limit > 0 && rows.size() == static_cast<size_t>(limit);
+    if (!limit_reached) {
+        if (from < coverage) return false;
+        if (lo > 0 && oldest_cached >= from) return false;
+    }
+
+    out.swap(rows);
+    return true;
+}
@@ -0,0 +1,355 @@
+#include "network_listener.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace {
+
+constexpr int MAX_EVENTS = 64;
+// Как у DeviceManager: одно «болтливое» соединение не задерживает остальные
+constexpr int READS_PER_EVENT = 8;
+
+// Идентификатор - печатные символы без пробелов. Строка датчика, забывшего
+// идентификатор, начинается с TEMP: - её не принимаем за датчик "TEMP:21.5".
+bool valid_sensor_id(std::string_view sensor_id) {
+    if (sensor_id.empty() || sensor_id.size() > NetworkListener::MAX_SENSOR_ID) return false;
+    if (sensor_id.substr(0, 5) == "TEMP:") return false;
+    for (char c : sensor_id) {
+        if (static_cast<unsigned char>(c) <= 0x20 || c == 0x7F) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+NetworkListener::NetworkListener(int udp_port, int tcp_port, const std::string& bind_address)
+    : requested_udp_port_(udp_port),
+      requested_tcp_port_(tcp_port),
+      bind_address_(bind_address) {
+}
+
+NetworkListener::~NetworkListener() {
+    stop();
+}
+
+void NetworkListener::set_callback(LineCallback callback) {
+    callback_ = callback;
+}
+
+#ifndef _WIN32
+bool NetworkListener::start() {
+    if (started_) return true;
+    started_ = true;
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    stop_event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr; // сигнал остановки
+    if (epoll_fd_ == -1 || stop_event_ == -1 ||
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_event_, &event) != 0) {
+        std::cerr << "Failed to create network event loop: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    if ((requested_udp_port_ >= 0 && !open_udp()) || (requested_tcp_port_ >= 0 && !open_tcp())) {
+        stop();
+        return false;
+    }
+
+    datagram_buffers_.reset(new char[UDP_BATCH * MAX_DATAGRAM]);
+    thread_ = std::thread(&NetworkListener::event_loop, this);
+
+    std::cout << "Network listener started:";
+    if (udp_port_ >= 0) std::cout << " UDP " << udp_port_;
+    if (tcp_port_ >= 0) std::cout << " TCP " << tcp_port_;
+    std::cout << std::endl;
+    return true;
+}
+
+void NetworkListener::stop() {
+    if (!started_) return;
+
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = write(stop_event_, &one, sizeof(one));
+        (void)written; // счётчик eventfd переполниться не может
+        thread_.join();
+    }
+
+    for (auto& connection : connections_) {
+        close(connection->fd);
+    }
+    connections_.clear();
+    connections_count_ = 0;
+
+    for (int* fd : {&udp_fd_, &tcp_fd_, &epoll_fd_, &stop_event_}) {
+        if (*fd != -1) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    udp_port_ = -1;
+    tcp_port_ = -1;
+    started_ = false;
+}
+
+namespace {
+
+// Открывает сокет, привязанный к адресу; port - фактический порт
+int open_socket(int type, const std::string& address, int requested_port, int& port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(requested_port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Invalid bind address: " << address << std::endl;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    socklen_t length = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+} // namespace
+
+bool NetworkListener::open_udp() {
+    udp_fd_ = open_socket(SOCK_DGRAM, bind_address_, requested_udp_port_, udp_port_);
+    if (udp_fd_ == -1) {
+        std::cerr << "Failed to open UDP port " << requested_udp_port_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Запас ядра на всплески, пока поток событий занят
+    int buffer = UDP_RECEIVE_BUFFER;
+    setsockopt(udp_fd_, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = &udp_fd_;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, udp_fd_, &event) == 0;
+}
+
+bool NetworkListener::open_tcp() {
+    tcp_fd_ = open_socket(SOCK_STREAM, bind_address_, requested_tcp_port_, tcp_port_);
+    if (tcp_fd_ == -1 || listen(tcp_fd_, SOMAXCONN) != 0) {
+        std::cerr << "Failed to open TCP port " << requested_tcp_port_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = &tcp_fd_;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, tcp_fd_, &event) == 0;
+}
+
+void NetworkListener::event_loop() {
+    epoll_event events[MAX_EVENTS];
+    for (;;) {
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Network event loop error: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            void* source = events[i].data.ptr;
+            if (source == nullptr) return;
+
+            if (source == &udp_fd_) {
+                read_datagrams();
+            } else if (source == &tcp_fd_) {
+                accept_connections();
+            } else {
+                Connection& connection = *static_cast<Connection*>(source);
+                if (events[i].events & EPOLLIN) {
+                    read_connection(connection);
+                } else {
+                    close_connection(connection);
+                }
+            }
+        }
+    }
+}
+
+void NetworkListener::read_datagrams() {
+    mmsghdr messages[UDP_BATCH];
+    iovec buffers[UDP_BATCH];
+
+    for (int reads = 0; reads < READS_PER_EVENT; ++reads) {
+        std::memset(messages, 0, sizeof(messages));
+        for (size_t i = 0; i < UDP_BATCH; ++i) {
+            buffers[i].iov_base = datagram_buffers_.get() + i * MAX_DATAGRAM;
+            buffers[i].iov_len = MAX_DATAGRAM;
+            messages[i].msg_hdr.msg_iov = &buffers[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = recvmmsg(udp_fd_, messages, UDP_BATCH, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "UDP receive error: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        datagrams_.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+
+        for (int i = 0; i < received; ++i) {
+            // Обрезанная датаграмма оборвала бы последнюю строку посередине
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::string_view data(static_cast<const char*>(buffers[i].iov_base), messages[i].msg_len);
+            while (!data.empty()) {
+                size_t end = data.find('\n');
+                std::string_view line = data.substr(0, end);
+                if (!line.empty()) handle_line(line, last_udp_sensor_);
+                if (end == std::string_view::npos) break;
+                data.remove_prefix(end + 1);
+            }
+        }
+        if (static_cast<size_t>(received) < UDP_BATCH) return;
+    }
+}
+
+void NetworkListener::accept_connections() {
+    for (;;) {
+        int fd = accept4(tcp_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                std::cerr << "TCP accept error: " << strerror(errno) << std::endl;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;
+        }
+        if (connections_.size() >= MAX_CONNECTIONS) {
+            std::cerr << "Too many sensor connections, refusing" << std::endl;
+            close(fd);
+            continue;
+        }
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = connection.get();
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_.push_back(std::move(connection));
+        connections_count_ = connections_.size();
+    }
+}
+
+void NetworkListener::read_connection(Connection& connection) {
+    auto on_line = [this, &connection](std::string_view line) {
+        handle_line(line, connection.last_sensor);
+    };
+
+    for (int reads = 0; reads < READS_PER_EVENT; ++reads) {
+        ssize_t bytes_read = read(connection.fd, connection.lines.write_area(), connection.lines.write_space());
+        if (bytes_read > 0) {
+            connection.lines.commit(static_cast<size_t>(bytes_read), on_line);
+            continue;
+        }
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        // Датчик закрыл соединение или оно оборвалось
+        close_connection(connection);
+        return;
+    }
+}
+
+void NetworkListener::close_connection(Connection& connection) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+
+    auto it = std::find_if(connections_.begin(), connections_.end(),
+                           [&connection](const auto& item) { return item.get() == &connection; });
+    if (it != connections_.end()) {
+        std::swap(*it, connections_.back());
+        connections_.pop_back();
+    }
+    connections_count_ = connections_.size();
+}
+#else
+bool NetworkListener::start() {
+    std::cerr << "Network listener is not supported on this platform" << std::endl;
+    return false;
+}
+
+void NetworkListener::stop() {}
+bool NetworkListener::open_udp() { return false; }
+bool NetworkListener::open_tcp() { return false; }
+void NetworkListener::event_loop() {}
+void NetworkListener::read_datagrams() {}
+void NetworkListener::accept_connections() {}
+void NetworkListener::read_connection(Connection&) {}
+void NetworkListener::close_connection(Connection&) {}
+#endif
+
+void NetworkListener::handle_line(std::string_view line, const std::string*& last_sensor) {
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::string_view sensor_id = line.substr(0, space);
+    line.remove_prefix(space + 1);
+
+    // Обычно строки подряд идут от одного датчика: поиск в наборе не нужен
+    if (last_sensor == nullptr || *last_sensor != sensor_id) {
+        const std::string* interned = intern_sensor(sensor_id);
+        if (interned == nullptr) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        last_sensor = interned;
+    }
+
+    lines_.fetch_add(1, std::memory_order_relaxed);
+    if (callback_) callback_(*last_sensor, line);
+}
+
+const std::string* NetworkListener::intern_sensor(std::string_view sensor_id) {
+    auto it = sensors_.find(sensor_id);
+    if (it != sensors_.end()) return &*it;
+    if (!valid_sensor_id(sensor_id)) return nullptr;
+    if (sensors_.size() >= MAX_SENSORS) {
+        // Об ошибке сообщаем один раз, дальше только считаем
+        if (!sensor_limit_reported_) {
+            std::cerr << "Too many network sensors, ignoring " << sensor_id << " and other new ones" << std::endl;
+            sensor_limit_reported_ = true;
+        }
+        return nullptr;
+    }
+    return &*sensors_.emplace(sensor_id).first;
+}
@@ -1,16 +1,15 @@
 #include "port_reader.h"
+#include "serial_port.h"
+#include "device_frame.h"
 #include <iostream>
-#include <chrono>
+#include <cstdint>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
-#include <fcntl.h>
-#include <termios.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <errno.h>
 #endif
@@ -50,41 +49,29 @@ bool PortReader::start() {
     dcb.Parity = NOPARITY;
     SetCommState(handle_, &dcb);
     
+    // ReadFile возвращается сразу, как только в порту есть хотя бы один байт,
+    // а без данных ждёт не дольше STOP_CHECK_MS, чтобы заметить stop()
     COMMTIMEOUTS timeouts = {0};
-    timeouts.ReadIntervalTimeout = 50;
-    timeouts.ReadTotalTimeoutConstant = 50;
-    timeouts.ReadTotalTimeoutMultiplier = 10;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = STOP_CHECK_MS;
     SetCommTimeouts(handle_, &timeouts);
 #else
-    file_descriptor_ = open(port_name_.c_str(), O_RDONLY | O_NOCTTY);
+    // Неблокирующий режим: поток ждёт в poll, а read забирает всё накопленное
+    SerialSettings settings;
+    settings.baud_rate = baud_rate_;
+    file_descriptor_ = open_serial_port(port_name_, settings);
     if (file_descriptor_ == -1) {
         std::cerr << "Failed to open port: " << port_name_ << " Error: " << strerror(errno) << std::endl;
         return false;
     }
     
-    struct termios tty;
-    memset(&tty, 0, sizeof(tty));
-    
-    if (tcgetattr(file_descriptor_, &tty) != 0) {
-        std::cerr << "Error getting termios attributes" << std::endl;
-        return false;
-    }
-    
-    cfsetospeed(&tty, baud_rate_);
-    cfsetispeed(&tty, baud_rate_);
-    
-    tty.c_cflag &= ~PARENB;
-    tty.c_cflag &= ~CSTOPB;
-    tty.c_cflag &= ~CSIZE;
-    tty.c_cflag |= CS8;
-    tty.c_cflag &= ~CRTSCTS;
-    tty.c_cflag |= CREAD | CLOCAL;
-    tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-    tty.c_iflag &= ~(IXON | IXOFF | IXANY);
-    tty.c_oflag &= ~OPOST;
-    
-    if (tcsetattr(file_descriptor_, TCSANOW, &tty) != 0) {
-        std::cerr << "Error setting termios attributes" << std::endl;
+    // Сигнал остановки будит поток, ждущий в poll
+    stop_event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_event_ == -1) {
+        std::cerr << "Failed to create stop event: " << strerror(errno) << std::endl;
+        close(file_descriptor_);
+        file_descriptor_ = -1;
         return false;
     }
 #endif
@@ -97,6 +84,13 @@ bool PortReader::start() {
 
 void PortReader::stop() {
     running_ = false;
+#ifndef _WIN32
+    if (stop_event_ != -1) {
+        uint64_t one = 1;
+        ssize_t written = write(stop_event_, &one, sizeof(one));
+        (void)written; // счётчик eventfd переполниться не может
+    }
+#endif
     if (reading_thread_.joinable()) {
         reading_thread_.join();
     }
@@ -111,6 +105,10 @@ void PortReader::stop() {
         close(file_descriptor_);
         file_descriptor_ = -1;
     }
+    if (stop_event_ != -1) {
+        close(stop_event_);
+        stop_event_ = -1;
+    }
 #endif
 }
 
@@ -118,96 +116,69 @@ void PortReader::set_callback(DataCallback callback) {
     callback_ = callback;
 }
 
+void PortReader::set_frame_callback(FrameCallback callback) {
+    frame_callback_ = callback;
+}
+
 void PortReader::reading_loop() {
     std::cout << "Reading loop started" << std::endl;
     
-    char buffer[256];
-    std::string partial_data;
+    // Данные читаются прямо в буфер разбора строк и кадров
+    DeviceStreamSplitter stream;
+    auto on_line = [this](std::string_view line) {
+        if (callback_) callback_(line);
+    };
+    auto on_frame = [this](std::string_view frame) {
+        if (frame_callback_) frame_callback_(frame);
+    };
     
     while (running_) {
 #ifdef _WIN32
         DWORD bytes_read;
-        if (ReadFile(handle_, buffer, sizeof(buffer) - 1, &bytes_read, NULL)) {
-            if (bytes_read > 0) {
-                buffer[bytes_read] = '\0';
-                partial_data += buffer;
-                
-                size_t pos;
-                while ((pos = partial_data.find('\n')) != std::string::npos) {
-                    std::string line = partial_data.substr(0, pos);
-                    partial_data.erase(0, pos + 1);
-                    
-                    if (!line.empty() && callback_) {
-                        callback_(line);
-                    }
-                }
-            }
+        if (ReadFile(handle_, stream.write_area(), static_cast<DWORD>(stream.write_space()), &bytes_read, NULL) &&
+            bytes_read > 0) {
+            stream.commit(bytes_read, on_line, on_frame);
         }
 #else
-        ssize_t bytes_read = read(file_descriptor_, buffer, sizeof(buffer) - 1);
-        if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            partial_data += buffer;
+        // Ждём данных или сигнала остановки без таймаута: задержка строки
+        // определяется только передачей
+        struct pollfd fds[2] = {
+            {file_descriptor_, POLLIN, 0},
+            {stop_event_, POLLIN, 0},
+        };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Poll error: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[1].revents != 0) break;
+        if (fds[0].revents & (POLLERR | POLLNVAL)) {
+            std::cerr << "Port error on " << port_name_ << std::endl;
+            break;
+        }
+        
+        // Забираем всё, что накопилось, до EAGAIN
+        bool port_closed = false;
+        for (;;) {
+            ssize_t bytes_read = read(file_descriptor_, stream.write_area(), stream.write_space());
+            if (bytes_read > 0) {
+                stream.commit(static_cast<size_t>(bytes_read), on_line, on_frame);
+                continue;
+            }
+            if (bytes_read < 0 && errno == EINTR) continue;
+            if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
             
-            size_t pos;
-            while ((pos = partial_data.find('\n')) != std::string::npos) {
-                std::string line = partial_data.substr(0, pos);
-                partial_data.erase(0, pos + 1);
-                
-                if (!line.empty() && callback_) {
-                    callback_(line);
-                }
+            if (bytes_read < 0) {
+                std::cerr << "Read error: " << strerror(errno) << std::endl;
+            } else {
+                std::cerr << "Port closed: " << port_name_ << std::endl;
             }
-        } else if (bytes_read < 0 && errno != EAGAIN) {
-            std::cerr << "Read error: " << strerror(errno) << std::endl;
+            port_closed = true;
             break;
         }
+        if (port_closed) break;
 #endif
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
     
     std::cout << "Reading loop stopped" << std::endl;
 }
-
-bool PortReader::parse_temperature(const std::string& data, float& temperature, std::time_t& timestamp) {
-    // Ожидаемый формат: TEMP:25.5 TIME:2024-01-15 14:30:45.123
-    size_t temp_pos = data.find("TEMP:");
-    size_t time_pos = data.find("TIME:");
-    
-    if (temp_pos == std::string::npos || time_pos == std::string::npos) {
-        return false;
-    }
-    
-    // Извлекаем температуру
-    size_t temp_start = temp_pos + 5;
-    size_t temp_end = data.find(' ', temp_start);
-    if (temp_end == std::string::npos) {
-        temp_end = time_pos - 1;
-    }
-    
-    std::string temp_str = data.substr(temp_start, temp_end - temp_start);
-    try {
-        temperature = std::stof(temp_str);
-    } catch (...) {
-        return false;
-    }
-    
-    // Извлекаем время
-    size_t time_start = time_pos + 5;
-    std::string time_str = data.substr(time_start);
-    
-    std::tm tm = {};
-    std::istringstream ss(time_str);
-    
-    // Парсим с миллисекундами
-    std::string datetime;
-    ss >> datetime;
-    
-    if (strptime(datetime.c_str(), "%Y-%m-%d %H:%M:%S", &tm) != nullptr) {
-        timestamp = std::mktime(&tm);
-        return true;
-    }
-    
-    return false;
-}
@@ -0,0 +1,200 @@
+#include "quantile_sketch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double GAMMA = (1.0 + QuantileSketch::RELATIVE_ACCURACY) / (1.0 - QuantileSketch::RELATIVE_ACCURACY);
+const double LOG_GAMMA = std::log(GAMMA);
+
+// Значения меньше по модулю считаются нулём (абсолютная ошибка до 0.001),
+// большие обрезаются - так число корзин ограничено даже для мусорных данных
+const double MIN_MAGNITUDE = 1e-3;
+const double MAX_MAGNITUDE = 1e6;
+
+const uint8_t FORMAT_VERSION = 1;
+
+void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool read_varint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) return false;
+        uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+void QuantileSketch::Store::add(int index, uint64_t count) {
+    if (counts.empty()) {
+        offset = index;
+        counts.assign(1, 0);
+    } else if (index < offset) {
+        counts.insert(counts.begin(), static_cast<size_t>(offset - index), 0);
+        offset = index;
+    } else if (index >= offset + static_cast<int>(counts.size())) {
+        counts.resize(static_cast<size_t>(index - offset) + 1, 0);
+    }
+    counts[static_cast<size_t>(index - offset)] += count;
+}
+
+void QuantileSketch::Store::merge(const Store& other) {
+    if (other.counts.empty()) return;
+
+    // Сначала расширяем диапазон один раз, потом складываем счётчики
+    int other_end = other.offset + static_cast<int>(other.counts.size());
+    add(other.offset, 0);
+    add(other_end - 1, 0);
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[static_cast<size_t>(other.offset - offset) + i] += other.counts[i];
+    }
+}
+
+QuantileSketch::QuantileSketch() {
+}
+
+int QuantileSketch::index_of(double magnitude) const {
+    return static_cast<int>(std::ceil(std::log(magnitude) / LOG_GAMMA));
+}
+
+double QuantileSketch::value_of(int index) const {
+    // Середина корзины (gamma^(i-1), gamma^i] в смысле относительной ошибки
+    return 2.0 * std::exp(index * LOG_GAMMA) / (1.0 + GAMMA);
+}
+
+void QuantileSketch::add(float value) {
+    if (std::isnan(value)) return;
+
+    double magnitude = std::min(std::fabs(static_cast<double>(value)), MAX_MAGNITUDE);
+    if (magnitude < MIN_MAGNITUDE) {
+        ++zero_count_;
+    } else if (value > 0) {
+        positive_.add(index_of(magnitude), 1);
+    } else {
+        negative_.add(index_of(magnitude), 1);
+    }
+    ++count_;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    positive_.merge(other.positive_);
+    negative_.merge(other.negative_);
+    zero_count_ += other.zero_count_;
+    count_ += other.count_;
+}
+
+void QuantileSketch::clear() {
+    *this = QuantileSketch();
+}
+
+float QuantileSketch::quantile(double q) const {
+    if (count_ == 0) return 0.0f;
+
+    q = std::min(1.0, std::max(0.0, q));
+    double rank = q * static_cast<double>(count_ - 1);
+
+    // По возрастанию: отрицательные от больших модулей к малым, ноль, положительные
+    double seen = 0.0;
+    for (size_t i = negative_.counts.size(); i-- > 0;) {
+        seen += static_cast<double>(negative_.counts[i]);
+        if (seen > rank) {
+            return static_cast<float>(-value_of(negative_.offset + static_cast<int>(i)));
+        }
+    }
+
+    seen += static_cast<double>(zero_count_);
+    if (seen > rank) return 0.0f;
+
+    for (size_t i = 0; i < positive_.counts.size(); ++i) {
+        seen += static_cast<double>(positive_.counts[i]);
+        if (seen > rank) {
+            return static_cast<float>(value_of(positive_.offset + static_cast<int>(i)));
+        }
+    }
+
+    return static_cast<float>(value_of(positive_.offset + static_cast<int>(positive_.counts.size()) - 1));
+}
+
+TemperaturePercentiles QuantileSketch::percentiles() const {
+    TemperaturePercentiles result;
+    result.count = count();
+    if (count_ == 0) return result;
+
+    result.p5 = quantile(0.05);
+    result.p50 = quantile(0.50);
+    result.p95 = quantile(0.95);
+    result.p99 = quantile(0.99);
+    return result;
+}
+
+std::vector<uint8_t> QuantileSketch::serialize() const {
+    std::vector<uint8_t> out;
+    if (count_ == 0) return out;
+
+    // [версия][нули][по каждой стопке: смещение, число корзин, счётчики]
+    out.push_back(FORMAT_VERSION);
+    write_varint(out, zero_count_);
+    for (const Store* store : {&positive_, &negative_}) {
+        // Пустые корзины по краям (остаются после слияния) не пишем
+        size_t first = 0;
+        size_t last = store->counts.size();
+        while (first < last && store->counts[first] == 0) ++first;
+        while (last > first && store->counts[last - 1] == 0) --last;
+
+        write_varint(out, zigzag(store->offset + static_cast<int64_t>(first)));
+        write_varint(out, last - first);
+        for (size_t i = first; i < last; ++i) {
+            write_varint(out, store->counts[i]);
+        }
+    }
+    return out;
+}
+
+bool QuantileSketch::deserialize(const uint8_t* data, size_t size, QuantileSketch& out) {
+    QuantileSketch sketch;
+    if (size == 0) {
+        out = sketch;
+        return true;
+    }
+
+    const uint8_t* end = data + size;
+    if (*data++ != FORMAT_VERSION) return false;
+    if (!read_varint(data, end, sketch.zero_count_)) return false;
+    sketch.count_ = sketch.zero_count_;
+
+    for (Store* store : {&sketch.positive_, &sketch.negative_}) {
+        uint64_t offset, bins;
+        if (!read_varint(data, end, offset) || !read_varint(data, end, bins)) return false;
+        // Каждый счётчик занимает хотя бы байт - защита от огромных выделений
+        if (bins > static_cast<uint64_t>(end - data)) return false;
+
+        store->offset = static_cast<int>(unzigzag(offset));
+        store->counts.resize(static_cast<size_t>(bins));
+        for (auto& count : store->counts) {
+            if (!read_varint(data, end, count)) return false;
+            sketch.count_ += count;
+        }
+    }
+
+    if (data != end) return false;
+    out = std::move(sketch);
+    return true;
+}
@@ -0,0 +1,261 @@
+#include "segmented_log.h"
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+
+namespace {
+
+const std::time_t SECONDS_PER_HOUR = 3600;
+const std::time_t SECONDS_PER_DAY = 86400;
+
+struct CivilDate {
+    long long year;
+    unsigned month;
+    unsigned day;
+};
+
+std::time_t floor_div(std::time_t value, std::time_t divisor) {
+    std::time_t quotient = value / divisor;
+    if (value % divisor != 0 && value < 0) --quotient;
+    return quotient;
+}
+
+// Перевод дней от 1970-01-01 в дату и обратно (григорианский календарь, UTC).
+// Не зависит от часового пояса, в отличие от mktime.
+long long days_from_civil(long long year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<long long>(day_of_era) - 719468;
+}
+
+CivilDate civil_from_days(long long days) {
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned mp = (5 * day_of_year + 2) / 153;
+    unsigned day = day_of_year - (153 * mp + 2) / 5 + 1;
+    unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    long long year = static_cast<long long>(year_of_era) + era * 400 + (month <= 2);
+    return {year, month, day};
+}
+
+} // namespace
+
+SegmentedLog::SegmentedLog(const std::string& directory, const std::string& name,
+                           SegmentSpan span, std::time_t retention_seconds,
+                           const std::string& extension, size_t record_size)
+    : directory_(directory), name_(name), span_(span), retention_seconds_(retention_seconds),
+      extension_(extension), record_size_(record_size) {
+}
+
+SegmentedLog::~SegmentedLog() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+bool SegmentedLog::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "Failed to create log directory " << directory_ << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    segments_.clear();
+    std::ifstream manifest(manifest_path());
+    if (!manifest.is_open()) return true;
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::istringstream iss(line);
+        long long start, end;
+        std::string file;
+        if (iss >> start >> end >> file) {
+            segments_[static_cast<std::time_t>(start)] = file;
+        }
+    }
+    return true;
+}
+
+std::time_t SegmentedLog::segment_start(std::time_t timestamp) const {
+    if (span_ == SegmentSpan::HOUR) {
+        return floor_div(timestamp, SECONDS_PER_HOUR) * SECONDS_PER_HOUR;
+    }
+
+    CivilDate date = civil_from_days(floor_div(timestamp, SECONDS_PER_DAY));
+    unsigned month = span_ == SegmentSpan::MONTH ? date.month : 1;
+    return static_cast<std::time_t>(days_from_civil(date.year, month, 1)) * SECONDS_PER_DAY;
+}
+
+std::time_t SegmentedLog::segment_end(std::time_t start) const {
+    if (span_ == SegmentSpan::HOUR) {
+        return start + SECONDS_PER_HOUR;
+    }
+
+    CivilDate date = civil_from_days(floor_div(start, SECONDS_PER_DAY));
+    if (span_ == SegmentSpan::YEAR) {
+        return static_cast<std::time_t>(days_from_civil(date.year + 1, 1, 1)) * SECONDS_PER_DAY;
+    }
+    if (date.month == 12) {
+        return static_cast<std::time_t>(days_from_civil(date.year + 1, 1, 1)) * SECONDS_PER_DAY;
+    }
+    return static_cast<std::time_t>(days_from_civil(date.year, date.month + 1, 1)) * SECONDS_PER_DAY;
+}
+
+std::string SegmentedLog::segment_name(std::time_t start) const {
+    CivilDate date = civil_from_days(floor_div(start, SECONDS_PER_DAY));
+    char buffer[64];
+    switch (span_) {
+        case SegmentSpan::HOUR: {
+            int hour = static_cast<int>((start - floor_div(start, SECONDS_PER_DAY) * SECONDS_PER_DAY) / SECONDS_PER_HOUR);
+            std::snprintf(buffer, sizeof(buffer), "%s-%04lld-%02u-%02uT%02d%s",
+                          name_.c_str(), date.year, date.month, date.day, hour, extension_.c_str());
+            break;
+        }
+        case SegmentSpan::MONTH:
+            std::snprintf(buffer, sizeof(buffer), "%s-%04lld-%02u%s",
+                          name_.c_str(), date.year, date.month, extension_.c_str());
+            break;
+        case SegmentSpan::YEAR:
+            std::snprintf(buffer, sizeof(buffer), "%s-%04lld%s",
+                          name_.c_str(), date.year, extension_.c_str());
+            break;
+    }
+    return buffer;
+}
+
+std::string SegmentedLog::path_of(const std::string& file) const {
+    return (std::filesystem::path(directory_) / file).string();
+}
+
+std::string SegmentedLog::manifest_path() const {
+    // У каждого формата свой манифест: текстовые и бинарные сегменты не смешиваются
+    return path_of(name_ + extension_ + ".manifest");
+}
+
+bool SegmentedLog::save_manifest() const {
+    // Пишем во временный файл и подменяем - манифест не бывает обрезанным
+    std::string path = manifest_path();
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream manifest(tmp_path, std::ios::trunc);
+        if (!manifest.is_open()) {
+            std::cerr << "Failed to write log manifest " << tmp_path << std::endl;
+            return false;
+        }
+        for (const auto& segment : segments_) {
+            manifest << static_cast<long long>(segment.first) << " "
+                     << static_cast<long long>(segment_end(segment.first)) << " "
+                     << segment.second << '\n';
+        }
+        if (!manifest.flush()) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace log manifest " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::ostream* SegmentedLog::stream_for(std::time_t timestamp) {
+    std::time_t start = segment_start(timestamp);
+    if (start == out_start_ && out_.is_open()) {
+        return &out_;
+    }
+
+    if (out_.is_open()) {
+        out_.close();
+    }
+
+    // Сначала манифест, затем файл: сегмент из манифеста может не существовать,
+    // но файл вне манифеста - никогда
+    auto it = segments_.find(start);
+    if (it == segments_.end()) {
+        it = segments_.emplace(start, segment_name(start)).first;
+        save_manifest();
+    }
+
+    std::string path = path_of(it->second);
+    if (record_size_ > 0) {
+        // Обрыв на середине записи сдвинул бы все последующие
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path, ec);
+        if (!ec && size % record_size_ != 0) {
+            std::filesystem::resize_file(path, size - size % record_size_, ec);
+        }
+    }
+
+    out_.open(path, std::ios::app | std::ios::binary);
+    if (!out_.is_open()) {
+        std::cerr << "Failed to open log segment " << path << std::endl;
+        out_start_ = -1;
+        return nullptr;
+    }
+    out_start_ = start;
+    return &out_;
+}
+
+void SegmentedLog::flush() {
+    if (out_.is_open()) {
+        out_.flush();
+    }
+}
+
+size_t SegmentedLog::remove_expired(std::time_t now) {
+    return remove_segments(now - retention_seconds_);
+}
+
+void SegmentedLog::remove_all() {
+    remove_segments(std::numeric_limits<std::time_t>::max());
+
+    std::error_code ec;
+    std::filesystem::remove(manifest_path(), ec);
+}
+
+size_t SegmentedLog::remove_segments(std::time_t cutoff) {
+    size_t removed = 0;
+
+    for (auto it = segments_.begin(); it != segments_.end();) {
+        if (segment_end(it->first) > cutoff) {
+            // Сегменты упорядочены по времени - дальше только свежие
+            break;
+        }
+        if (it->first == out_start_) {
+            out_.close();
+            out_start_ = -1;
+        }
+
+        std::error_code ec;
+        std::filesystem::remove(path_of(it->second), ec);
+        if (ec) {
+            std::cerr << "Failed to remove log segment " << it->second << ": " << ec.message() << std::endl;
+        }
+        it = segments_.erase(it);
+        ++removed;
+    }
+
+    if (removed > 0) {
+        save_manifest();
+    }
+    return removed;
+}
+
+std::vector<std::string> SegmentedLog::segment_paths() const {
+    std::vector<std::string> paths;
+    paths.reserve(segments_.size());
+    for (const auto& segment : segments_) {
+        paths.push_back(path_of(segment.second));
+    }
+    return paths;
+}
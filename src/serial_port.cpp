@@ -0,0 +1,99 @@
+#include "serial_port.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+bool parse_serial_framing(const std::string& text, SerialSettings& settings) {
+    if (text.size() != 3) return false;
+
+    int data_bits = text[0] - '0';
+    char parity = static_cast<char>(text[1] & ~0x20); // без учёта регистра
+    int stop_bits = text[2] - '0';
+    if (data_bits < 5 || data_bits > 8) return false;
+    if (parity != 'N' && parity != 'E' && parity != 'O') return false;
+    if (stop_bits != 1 && stop_bits != 2) return false;
+
+    settings.data_bits = data_bits;
+    settings.parity = parity;
+    settings.stop_bits = stop_bits;
+    return true;
+}
+
+#ifndef _WIN32
+namespace {
+
+bool baud_constant(int baud_rate, speed_t& speed) {
+    switch (baud_rate) {
+        case 1200: speed = B1200; return true;
+        case 2400: speed = B2400; return true;
+        case 4800: speed = B4800; return true;
+        case 9600: speed = B9600; return true;
+        case 19200: speed = B19200; return true;
+        case 38400: speed = B38400; return true;
+        case 57600: speed = B57600; return true;
+        case 115200: speed = B115200; return true;
+        case 230400: speed = B230400; return true;
+        default: return false;
+    }
+}
+
+} // namespace
+
+int open_serial_port(const std::string& path, const SerialSettings& settings) {
+    int fd = open(path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1 || !isatty(fd)) return fd;
+
+    speed_t speed;
+    if (!baud_constant(settings.baud_rate, speed)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct termios tty;
+    memset(&tty, 0, sizeof(tty));
+    if (tcgetattr(fd, &tty) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    cfsetospeed(&tty, speed);
+    cfsetispeed(&tty, speed);
+
+    static const tcflag_t sizes[] = {CS5, CS6, CS7, CS8};
+    tty.c_cflag &= ~(PARENB | PARODD | CSTOPB | CSIZE | CRTSCTS);
+    tty.c_cflag |= sizes[settings.data_bits - 5];
+    if (settings.parity != 'N') tty.c_cflag |= PARENB;
+    if (settings.parity == 'O') tty.c_cflag |= PARODD;
+    if (settings.stop_bits == 2) tty.c_cflag |= CSTOPB;
+    tty.c_cflag |= CREAD | CLOCAL;
+    tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);
+    // Байты доходят без преобразований: двоичные кадры содержат '\r' и 0xFF
+    tty.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR | ISTRIP | BRKINT | PARMRK);
+    tty.c_oflag &= ~OPOST;
+    // VMIN = 1, VTIME = 0: порт готов к чтению с первого пришедшего байта,
+    // без межсимвольного таймера драйвера
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+LineSplitter::LineSplitter(size_t max_line)
+    : buffer_(new char[max_line > 0 ? max_line : 1]),
+      capacity_(max_line > 0 ? max_line : 1) {
+}
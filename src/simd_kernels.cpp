@@ -0,0 +1,541 @@
+#include "simd_kernels.h"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC и Clang собирают AVX-функции с атрибутом target, без флагов для всего файла
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+namespace {
+
+// Векторные сравнения меток времени возможны только для 64-битного time_t
+const bool VECTOR_TIMESTAMPS = sizeof(std::time_t) == sizeof(int64_t);
+
+// Промежуточный результат: суммы отклонений от сдвига и их квадратов.
+// Сдвиг на типичное значение убирает потерю точности при вычитании в дисперсии.
+struct Partial {
+    long long count = 0;
+    double s1 = 0.0;
+    double s2 = 0.0;
+    double c1 = 0.0; // компенсации Кэхэна
+    double c2 = 0.0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    std::time_t first = std::numeric_limits<std::time_t>::max();
+    std::time_t last = std::numeric_limits<std::time_t>::min();
+};
+
+inline void kahan_add(double& sum, double& compensation, double value) {
+    double y = value - compensation;
+    double t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+}
+
+// Сложение частичных сумм векторных дорожек (sum - compensation у каждой)
+void merge_lanes(const double* sums, const double* compensations, int lanes,
+                 double& sum, double& compensation) {
+    for (int i = 0; i < lanes; ++i) {
+        kahan_add(sum, compensation, sums[i] - compensations[i]);
+    }
+}
+
+unsigned popcount8(unsigned mask) {
+    mask = mask - ((mask >> 1) & 0x55u);
+    mask = (mask & 0x33u) + ((mask >> 2) & 0x33u);
+    return (mask + (mask >> 4)) & 0x0Fu;
+}
+
+template <bool Filter, bool Kahan>
+void scalar_kernel(const std::time_t* timestamps, const float* values, size_t begin, size_t count,
+                   std::time_t from, std::time_t to, double shift, Partial& p) {
+    for (size_t i = begin; i < count; ++i) {
+        if (Filter && (timestamps[i] < from || timestamps[i] > to)) continue;
+
+        double d = static_cast<double>(values[i]) - shift;
+        if (Kahan) {
+            kahan_add(p.s1, p.c1, d);
+            kahan_add(p.s2, p.c2, d * d);
+        } else {
+            p.s1 += d;
+            p.s2 += d * d;
+        }
+        p.min = std::min(p.min, values[i]);
+        p.max = std::max(p.max, values[i]);
+        if (Filter) {
+            p.first = std::min(p.first, timestamps[i]);
+            p.last = std::max(p.last, timestamps[i]);
+        }
+        ++p.count;
+    }
+}
+
+#ifdef SIMD_X86
+
+// ---- SSE2: 4 значения за шаг ----
+
+SIMD_TARGET("sse2")
+inline void kahan_add_sse2(__m128d& sum, __m128d& compensation, __m128d value) {
+    __m128d y = _mm_sub_pd(value, compensation);
+    __m128d t = _mm_add_pd(sum, y);
+    compensation = _mm_sub_pd(_mm_sub_pd(t, sum), y);
+    sum = t;
+}
+
+template <bool Kahan>
+SIMD_TARGET("sse2")
+size_t sse2_kernel(const float* values, size_t count, double shift, Partial& p) {
+    __m128d s1[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d s2[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d c1[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d c2[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128 vmin = _mm_set1_ps(p.min);
+    __m128 vmax = _mm_set1_ps(p.max);
+    const __m128d k = _mm_set1_pd(shift);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(values + i);
+        vmin = _mm_min_ps(vmin, x);
+        vmax = _mm_max_ps(vmax, x);
+
+        __m128d d[2] = {_mm_sub_pd(_mm_cvtps_pd(x), k),
+                        _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), k)};
+        for (int j = 0; j < 2; ++j) {
+            if (Kahan) {
+                kahan_add_sse2(s1[j], c1[j], d[j]);
+                kahan_add_sse2(s2[j], c2[j], _mm_mul_pd(d[j], d[j]));
+            } else {
+                s1[j] = _mm_add_pd(s1[j], d[j]);
+                s2[j] = _mm_add_pd(s2[j], _mm_mul_pd(d[j], d[j]));
+            }
+        }
+    }
+
+    alignas(16) double sums[4], comps[4];
+    _mm_store_pd(sums, s1[0]); _mm_store_pd(sums + 2, s1[1]);
+    _mm_store_pd(comps, c1[0]); _mm_store_pd(comps + 2, c1[1]);
+    merge_lanes(sums, comps, 4, p.s1, p.c1);
+    _mm_store_pd(sums, s2[0]); _mm_store_pd(sums + 2, s2[1]);
+    _mm_store_pd(comps, c2[0]); _mm_store_pd(comps + 2, c2[1]);
+    merge_lanes(sums, comps, 4, p.s2, p.c2);
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, vmin);
+    p.min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm_store_ps(lanes, vmax);
+    p.max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    p.count += static_cast<long long>(i);
+    return i;
+}
+
+// ---- AVX2: 8 значений за шаг, с фильтром - 4 ----
+
+SIMD_TARGET("avx2")
+inline void kahan_add_avx2(__m256d& sum, __m256d& compensation, __m256d value) {
+    __m256d y = _mm256_sub_pd(value, compensation);
+    __m256d t = _mm256_add_pd(sum, y);
+    compensation = _mm256_sub_pd(_mm256_sub_pd(t, sum), y);
+    sum = t;
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx2")
+void avx2_accumulate(__m256d& s1, __m256d& s2, __m256d& c1, __m256d& c2, __m256d d) {
+    if (Kahan) {
+        kahan_add_avx2(s1, c1, d);
+        kahan_add_avx2(s2, c2, _mm256_mul_pd(d, d));
+    } else {
+        s1 = _mm256_add_pd(s1, d);
+        s2 = _mm256_add_pd(s2, _mm256_mul_pd(d, d));
+    }
+}
+
+SIMD_TARGET("avx2")
+void avx2_merge(const __m256d* s1, const __m256d* c1, const __m256d* s2, const __m256d* c2,
+                int vectors, Partial& p) {
+    alignas(32) double sums[4], comps[4];
+    for (int j = 0; j < vectors; ++j) {
+        _mm256_store_pd(sums, s1[j]);
+        _mm256_store_pd(comps, c1[j]);
+        merge_lanes(sums, comps, 4, p.s1, p.c1);
+        _mm256_store_pd(sums, s2[j]);
+        _mm256_store_pd(comps, c2[j]);
+        merge_lanes(sums, comps, 4, p.s2, p.c2);
+    }
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx2")
+size_t avx2_kernel(const float* values, size_t count, double shift, Partial& p) {
+    __m256d s1[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d s2[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d c1[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d c2[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256 vmin = _mm256_set1_ps(p.min);
+    __m256 vmax = _mm256_set1_ps(p.max);
+    const __m256d k = _mm256_set1_pd(shift);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(values + i);
+        vmin = _mm256_min_ps(vmin, x);
+        vmax = _mm256_max_ps(vmax, x);
+        avx2_accumulate<Kahan>(s1[0], s2[0], c1[0], c2[0],
+                               _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), k));
+        avx2_accumulate<Kahan>(s1[1], s2[1], c1[1], c2[1],
+                               _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), k));
+    }
+    avx2_merge(s1, c1, s2, c2, 2, p);
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, vmin);
+    p.min = *std::min_element(lanes, lanes + 8);
+    _mm256_store_ps(lanes, vmax);
+    p.max = *std::max_element(lanes, lanes + 8);
+
+    p.count += static_cast<long long>(i);
+    return i;
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx2")
+size_t avx2_range_kernel(const std::time_t* timestamps, const float* values, size_t count,
+                         std::time_t from, std::time_t to, double shift, Partial& p) {
+    __m256d s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd();
+    __m256d c1 = _mm256_setzero_pd(), c2 = _mm256_setzero_pd();
+    const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d neg_inf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d vmin = inf, vmax = neg_inf;
+    const __m256i ts_high = _mm256_set1_epi64x(std::numeric_limits<int64_t>::max());
+    const __m256i ts_low = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+    __m256i tmin = ts_high, tmax = ts_low;
+    const __m256i lower = _mm256_set1_epi64x(static_cast<int64_t>(from));
+    const __m256i upper = _mm256_set1_epi64x(static_cast<int64_t>(to));
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256d k = _mm256_set1_pd(shift);
+    long long selected = 0;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Маска: from <= t <= to
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(timestamps + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lower, t), _mm256_cmpgt_epi64(t, upper));
+        __m256d mask = _mm256_castsi256_pd(_mm256_xor_si256(outside, ones));
+
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(values + i));
+        avx2_accumulate<Kahan>(s1, s2, c1, c2, _mm256_and_pd(_mm256_sub_pd(x, k), mask));
+        vmin = _mm256_min_pd(vmin, _mm256_blendv_pd(inf, x, mask));
+        vmax = _mm256_max_pd(vmax, _mm256_blendv_pd(neg_inf, x, mask));
+
+        __m256i t_lo = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(ts_high), _mm256_castsi256_pd(t), mask));
+        __m256i t_hi = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(ts_low), _mm256_castsi256_pd(t), mask));
+        tmin = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(tmin), _mm256_castsi256_pd(t_lo),
+                                                     _mm256_castsi256_pd(_mm256_cmpgt_epi64(tmin, t_lo))));
+        tmax = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(tmax), _mm256_castsi256_pd(t_hi),
+                                                     _mm256_castsi256_pd(_mm256_cmpgt_epi64(t_hi, tmax))));
+
+        selected += popcount8(static_cast<unsigned>(_mm256_movemask_pd(mask)));
+    }
+    avx2_merge(&s1, &c1, &s2, &c2, 1, p);
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, vmin);
+    p.min = std::min(p.min, static_cast<float>(*std::min_element(lanes, lanes + 4)));
+    _mm256_store_pd(lanes, vmax);
+    p.max = std::max(p.max, static_cast<float>(*std::max_element(lanes, lanes + 4)));
+
+    alignas(32) int64_t ts_lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(ts_lanes), tmin);
+    p.first = std::min(p.first, static_cast<std::time_t>(*std::min_element(ts_lanes, ts_lanes + 4)));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(ts_lanes), tmax);
+    p.last = std::max(p.last, static_cast<std::time_t>(*std::max_element(ts_lanes, ts_lanes + 4)));
+
+    p.count += selected;
+    return i;
+}
+
+// ---- AVX-512: 16 значений за шаг, с фильтром - 8 под маской ----
+
+SIMD_TARGET("avx512f")
+inline void kahan_add_avx512(__m512d& sum, __m512d& compensation, __m512d value) {
+    __m512d y = _mm512_sub_pd(value, compensation);
+    __m512d t = _mm512_add_pd(sum, y);
+    compensation = _mm512_sub_pd(_mm512_sub_pd(t, sum), y);
+    sum = t;
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx512f")
+void avx512_accumulate(__m512d& s1, __m512d& s2, __m512d& c1, __m512d& c2, __m512d d) {
+    if (Kahan) {
+        kahan_add_avx512(s1, c1, d);
+        kahan_add_avx512(s2, c2, _mm512_mul_pd(d, d));
+    } else {
+        s1 = _mm512_add_pd(s1, d);
+        s2 = _mm512_add_pd(s2, _mm512_mul_pd(d, d));
+    }
+}
+
+SIMD_TARGET("avx512f")
+void avx512_merge(const __m512d* s1, const __m512d* c1, const __m512d* s2, const __m512d* c2,
+                  int vectors, Partial& p) {
+    alignas(64) double sums[8], comps[8];
+    for (int j = 0; j < vectors; ++j) {
+        _mm512_store_pd(sums, s1[j]);
+        _mm512_store_pd(comps, c1[j]);
+        merge_lanes(sums, comps, 8, p.s1, p.c1);
+        _mm512_store_pd(sums, s2[j]);
+        _mm512_store_pd(comps, c2[j]);
+        merge_lanes(sums, comps, 8, p.s2, p.c2);
+    }
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx512f")
+size_t avx512_kernel(const float* values, size_t count, double shift, Partial& p) {
+    __m512d s1[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d s2[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d c1[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d c2[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512 vmin = _mm512_set1_ps(p.min);
+    __m512 vmax = _mm512_set1_ps(p.max);
+    const __m512d k = _mm512_set1_pd(shift);
+    // Формы с полной маской: немаскированные в GCC 12 берут _mm512_undefined_*
+    // и дают ложные -Wmaybe-uninitialized
+    const __mmask16 all = 0xFFFF;
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_loadu_ps(values + i);
+        vmin = _mm512_mask_min_ps(vmin, all, vmin, x);
+        vmax = _mm512_mask_max_ps(vmax, all, vmax, x);
+        avx512_accumulate<Kahan>(s1[0], s2[0], c1[0], c2[0],
+                                 _mm512_sub_pd(_mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(values + i)), k));
+        avx512_accumulate<Kahan>(s1[1], s2[1], c1[1], c2[1],
+                                 _mm512_sub_pd(_mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(values + i + 8)), k));
+    }
+    avx512_merge(s1, c1, s2, c2, 2, p);
+
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, vmin);
+    p.min = *std::min_element(lanes, lanes + 16);
+    _mm512_store_ps(lanes, vmax);
+    p.max = *std::max_element(lanes, lanes + 16);
+    p.count += static_cast<long long>(i);
+    return i;
+}
+
+template <bool Kahan>
+SIMD_TARGET("avx512f")
+size_t avx512_range_kernel(const std::time_t* timestamps, const float* values, size_t count,
+                           std::time_t from, std::time_t to, double shift, Partial& p) {
+    __m512d s1 = _mm512_setzero_pd(), s2 = _mm512_setzero_pd();
+    __m512d c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd();
+    __m512d vmin = _mm512_set1_pd(std::numeric_limits<double>::infinity());
+    __m512d vmax = _mm512_set1_pd(-std::numeric_limits<double>::infinity());
+    __m512i tmin = _mm512_set1_epi64(std::numeric_limits<int64_t>::max());
+    __m512i tmax = _mm512_set1_epi64(std::numeric_limits<int64_t>::min());
+    const __m512i lower = _mm512_set1_epi64(static_cast<int64_t>(from));
+    const __m512i upper = _mm512_set1_epi64(static_cast<int64_t>(to));
+    const __m512d k = _mm512_set1_pd(shift);
+    long long selected = 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i t = _mm512_loadu_si512(timestamps + i);
+        __mmask8 mask = _mm512_cmpge_epi64_mask(t, lower) & _mm512_cmple_epi64_mask(t, upper);
+
+        __m512d x = _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(values + i));
+        avx512_accumulate<Kahan>(s1, s2, c1, c2, _mm512_maskz_sub_pd(mask, x, k));
+        vmin = _mm512_mask_min_pd(vmin, mask, vmin, x);
+        vmax = _mm512_mask_max_pd(vmax, mask, vmax, x);
+        tmin = _mm512_mask_min_epi64(tmin, mask, tmin, t);
+        tmax = _mm512_mask_max_epi64(tmax, mask, tmax, t);
+
+        selected += popcount8(mask);
+    }
+    avx512_merge(&s1, &c1, &s2, &c2, 1, p);
+
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, vmin);
+    p.min = std::min(p.min, static_cast<float>(*std::min_element(lanes, lanes + 8)));
+    _mm512_store_pd(lanes, vmax);
+    p.max = std::max(p.max, static_cast<float>(*std::max_element(lanes, lanes + 8)));
+
+    alignas(64) int64_t ts_lanes[8];
+    _mm512_store_si512(ts_lanes, tmin);
+    p.first = std::min(p.first, static_cast<std::time_t>(*std::min_element(ts_lanes, ts_lanes + 8)));
+    _mm512_store_si512(ts_lanes, tmax);
+    p.last = std::max(p.last, static_cast<std::time_t>(*std::max_element(ts_lanes, ts_lanes + 8)));
+
+    p.count += selected;
+    return i;
+}
+
+#endif // SIMD_X86
+
+SimdLevel detect_level() {
+#ifdef SIMD_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool avx_state = (xcr0 & 0x6) == 0x6;
+    bool avx512_state = (xcr0 & 0xE6) == 0xE6;
+    bool avx2 = false, avx512 = false;
+    if (max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = avx_state && (info[1] & (1 << 5)) != 0;
+        avx512 = avx512_state && (info[1] & (1 << 16)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    if (avx512) return SimdLevel::AVX512;
+    if (avx2) return SimdLevel::AVX2;
+    if (sse2) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+std::atomic<int> active_level{-1};
+
+Partial run_kernels(const std::time_t* timestamps, const float* values, size_t count,
+                    std::time_t from, std::time_t to, bool filter, bool kahan, double shift) {
+    Partial p;
+    size_t done = 0;
+
+#ifdef SIMD_X86
+    SimdLevel level = simd_level();
+    if (filter) {
+        // В SSE2 нет сравнения 64-битных целых - фильтр остаётся скалярным
+        if (VECTOR_TIMESTAMPS && level == SimdLevel::AVX512) {
+            done = kahan ? avx512_range_kernel<true>(timestamps, values, count, from, to, shift, p)
+                         : avx512_range_kernel<false>(timestamps, values, count, from, to, shift, p);
+        } else if (VECTOR_TIMESTAMPS && level == SimdLevel::AVX2) {
+            done = kahan ? avx2_range_kernel<true>(timestamps, values, count, from, to, shift, p)
+                         : avx2_range_kernel<false>(timestamps, values, count, from, to, shift, p);
+        }
+    } else {
+        switch (level) {
+            case SimdLevel::AVX512:
+                done = kahan ? avx512_kernel<true>(values, count, shift, p)
+                             : avx512_kernel<false>(values, count, shift, p);
+                break;
+            case SimdLevel::AVX2:
+                done = kahan ? avx2_kernel<true>(values, count, shift, p)
+                             : avx2_kernel<false>(values, count, shift, p);
+                break;
+            case SimdLevel::SSE2:
+                done = kahan ? sse2_kernel<true>(values, count, shift, p)
+                             : sse2_kernel<false>(values, count, shift, p);
+                break;
+            case SimdLevel::SCALAR:
+                break;
+        }
+    }
+#endif
+
+    // Хвост (и всё - на скалярном уровне)
+    if (filter) {
+        if (kahan) scalar_kernel<true, true>(timestamps, values, done, count, from, to, shift, p);
+        else scalar_kernel<true, false>(timestamps, values, done, count, from, to, shift, p);
+    } else {
+        if (kahan) scalar_kernel<false, true>(timestamps, values, done, count, from, to, shift, p);
+        else scalar_kernel<false, false>(timestamps, values, done, count, from, to, shift, p);
+    }
+    return p;
+}
+
+KernelStats finalize(const Partial& p, double shift, bool filter) {
+    KernelStats stats;
+    stats.count = p.count;
+    if (p.count == 0) return stats;
+
+    double n = static_cast<double>(p.count);
+    double s1 = p.s1 - p.c1;
+    double s2 = p.s2 - p.c2;
+    stats.sum = shift * n + s1;
+    stats.mean = shift + s1 / n;
+    stats.variance = std::max(0.0, (s2 - s1 * s1 / n) / n);
+    stats.min = p.min;
+    stats.max = p.max;
+    if (filter) {
+        stats.first_timestamp = p.first;
+        stats.last_timestamp = p.last;
+    }
+    return stats;
+}
+
+} // namespace
+
+SimdLevel detected_simd_level() {
+    static const SimdLevel level = detect_level();
+    return level;
+}
+
+SimdLevel simd_level() {
+    int level = active_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = static_cast<int>(detected_simd_level());
+        active_level.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+bool set_simd_level(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(detected_simd_level())) {
+        return false;
+    }
+    active_level.store(static_cast<int>(level), std::memory_order_relaxed);
+    return true;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+KernelStats aggregate_values(const float* values, size_t count, Accumulation accumulation) {
+    if (count == 0) return KernelStats();
+    double shift = values[0];
+    Partial p = run_kernels(nullptr, values, count, 0, 0, false,
+                            accumulation == Accumulation::KAHAN, shift);
+    return finalize(p, shift, false);
+}
+
+KernelStats aggregate_values_in_range(const std::time_t* timestamps, const float* values, size_t count,
+                                      std::time_t from, std::time_t to, Accumulation accumulation) {
+    if (count == 0 || from > to) return KernelStats();
+    double shift = values[0];
+    Partial p = run_kernels(timestamps, values, count, from, to, true,
+                            accumulation == Accumulation::KAHAN, shift);
+    return finalize(p, shift, true);
+}
@@ -0,0 +1,82 @@
+#include "sliding_window.h"
+#include <algorithm>
+
+SlidingWindow::Summary SlidingWindow::Summary::of(std::time_t timestamp, float value) {
+    Summary summary;
+    summary.count = 1;
+    summary.mean = value;
+    summary.min = value;
+    summary.max = value;
+    summary.last = value;
+    summary.last_timestamp = timestamp;
+    return summary;
+}
+
+SlidingWindow::Summary SlidingWindow::Summary::merge(const Summary& older, const Summary& newer) {
+    if (older.count == 0) return newer;
+    if (newer.count == 0) return older;
+
+    Summary result;
+    result.count = older.count + newer.count;
+    double delta = newer.mean - older.mean;
+    double weight = static_cast<double>(newer.count) / result.count;
+    result.mean = older.mean + delta * weight;
+    result.m2 = older.m2 + newer.m2 + delta * delta * older.count * weight;
+    result.min = std::min(older.min, newer.min);
+    result.max = std::max(older.max, newer.max);
+    result.last = newer.last;
+    result.last_timestamp = newer.last_timestamp;
+    return result;
+}
+
+SlidingWindow::SlidingWindow(std::time_t span_seconds)
+    : span_(span_seconds) {
+}
+
+void SlidingWindow::add(std::time_t timestamp, float value) {
+    back_.push_back({timestamp, value});
+    back_summary_ = Summary::merge(back_summary_, Summary::of(timestamp, value));
+}
+
+void SlidingWindow::refill_front() {
+    // Перекладываем заднюю стопку: от новых к старым, накапливая свёртку
+    front_.reserve(front_.size() + back_.size());
+    Summary suffix;
+    for (auto it = back_.rbegin(); it != back_.rend(); ++it) {
+        suffix = Summary::merge(Summary::of(it->timestamp, it->value), suffix);
+        front_.push_back({it->timestamp, suffix});
+    }
+    back_.clear();
+    back_summary_ = Summary();
+}
+
+void SlidingWindow::evict_until(std::time_t now) {
+    std::time_t cutoff = now - span_;
+    while (true) {
+        if (front_.empty()) {
+            if (back_.empty() || back_.front().timestamp > cutoff) return;
+            refill_front();
+        }
+        if (front_.back().timestamp > cutoff) return;
+        front_.pop_back();
+    }
+}
+
+WindowStats SlidingWindow::stats() const {
+    Summary total = back_summary_;
+    if (!front_.empty()) {
+        total = Summary::merge(front_.back().suffix, back_summary_);
+    }
+
+    WindowStats stats;
+    stats.count = total.count;
+    if (total.count > 0) {
+        stats.mean = total.mean;
+        stats.variance = total.m2 / total.count;
+        stats.min = total.min;
+        stats.max = total.max;
+        stats.last = total.last;
+        stats.last_timestamp = total.last_timestamp;
+    }
+    return stats;
+}
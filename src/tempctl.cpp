@@ -0,0 +1,344 @@
+#include "database_manager.h"
+#include "gorilla_codec.h"
+#include "logger.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+namespace {
+
+// Бинарный формат: сигнатура, затем блоки [uint32 длина][блок Gorilla]
+const char BINARY_MAGIC[8] = {'T', 'E', 'M', 'P', 'B', 'I', 'N', '1'};
+
+const size_t DEFAULT_BATCH_SIZE = 100000;
+const long long PROGRESS_EVERY_ROWS = 1000000;
+
+struct Options {
+    std::string command;
+    std::string db_path = "temperature_data.db";
+    std::string format = "csv";
+    std::string file = "-";
+    std::time_t from = 0;
+    std::time_t to = 0;
+    int threads = 0;
+    size_t batch_size = DEFAULT_BATCH_SIZE;
+    BackupOptions backup;
+};
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " <import|export|backup|convert-logs> [options] [file]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --db <path>        Database file (default: temperature_data.db)" << std::endl;
+    std::cout << "  --format <fmt>     csv or bin (default: csv)" << std::endl;
+    std::cout << "  --from <ts>        Export: start of range (unix time)" << std::endl;
+    std::cout << "  --to <ts>          Export: end of range (unix time)" << std::endl;
+    std::cout << "  --threads <num>    Export: reader threads (default: CPU count)" << std::endl;
+    std::cout << "  --batch <rows>     Import: rows per transaction (default: 100000)" << std::endl;
+    std::cout << "  --budget-ms <ms>   Backup: max time the database is held per step (default: 5)" << std::endl;
+    std::cout << "  --pause-ms <ms>    Backup: pause between steps (default: 20)" << std::endl;
+    std::cout << "File '-' or no file means stdin/stdout; backup requires a file." << std::endl;
+    std::cout << "convert-logs rewrites the text logs in ./logs into the binary log format." << std::endl;
+}
+
+class Progress {
+public:
+    explicit Progress(const char* verb)
+        : verb_(verb), start_(std::chrono::steady_clock::now()) {}
+
+    void add(long long rows) {
+        long long before = rows_ / PROGRESS_EVERY_ROWS;
+        rows_ += rows;
+        if (rows_ / PROGRESS_EVERY_ROWS != before) {
+            report();
+        }
+    }
+
+    void finish() {
+        report();
+        std::cerr << std::endl;
+    }
+
+private:
+    void report() {
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_).count();
+        long long rate = seconds > 0 ? static_cast<long long>(rows_ / seconds) : rows_;
+        std::cerr << "\r" << verb_ << " " << rows_ << " rows (" << rate << " rows/s)" << std::flush;
+    }
+
+    const char* verb_;
+    std::chrono::steady_clock::time_point start_;
+    long long rows_{0};
+};
+
+bool flush_batch(std::vector<TemperatureData>& batch, Progress& progress) {
+    if (batch.empty()) return true;
+    if (!DatabaseManager::get_instance().import_measurements(batch)) {
+        std::cerr << std::endl << "Import failed" << std::endl;
+        return false;
+    }
+    progress.add(static_cast<long long>(batch.size()));
+    batch.clear();
+    return true;
+}
+
+bool import_csv(std::istream& in, const Options& options) {
+    Progress progress("Imported");
+    std::vector<TemperatureData> batch;
+    batch.reserve(options.batch_size);
+
+    std::string line;
+    long long line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty() || line[0] == '#') continue;
+
+        const char* begin = line.c_str();
+        char* end = nullptr;
+        long long timestamp = std::strtoll(begin, &end, 10);
+        if (end == begin || *end != ',') {
+            // Заголовок "timestamp,temperature" допустим только в первой строке
+            if (line_number == 1) continue;
+            std::cerr << std::endl << "Malformed line " << line_number << ": " << line << std::endl;
+            return false;
+        }
+
+        const char* temp_begin = end + 1;
+        float temperature = std::strtof(temp_begin, &end);
+        if (end == temp_begin) {
+            std::cerr << std::endl << "Malformed line " << line_number << ": " << line << std::endl;
+            return false;
+        }
+
+        batch.push_back({static_cast<std::time_t>(timestamp), temperature});
+        if (batch.size() >= options.batch_size && !flush_batch(batch, progress)) {
+            return false;
+        }
+    }
+
+    bool ok = flush_batch(batch, progress);
+    progress.finish();
+    return ok;
+}
+
+bool import_binary(std::istream& in, const Options& options) {
+    char magic[sizeof(BINARY_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a binary measurement file" << std::endl;
+        return false;
+    }
+
+    Progress progress("Imported");
+    std::vector<TemperatureData> batch;
+    batch.reserve(options.batch_size);
+    std::vector<uint8_t> block;
+
+    unsigned char length_bytes[4];
+    while (in.read(reinterpret_cast<char*>(length_bytes), sizeof(length_bytes))) {
+        uint32_t length = static_cast<uint32_t>(length_bytes[0]) |
+                          (static_cast<uint32_t>(length_bytes[1]) << 8) |
+                          (static_cast<uint32_t>(length_bytes[2]) << 16) |
+                          (static_cast<uint32_t>(length_bytes[3]) << 24);
+
+        block.resize(length);
+        if (!in.read(reinterpret_cast<char*>(block.data()), length)) {
+            std::cerr << std::endl << "Truncated block" << std::endl;
+            return false;
+        }
+
+        GorillaDecoder decoder(block);
+        TemperatureData data;
+        while (decoder.next(data.timestamp, data.temperature)) {
+            batch.push_back(data);
+            if (batch.size() >= options.batch_size && !flush_batch(batch, progress)) {
+                return false;
+            }
+        }
+    }
+
+    bool ok = flush_batch(batch, progress);
+    progress.finish();
+    return ok;
+}
+
+std::string format_csv(const std::vector<TemperatureData>& rows) {
+    std::string out;
+    out.reserve(rows.size() * 24);
+    char line[64];
+    for (const auto& data : rows) {
+        int n = std::snprintf(line, sizeof(line), "%lld,%.6g\n",
+                              static_cast<long long>(data.timestamp), data.temperature);
+        out.append(line, n);
+    }
+    return out;
+}
+
+std::string format_binary(const std::vector<TemperatureData>& rows) {
+    GorillaEncoder encoder;
+    for (const auto& data : rows) {
+        encoder.append(data.timestamp, data.temperature);
+    }
+    std::vector<uint8_t> block = encoder.finish();
+
+    std::string out(4 + block.size(), '\0');
+    uint32_t length = static_cast<uint32_t>(block.size());
+    out[0] = static_cast<char>(length);
+    out[1] = static_cast<char>(length >> 8);
+    out[2] = static_cast<char>(length >> 16);
+    out[3] = static_cast<char>(length >> 24);
+    std::memcpy(&out[4], block.data(), block.size());
+    return out;
+}
+
+bool export_data(std::ostream& out, const Options& options) {
+    bool binary = options.format == "bin";
+    if (binary) {
+        out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    } else {
+        out << "timestamp,temperature\n";
+    }
+
+    int threads = options.threads;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+
+    Progress progress("Exported");
+    bool ok = DatabaseManager::get_instance().export_measurements(
+        options.from, options.to, threads,
+        [binary](const std::vector<TemperatureData>& rows) {
+            return binary ? format_binary(rows) : format_csv(rows);
+        },
+        [&out, &progress, binary](const std::string& chunk) {
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            if (binary) {
+                GorillaDecoder decoder(reinterpret_cast<const uint8_t*>(chunk.data()) + 4,
+                                       chunk.size() - 4);
+                progress.add(decoder.count());
+            } else {
+                long long rows = 0;
+                for (char c : chunk) {
+                    if (c == '\n') ++rows;
+                }
+                progress.add(rows);
+            }
+            return static_cast<bool>(out);
+        });
+
+    out.flush();
+    progress.finish();
+    return ok && static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Options options;
+    options.command = argv[1];
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--db" && i + 1 < argc) {
+            options.db_path = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (arg == "--from" && i + 1 < argc) {
+            options.from = std::stoll(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            options.to = std::stoll(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batch_size = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--budget-ms" && i + 1 < argc) {
+            options.backup.latency_budget_ms = std::stoi(argv[++i]);
+        } else if (arg == "--pause-ms" && i + 1 < argc) {
+            options.backup.pause_ms = std::stoi(argv[++i]);
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            options.file = arg;
+        }
+    }
+
+    if (options.command == "convert-logs") {
+        // Перевод выполняет сам Logger при старте в бинарном формате
+        Logger::set_format(LogFormat::BINARY);
+        Logger::get_instance().flush();
+        std::cerr << "Logs converted to binary format" << std::endl;
+        return 0;
+    }
+
+    if ((options.command != "import" && options.command != "export" && options.command != "backup") ||
+        (options.command == "backup" && options.file == "-") ||
+        (options.format != "csv" && options.format != "bin") || options.batch_size == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!DatabaseManager::get_instance().initialize(options.db_path)) {
+        std::cerr << "Failed to open database: " << options.db_path << std::endl;
+        return 1;
+    }
+
+    bool binary = options.format == "bin";
+    bool ok;
+
+#ifdef _WIN32
+    if (binary && options.file == "-") {
+        _setmode(_fileno(options.command == "import" ? stdin : stdout), _O_BINARY);
+    }
+#endif
+
+    if (options.command == "backup") {
+        BackupStats stats;
+        ok = DatabaseManager::get_instance().backup(options.file, options.backup, &stats);
+        if (ok) {
+            std::cerr << "Backup written to " << options.file << ": " << stats.pages << " pages in "
+                      << stats.steps << " steps, " << stats.seconds << " s" << std::endl;
+        }
+    } else if (options.command == "import") {
+        std::ifstream file;
+        if (options.file != "-") {
+            file.open(options.file, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open " << options.file << std::endl;
+                return 1;
+            }
+        }
+        std::istream& in = options.file == "-" ? std::cin : file;
+        ok = binary ? import_binary(in, options) : import_csv(in, options);
+    } else {
+        std::ofstream file;
+        if (options.file != "-") {
+            file.open(options.file, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open " << options.file << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = options.file == "-" ? std::cout : file;
+        ok = export_data(out, options);
+    }
+
+    DatabaseManager::get_instance().cleanup();
+    return ok ? 0 : 1;
+}
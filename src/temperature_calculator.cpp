@@ -1,71 +1,248 @@
 #include "temperature_calculator.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
 #include <algorithm>
-#include <numeric>
 #include <iostream>
 
-TemperatureCalculator::TemperatureCalculator() {
+template <typename Buckets, typename Window, typename Aggregates>
+BasicTemperatureCalculator<Buckets, Window, Aggregates>::BasicTemperatureCalculator()
+    : BasicTemperatureCalculator({SECONDS_IN_MINUTE, SECONDS_IN_HOUR, SECONDS_IN_DAY}) {
 }
 
-void TemperatureCalculator::add_measurement(std::time_t timestamp, float temperature) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    measurements_.push_back({timestamp, temperature});
+template <typename Buckets, typename Window, typename Aggregates>
+BasicTemperatureCalculator<Buckets, Window, Aggregates>::BasicTemperatureCalculator(const std::vector<std::time_t>& window_seconds,
+                                                                  size_t capacity)
+    : measurements_(capacity),
+      window_spans_(window_seconds),
+      window_stats_(new Seqlock<WindowStats>[window_seconds.size()]) {
+    for (std::time_t span : window_seconds) {
+        windows_.emplace_back(span);
+    }
 }
 
-float TemperatureCalculator::calculate_hourly_average(std::time_t start_time) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::vector<float> temps;
-    for (const auto& data : measurements_) {
-        if (data.timestamp >= start_time &&
-            data.timestamp < start_time + SECONDS_IN_HOUR) {
-            temps.push_back(data.temperature);
-        }
+template <typename Buckets, typename Window, typename Aggregates>
+bool BasicTemperatureCalculator<Buckets, Window, Aggregates>::add_measurement(std::time_t timestamp, float temperature) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!measurements_.push(timestamp, temperature)) {
+        return false;
     }
     
-    if (temps.empty()) return 0.0f;
+    for (auto& window : windows_) {
+        window.add(timestamp, temperature);
+    }
+    advance_windows(timestamp);
+    publish_window_stats();
     
-    float sum = std::accumulate(temps.begin(), temps.end(), 0.0f);
-    return sum / temps.size();
+    if constexpr (Aggregates::percentiles) {
+        pending_sketch_values_.push_back({timestamp, temperature});
+        if (sketch_mutex_.try_lock()) {
+            apply_pending_sketches();
+            sketch_mutex_.unlock();
+        } else if (pending_sketch_values_.size() >= MAX_PENDING_SKETCH_VALUES) {
+            // Читатели держат скетчи непрерывно - отложенное не копим без предела
+            std::lock_guard<std::mutex> sketch_lock(sketch_mutex_);
+            apply_pending_sketches();
+        }
+    }
+    return true;
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+void BasicTemperatureCalculator<Buckets, Window, Aggregates>::advance_windows(std::time_t now) {
+    // Вызывается под write_mutex_
+    if (now <= window_end_) return;
+    window_end_ = now;
+    for (auto& window : windows_) {
+        window.evict_until(now);
+    }
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+void BasicTemperatureCalculator<Buckets, Window, Aggregates>::publish_window_stats() {
+    for (size_t i = 0; i < windows_.size(); ++i) {
+        window_stats_[i].store(windows_[i].stats());
+    }
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+void BasicTemperatureCalculator<Buckets, Window, Aggregates>::apply_pending_sketches() {
+    // Вызывается под write_mutex_ и sketch_mutex_
+    for (const auto& data : pending_sketch_values_) {
+        bucket_sketches_[bucket_of(data.timestamp)].add(data.temperature);
+    }
+    pending_sketch_values_.clear();
 }
 
-float TemperatureCalculator::calculate_daily_average(std::time_t start_time) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+template <typename Buckets, typename Window, typename Aggregates>
+TemperatureAggregate BasicTemperatureCalculator<Buckets, Window, Aggregates>::aggregate_between(std::time_t from, std::time_t to,
+                                                                                bool with_sketch) const {
+    // Нужный участок копируется из буфера (если писатель успел его затереть -
+    // заново), а считается уже копия: частями не длиннее PARALLEL_CHUNK
+    struct Chunk {
+        size_t offset;
+        size_t count;
+        std::time_t first_timestamp;
+        std::time_t last_timestamp;
+    };
+    std::vector<float> values;
+    std::vector<Chunk> chunks;
+    measurements_.read([&](const TimeSeriesRing::View& view) {
+        size_t first = view.upper_bound(from);
+        size_t last = std::max(first, view.upper_bound(to));
+        values.resize(last - first);
+        view.copy(first, last, nullptr, values.data());
+        
+        chunks.clear();
+        for (size_t offset = 0; offset < values.size(); offset += PARALLEL_CHUNK) {
+            size_t count = std::min(PARALLEL_CHUNK, values.size() - offset);
+            chunks.push_back({offset, count, view.timestamp_at(first + offset),
+                              view.timestamp_at(first + offset + count - 1)});
+        }
+    });
     
-    std::vector<float> temps;
-    for (const auto& data : measurements_) {
-        if (data.timestamp >= start_time &&
-            data.timestamp < start_time + SECONDS_IN_DAY) {
-            temps.push_back(data.temperature);
+    std::vector<TemperatureAggregate> partial(chunks.size());
+    auto process = [&](size_t index) {
+        const Chunk& chunk = chunks[index];
+        const float* chunk_values = values.data() + chunk.offset;
+        KernelStats stats = aggregate_values(chunk_values, chunk.count);
+        TemperatureAggregate& part = partial[index];
+        part.count = stats.count;
+        part.sum = stats.sum;
+        part.min_temp = stats.min;
+        part.max_temp = stats.max;
+        part.first_timestamp = chunk.first_timestamp;
+        part.last_timestamp = chunk.last_timestamp;
+        if (with_sketch) {
+            for (size_t i = 0; i < chunk.count; ++i) {
+                part.sketch.add(chunk_values[i]);
+            }
         }
+    };
+    
+    if (chunks.size() > 1) {
+        ThreadPool::shared()->parallel_for(chunks.size(), process);
+    } else if (!chunks.empty()) {
+        process(0);
     }
     
-    if (temps.empty()) return 0.0f;
+    TemperatureAggregate result;
+    for (const auto& part : partial) {
+        result.merge(part);
+    }
     
-    float sum = std::accumulate(temps.begin(), temps.end(), 0.0f);
-    return sum / temps.size();
+    return result;
 }
 
-std::vector<TemperatureData> TemperatureCalculator::get_measurements_last_24h() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::time_t now = std::time(nullptr);
+template <typename Buckets, typename Window, typename Aggregates>
+TemperatureAggregate BasicTemperatureCalculator<Buckets, Window, Aggregates>::calculate_aggregate(std::time_t from,
+                                                                                  std::time_t to) const {
+    return aggregate_between(from, to, true);
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+std::vector<TemperatureBucket> BasicTemperatureCalculator<Buckets, Window, Aggregates>::calculate_buckets(std::time_t from,
+                                                                                  std::time_t to) const {
+    std::vector<std::time_t> timestamps;
+    std::vector<float> values;
+    measurements_.read([&](const TimeSeriesRing::View& view) {
+        size_t first = view.upper_bound(bucket_start(from));
+        size_t last = std::max(first, view.upper_bound(to));
+        timestamps.resize(last - first);
+        values.resize(last - first);
+        view.copy(first, last, timestamps.data(), values.data());
+    });
     
-    std::vector<TemperatureData> result;
-    for (const auto& data : measurements_) {
-        if (now - data.timestamp <= SECONDS_IN_DAY) {
-            result.push_back(data);
+    std::vector<TemperatureBucket> result;
+    accumulate_buckets(ClosedBuckets(), timestamps.data(), values.data(), values.size(), result);
+    
+    if constexpr (Aggregates::percentiles) {
+        std::lock_guard<std::mutex> lock(sketch_mutex_);
+        for (auto& bucket : result) {
+            auto it = bucket_sketches_.find(bucket.bucket_start);
+            if (it != bucket_sketches_.end()) {
+                bucket.aggregate.sketch = it->second;
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+TemperaturePercentiles BasicTemperatureCalculator<Buckets, Window, Aggregates>::calculate_percentiles(std::time_t from,
+                                                                                    std::time_t to) const {
+    if constexpr (!Aggregates::percentiles) {
+        return TemperaturePercentiles();
+    } else {
+        std::lock_guard<std::mutex> lock(sketch_mutex_);
+        
+        // Сырые данные не нужны: скетчи корзин просто сливаются. Корзина
+        // (b, b + ширина] пересекает (from, to], если bucket_start(from) <= b < to
+        QuantileSketch merged;
+        for (auto it = bucket_sketches_.lower_bound(bucket_start(from));
+             it != bucket_sketches_.end() && it->first < to; ++it) {
+            merged.merge(it->second);
+        }
+        return merged.percentiles();
+    }
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+bool BasicTemperatureCalculator<Buckets, Window, Aggregates>::get_window_stats(std::time_t window_seconds, WindowStats& stats) const {
+    for (size_t i = 0; i < window_spans_.size(); ++i) {
+        if (window_spans_[i] == window_seconds) {
+            stats = window_stats_[i].load();
+            return true;
         }
     }
+    return false;
+}
+
+template <typename Buckets, typename Window, typename Aggregates>
+std::vector<TemperatureData> BasicTemperatureCalculator<Buckets, Window, Aggregates>::get_measurements_last_24h() const {
+    std::time_t now = std::time(nullptr);
     
+    // Копирование идёт без блокировки; если писатель успел затереть
+    // скопированное, срез берётся заново
+    std::vector<std::time_t> timestamps;
+    std::vector<float> values;
+    measurements_.read([&](const TimeSeriesRing::View& view) {
+        size_t first = view.upper_bound(now - SECONDS_IN_DAY);
+        timestamps.resize(view.size() - first);
+        values.resize(view.size() - first);
+        view.copy(first, view.size(), timestamps.data(), values.data());
+    });
+    
+    std::vector<TemperatureData> result;
+    result.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        result.push_back({timestamps[i], values[i]});
+    }
     return result;
 }
 
-void TemperatureCalculator::cleanup_old_data(std::time_t current_time) {
-    std::lock_guard<std::mutex> lock(mutex_);
+template <typename Buckets, typename Window, typename Aggregates>
+void BasicTemperatureCalculator<Buckets, Window, Aggregates>::cleanup_old_data(std::time_t current_time) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    
+    // Записи упорядочены - достаточно сдвинуть начало буфера
+    std::time_t cutoff = current_time - RETENTION_SECONDS;
+    measurements_.evict_before(cutoff);
     
-    auto it = std::remove_if(measurements_.begin(), measurements_.end(),
-        [current_time, this](const TemperatureData& data) {
-            return current_time - data.timestamp > SECONDS_IN_DAY;
-        });
+    advance_windows(current_time);
+    publish_window_stats();
     
-    measurements_.erase(it, measurements_.end());
+    // Корзина удаляется, когда в буфере не осталось ни одного её измерения;
+    // если скетчи сейчас читают - при следующей очистке
+    if constexpr (Aggregates::percentiles) {
+        if (sketch_mutex_.try_lock()) {
+            apply_pending_sketches();
+            bucket_sketches_.erase(bucket_sketches_.begin(), bucket_sketches_.lower_bound(bucket_of(cutoff)));
+            sketch_mutex_.unlock();
+        }
+    }
 }
+
+template class BasicTemperatureCalculator<FixedBuckets<10>, RetentionWindow<3600>, MeanAggregates>;
+template class BasicTemperatureCalculator<FixedBuckets<60>, RetentionWindow<86400>, FullAggregates>;
+template class BasicTemperatureCalculator<FixedBuckets<3600>, RetentionWindow<86400>, FullAggregates>;
+template class BasicTemperatureCalculator<FixedBuckets<86400>, RetentionWindow<7 * 86400>, FullAggregates>;
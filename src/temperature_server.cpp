@@ -1,5 +1,7 @@
 #include "temperature_server.h"
-#include "port_reader.h"
+#include "device_manager.h"
+#include "ingest_pipeline.h"
+#include "network_listener.h"
 #include "http_server.h"
 #include "database_manager.h"
 #include <iostream>
@@ -9,6 +11,41 @@
 #include <vector>
 #include <map>
 #include <cmath>
+#include <filesystem>
+
+namespace {
+
+// Процентили дописываются к объекту JSON; без данных - null
+void write_percentiles(std::ostringstream& json, const TemperaturePercentiles& percentiles) {
+    const char* names[] = {"p5_temperature", "p50_temperature", "p95_temperature", "p99_temperature"};
+    const float values[] = {percentiles.p5, percentiles.p50, percentiles.p95, percentiles.p99};
+    for (int i = 0; i < 4; ++i) {
+        json << ",\"" << names[i] << "\": ";
+        if (percentiles.count > 0) {
+            json << values[i];
+        } else {
+            json << "null";
+        }
+    }
+}
+
+// Строка JSON в кавычках; идентификаторы датчиков и пути приходят извне
+void write_json_string(std::ostringstream& json, const std::string& text) {
+    json << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            json << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            json << "\\u00" << std::hex << std::setw(2) << std::setfill('0')
+                 << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+            json << c;
+        }
+    }
+    json << '"';
+}
+
+} // namespace
 
 TemperatureServer::TemperatureServer() {
 }
@@ -17,7 +54,8 @@ TemperatureServer::~TemperatureServer() {
     stop();
 }
 
-bool TemperatureServer::initialize(const std::string& port_name, int http_port) {
+bool TemperatureServer::initialize(const std::vector<DeviceConfig>& devices, int http_port,
+                                   size_t device_threads, int udp_port, int tcp_port) {
     // Инициализируем базу данных
     if (!DatabaseManager::get_instance().initialize()) {
         std::cerr << "Failed to initialize database" << std::endl;
@@ -48,6 +86,26 @@ bool TemperatureServer::initialize(const std::string& port_name, int http_port)
             return handle_daily_stats(params);
         });
     
+    http_server_->register_handler("/api/stats/range",
+        [this](const std::map<std::string, std::string>& params) {
+            return handle_range_stats(params);
+        });
+    
+    http_server_->register_handler("/api/stats/series",
+        [this](const std::map<std::string, std::string>& params) {
+            return handle_series_stats(params);
+        });
+    
+    http_server_->register_handler("/api/admin/backup",
+        [this](const std::map<std::string, std::string>& params) {
+            return handle_backup(params);
+        });
+    
+    http_server_->register_handler("/api/admin/backup/status",
+        [this](const std::map<std::string, std::string>& params) {
+            return handle_backup_status(params);
+        });
+    
     http_server_->register_handler("/api/system/info",
         [this](const std::map<std::string, std::string>& params) {
             return handle_system_info(params);
@@ -59,15 +117,46 @@ bool TemperatureServer::initialize(const std::string& port_name, int http_port)
         return false;
     }
     
-    // Инициализируем чтение порта, если указан
-    if (!port_name.empty()) {
-        port_reader_ = std::make_unique<PortReader>(port_name, 9600);
-        port_reader_->set_callback([this](const std::string& data) {
-            process_temperature_data(data);
+    // Потоки устройств и сети только передают строки и кадры в конвейер:
+    // разбор и запись в базу идут в его собственных потоках
+    if (!devices.empty() || udp_port >= 0 || tcp_port >= 0) {
+        pipeline_ = std::make_unique<IngestPipeline>();
+        pipeline_->set_sink([this](const std::vector<IngestSample>& batch) {
+            return store_samples(batch);
+        });
+        if (!pipeline_->start()) {
+            std::cerr << "Failed to start ingest pipeline" << std::endl;
+            return false;
+        }
+    }
+    
+    // Устройства, которых пока нет, подключатся, когда появятся
+    if (!devices.empty()) {
+        device_manager_ = std::make_unique<DeviceManager>(device_threads);
+        for (const auto& device : devices) {
+            device_manager_->add_device(device);
+        }
+        device_manager_->set_callback([this](const std::string& sensor_id, std::string_view line) {
+            pipeline_->push_line(sensor_id, line);
+        });
+        device_manager_->set_frame_callback([this](const std::string& sensor_id, std::string_view frame) {
+            pipeline_->push_frame(sensor_id, frame);
         });
         
-        if (!port_reader_->start()) {
-            std::cerr << "Warning: Failed to start port reader" << std::endl;
+        if (!device_manager_->start()) {
+            std::cerr << "Warning: Failed to start device manager" << std::endl;
+        }
+    }
+    
+    // Сетевые датчики: тот же текстовый формат с идентификатором датчика впереди
+    if (udp_port >= 0 || tcp_port >= 0) {
+        network_listener_ = std::make_unique<NetworkListener>(udp_port, tcp_port);
+        network_listener_->set_callback([this](const std::string& sensor_id, std::string_view line) {
+            pipeline_->push_line(sensor_id, line);
+        });
+        if (!network_listener_->start()) {
+            std::cerr << "Failed to start network listener" << std::endl;
+            return false;
         }
     }
     
@@ -100,8 +189,17 @@ void TemperatureServer::run() {
 void TemperatureServer::stop() {
     running_ = false;
     
-    if (port_reader_) {
-        port_reader_->stop();
+    if (device_manager_) {
+        device_manager_->stop();
+    }
+    
+    if (network_listener_) {
+        network_listener_->stop();
+    }
+    
+    // После устройств и сети: конвейер дописывает всё принятое
+    if (pipeline_) {
+        pipeline_->stop();
     }
     
     if (http_server_) {
@@ -116,34 +214,41 @@ void TemperatureServer::stop() {
         cleanup_thread_.join();
     }
     
+    if (backup_thread_.joinable()) {
+        backup_thread_.join();
+    }
+    
     DatabaseManager::get_instance().cleanup();
 }
 
-void TemperatureServer::process_temperature_data(const std::string& data) {
-    // Парсим температуру из данных
-    size_t temp_pos = data.find("TEMP:");
-    if (temp_pos == std::string::npos) return;
-    
-    size_t temp_start = temp_pos + 5;
-    size_t temp_end = data.find(' ', temp_start);
-    std::string temp_str = data.substr(temp_start, temp_end - temp_start);
-    
-    try {
-        float temperature = std::stof(temp_str);
-        std::time_t timestamp = std::time(nullptr);
-        
-        current_temperature_ = temperature;
-        last_update_ = timestamp;
-        
-        // Сохраняем в базу данных
-        DatabaseManager::get_instance().add_measurement(timestamp, temperature);
-        
-        std::cout << "Temperature: " << temperature << "°C at "
-                  << std::ctime(&timestamp);
-                  
-    } catch (...) {
-        std::cerr << "Failed to parse temperature from: " << data << std::endl;
+size_t TemperatureServer::store_samples(const std::vector<IngestSample>& batch) {
+    // База ведёт один общий ряд: показания всех датчиков ложатся в него по
+    // времени (пачка уже упорядочена), по датчикам они различаются только
+    // в sensor_readings_
+    std::vector<TemperatureData> data;
+    data.reserve(batch.size());
+    for (const auto& sample : batch) {
+        data.push_back({sample.timestamp, sample.temperature});
+    }
+    
+    // Вся пачка - одной транзакцией
+    size_t stored = 0;
+    DatabaseManager::get_instance().add_measurements(data, &stored);
+    if (stored == 0) return 0;
+    
+    {
+        std::lock_guard<std::mutex> lock(readings_mutex_);
+        for (size_t i = 0; i < stored; ++i) {
+            sensor_readings_[*batch[i].sensor_id] = {data[i].temperature, data[i].timestamp};
+        }
+        current_temperature_ = data[stored - 1].temperature;
+        last_update_ = data[stored - 1].timestamp;
     }
+    
+    // Одна строка на пачку, а не на каждое показание
+    std::cout << "Stored " << stored << " measurements, last [" << *batch[stored - 1].sensor_id << "]: "
+              << data[stored - 1].temperature << "°C at " << std::ctime(&data[stored - 1].timestamp);
+    return stored;
 }
 
 void TemperatureServer::calculate_statistics() {
@@ -151,21 +256,17 @@ void TemperatureServer::calculate_statistics() {
     
     // Вычисляем среднечасовую температуру
     std::time_t hour_start = (now / 3600) * 3600;
-    auto measurements = DatabaseManager::get_instance().get_measurements(
-        hour_start - 3600, hour_start);
+    auto hourly = DatabaseManager::get_instance().get_aggregate(
+        hour_start - 3600, hour_start - 1);
     
-    if (!measurements.empty()) {
-        float sum = 0;
-        for (const auto& m : measurements) {
-            sum += m.temperature;
-        }
-        float hourly_avg = sum / measurements.size();
+    if (hourly.count > 0) {
+        float hourly_avg = hourly.average();
         
         DatabaseManager::get_instance().add_hourly_average(
-            hour_start - 3600, hourly_avg, measurements.size());
+            hour_start - 3600, hourly_avg, static_cast<int>(hourly.count), hourly.sketch);
         
         std::cout << "Hourly average: " << hourly_avg
-                  << "°C (based on " << measurements.size()
+                  << "°C (based on " << hourly.count
                   << " measurements)" << std::endl;
     }
     
@@ -176,21 +277,17 @@ void TemperatureServer::calculate_statistics() {
     tm->tm_sec = 0;
     std::time_t day_start = std::mktime(tm) - 86400; // Вчера
     
-    auto day_measurements = DatabaseManager::get_instance().get_measurements(
-        day_start, day_start + 86400);
+    auto daily = DatabaseManager::get_instance().get_aggregate(
+        day_start, day_start + 86400 - 1);
     
-    if (!day_measurements.empty()) {
-        float sum = 0;
-        for (const auto& m : day_measurements) {
-            sum += m.temperature;
-        }
-        float daily_avg = sum / day_measurements.size();
+    if (daily.count > 0) {
+        float daily_avg = daily.average();
         
         DatabaseManager::get_instance().add_daily_average(
-            day_start, daily_avg, day_measurements.size());
+            day_start, daily_avg, static_cast<int>(daily.count), daily.sketch);
         
         std::cout << "Daily average: " << daily_avg
-                  << "°C (based on " << day_measurements.size()
+                  << "°C (based on " << daily.count
                   << " measurements)" << std::endl;
     }
 }
@@ -198,8 +295,8 @@ void TemperatureServer::calculate_statistics() {
 void TemperatureServer::cleanup_old_data() {
     std::time_t now = std::time(nullptr);
     
-    // Удаляем измерения старше 7 дней
-    DatabaseManager::get_instance().delete_old_measurements(now - 7 * 86400);
+    // Прореживаем измерения по уровням хранения и удаляем устаревшие
+    DatabaseManager::get_instance().maintain_storage(now);
     
     // Удаляем часовые средние старше 30 дней
     DatabaseManager::get_instance().delete_old_hourly_averages(now - 30 * 86400);
@@ -208,14 +305,49 @@ void TemperatureServer::cleanup_old_data() {
     DatabaseManager::get_instance().delete_old_daily_averages(now - 365 * 86400);
 }
 
+bool TemperatureServer::admin_authorized(const std::map<std::string, std::string>& params) const {
+    auto it = params.find("token");
+    if (admin_token_.empty() || it == params.end() || it->second.size() != admin_token_.size()) {
+        return false;
+    }
+    // Сравнение за одно и то же время, где бы ни было расхождение
+    unsigned char diff = 0;
+    for (size_t i = 0; i < admin_token_.size(); ++i) {
+        diff |= static_cast<unsigned char>(it->second[i] ^ admin_token_[i]);
+    }
+    return diff == 0;
+}
+
+void TemperatureServer::run_backup(const std::string& path) {
+    BackupOptions options;
+    options.latency_budget_ms = BACKUP_LATENCY_BUDGET_MS;
+    
+    BackupStats stats;
+    bool ok = DatabaseManager::get_instance().backup(path, options, &stats);
+    
+    std::ostringstream status;
+    if (ok) {
+        status << "completed: " << path << " (" << stats.pages << " pages, "
+               << stats.steps << " steps, " << stats.seconds << " s)";
+    } else {
+        status << "failed: " << path;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(backup_mutex_);
+        backup_status_ = status.str();
+    }
+    std::cout << "Backup " << status.str() << std::endl;
+    backup_running_ = false;
+}
+
 std::string TemperatureServer::handle_current_temp(const std::map<std::string, std::string>& params) {
     std::ostringstream json;
     
-    float temp = DatabaseManager::get_instance().get_current_temperature();
     auto last_measurement = DatabaseManager::get_instance().get_last_measurement();
     
     json << "{";
-    json << "\"current_temperature\": " << temp << ",";
+    json << "\"current_temperature\": " << last_measurement.temperature << ",";
     json << "\"last_update\": " << last_measurement.timestamp << ",";
     json << "\"unit\": \"celsius\"";
     json << "}";
@@ -291,6 +423,7 @@ std::string TemperatureServer::handle_hourly_stats(const std::map<std::string, s
         json << "\"hour_start\": " << stat.hour_start << ",";
         json << "\"average_temperature\": " << stat.average_temp << ",";
         json << "\"measurement_count\": " << stat.count;
+        write_percentiles(json, stat.percentiles);
         json << "}";
         
         if (i < hourly_stats.size() - 1) {
@@ -338,6 +471,7 @@ std::string TemperatureServer::handle_daily_stats(const std::map<std::string, st
         json << "\"day_start\": " << stat.day_start << ",";
         json << "\"average_temperature\": " << stat.average_temp << ",";
         json << "\"measurement_count\": " << stat.count;
+        write_percentiles(json, stat.percentiles);
         json << "}";
         
         if (i < daily_stats.size() - 1) {
@@ -350,6 +484,165 @@ std::string TemperatureServer::handle_daily_stats(const std::map<std::string, st
     return http_server_->generate_json_response(json.str());
 }
 
+std::string TemperatureServer::handle_range_stats(const std::map<std::string, std::string>& params) {
+    std::time_t from = 0;
+    std::time_t to = 0;
+    
+    if (params.find("from") != params.end()) {
+        from = std::stol(params.at("from"));
+    }
+    
+    if (params.find("to") != params.end()) {
+        to = std::stol(params.at("to"));
+    }
+    
+    // По умолчанию за последние сутки
+    if (from == 0 && to == 0) {
+        to = std::time(nullptr);
+        from = to - 86400;
+    }
+    
+    auto aggregate = DatabaseManager::get_instance().get_aggregate(from, to);
+    
+    std::ostringstream json;
+    json << "{";
+    json << "\"from\": " << from << ",";
+    json << "\"to\": " << to << ",";
+    json << "\"measurement_count\": " << aggregate.count << ",";
+    json << "\"average_temperature\": " << aggregate.average() << ",";
+    json << "\"min_temperature\": " << aggregate.min_temp << ",";
+    json << "\"max_temperature\": " << aggregate.max_temp << ",";
+    json << "\"first_timestamp\": " << aggregate.first_timestamp << ",";
+    json << "\"last_timestamp\": " << aggregate.last_timestamp;
+    write_percentiles(json, aggregate.percentiles());
+    json << "}";
+    
+    return http_server_->generate_json_response(json.str());
+}
+
+std::string TemperatureServer::handle_series_stats(const std::map<std::string, std::string>& params) {
+    std::time_t from = 0;
+    std::time_t to = 0;
+    std::time_t resolution = 3600;
+    
+    if (params.find("from") != params.end()) {
+        from = std::stol(params.at("from"));
+    }
+    
+    if (params.find("to") != params.end()) {
+        to = std::stol(params.at("to"));
+    }
+    
+    if (params.find("resolution") != params.end()) {
+        resolution = std::stol(params.at("resolution"));
+    }
+    
+    if (resolution <= 0) {
+        return http_server_->generate_error_response("Resolution must be positive");
+    }
+    
+    // По умолчанию за последние сутки
+    if (from == 0 && to == 0) {
+        to = std::time(nullptr);
+        from = to - 86400;
+    }
+    
+    auto buckets = DatabaseManager::get_instance().get_downsampled(from, to, resolution);
+    
+    std::ostringstream json;
+    json << "{\"resolution\": " << resolution << ", \"buckets\": [";
+    
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        const auto& bucket = buckets[i];
+        json << "{";
+        json << "\"bucket_start\": " << bucket.bucket_start << ",";
+        json << "\"average_temperature\": " << bucket.aggregate.average() << ",";
+        json << "\"min_temperature\": " << bucket.aggregate.min_temp << ",";
+        json << "\"max_temperature\": " << bucket.aggregate.max_temp << ",";
+        json << "\"measurement_count\": " << bucket.aggregate.count;
+        write_percentiles(json, bucket.aggregate.percentiles());
+        json << "}";
+        
+        if (i < buckets.size() - 1) {
+            json << ",";
+        }
+    }
+    
+    json << "], \"count\": " << buckets.size() << "}";
+    
+    return http_server_->generate_json_response(json.str());
+}
+
+std::string TemperatureServer::handle_backup(const std::map<std::string, std::string>& params) {
+    if (!admin_authorized(params)) {
+        return http_server_->generate_error_response("Forbidden", 403);
+    }
+    
+    // Имя файла без каталогов: копии пишутся только в BACKUP_DIR
+    std::string name;
+    if (params.find("name") != params.end()) {
+        name = params.at("name");
+        if (name.empty() || name.find('/') != std::string::npos ||
+            name.find('\\') != std::string::npos || name.find("..") != std::string::npos) {
+            return http_server_->generate_error_response("Invalid backup name");
+        }
+    } else {
+        name = "temperature_data-" + std::to_string(std::time(nullptr)) + ".db";
+    }
+    
+    bool expected = false;
+    if (!backup_running_.compare_exchange_strong(expected, true)) {
+        return http_server_->generate_error_response("Backup already running", 409);
+    }
+    
+    std::error_code ec;
+    std::filesystem::create_directories(BACKUP_DIR, ec);
+    std::string path = (std::filesystem::path(BACKUP_DIR) / name).string();
+    
+    // Прежние копии не перезаписываются; копии сервера идут по одной,
+    // поэтому проверка под backup_running_ не гонится сама с собой
+    if (std::filesystem::exists(path, ec) || ec) {
+        backup_running_ = false;
+        return http_server_->generate_error_response("Backup already exists", 409);
+    }
+    
+    if (backup_thread_.joinable()) {
+        backup_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(backup_mutex_);
+        backup_status_ = "running: " + path;
+    }
+    backup_thread_ = std::thread(&TemperatureServer::run_backup, this, path);
+    
+    std::ostringstream json;
+    json << "{\"status\": \"started\", \"path\": ";
+    write_json_string(json, path);
+    json << "}";
+    return http_server_->generate_json_response(json.str());
+}
+
+std::string TemperatureServer::handle_backup_status(const std::map<std::string, std::string>& params) {
+    if (!admin_authorized(params)) {
+        return http_server_->generate_error_response("Forbidden", 403);
+    }
+    
+    std::string status;
+    {
+        std::lock_guard<std::mutex> lock(backup_mutex_);
+        status = backup_status_;
+    }
+    
+    std::ostringstream json;
+    json << "{";
+    json << "\"running\": " << (backup_running_ ? "true" : "false") << ",";
+    json << "\"status\": ";
+    write_json_string(json, status);
+    json << "}";
+    
+    return http_server_->generate_json_response(json.str());
+}
+
 std::string TemperatureServer::handle_system_info(const std::map<std::string, std::string>& params) {
     std::ostringstream json;
     
@@ -358,11 +651,56 @@ std::string TemperatureServer::handle_system_info(const std::map<std::string, st
     auto hourly_stats = DatabaseManager::get_instance().get_hourly_averages(0, 0);
     auto daily_stats = DatabaseManager::get_instance().get_daily_averages(0, 0);
     
+    float current_temperature;
+    std::map<std::string, SensorReading> sensors;
+    {
+        std::lock_guard<std::mutex> lock(readings_mutex_);
+        current_temperature = current_temperature_;
+        sensors = sensor_readings_;
+    }
+    
     json << "{";
     json << "\"system\": \"Temperature Monitoring System\",";
     json << "\"version\": \"2.0\",";
     json << "\"status\": \"running\",";
-    json << "\"current_temperature\": " << current_temperature_ << ",";
+    json << "\"current_temperature\": " << current_temperature << ",";
+    json << "\"devices\": " << (device_manager_ ? device_manager_->device_count() : 0) << ",";
+    json << "\"devices_connected\": " << (device_manager_ ? device_manager_->connected_count() : 0) << ",";
+    json << "\"sensors\": {";
+    bool first = true;
+    for (const auto& [sensor_id, reading] : sensors) {
+        if (!first) json << ",";
+        first = false;
+        write_json_string(json, sensor_id);
+        json << ": {\"temperature\": " << reading.temperature
+             << ", \"last_update\": " << reading.timestamp << "}";
+    }
+    json << "},";
+    if (network_listener_) {
+        json << "\"network\": {\"udp_port\": " << network_listener_->udp_port()
+             << ", \"tcp_port\": " << network_listener_->tcp_port()
+             << ", \"connections\": " << network_listener_->connection_count()
+             << ", \"datagrams\": " << network_listener_->datagram_count()
+             << ", \"lines\": " << network_listener_->line_count()
+             << ", \"rejected\": " << network_listener_->rejected_count() << "},";
+    }
+    if (pipeline_) {
+        IngestStats ingest = pipeline_->stats();
+        json << "\"ingest\": {";
+        const char* stage_names[] = {"raw", "samples"};
+        const StageStats* stages[] = {&ingest.raw, &ingest.samples};
+        for (int i = 0; i < 2; ++i) {
+            json << "\"" << stage_names[i] << "\": {\"accepted\": " << stages[i]->accepted
+                 << ", \"processed\": " << stages[i]->processed
+                 << ", \"dropped\": " << stages[i]->dropped
+                 << ", \"queued\": " << stages[i]->queued
+                 << ", \"high_water\": " << stages[i]->high_water << "},";
+        }
+        json << "\"parse_errors\": " << ingest.parse_errors
+             << ", \"clock_corrections\": " << ingest.clock_corrections
+             << ", \"batches\": " << ingest.batches
+             << ", \"write_retries\": " << ingest.write_retries << "},";
+    }
     json << "\"last_update\": " << last_measurement.timestamp << ",";
     json << "\"measurements_count\": " << measurements.size() << ",";
     json << "\"hourly_stats_count\": " << hourly_stats.size() << ",";
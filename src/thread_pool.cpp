@@ -0,0 +1,122 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+std::mutex shared_mutex;
+std::shared_ptr<ThreadPool> shared_pool;
+size_t shared_size = 0;
+
+// Состояние одного parallel_for: рабочие берут индексы, пока они есть
+struct ParallelJob {
+    std::function<void(size_t)> func;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t active = 0;   // рабочие, которые сейчас выполняют части
+    bool closed = false; // индексы кончились - новые рабочие не подключаются
+
+    void run() {
+        for (size_t index = next++; index < count; index = next++) {
+            func(index);
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& func) {
+    if (count == 0) return;
+    size_t helpers = std::min(count, size()) - 1;
+    if (helpers == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<ParallelJob>();
+    job->func = func;
+    job->count = count;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < helpers; ++i) {
+            tasks_.push_back([job]() {
+                {
+                    std::lock_guard<std::mutex> job_lock(job->mutex);
+                    if (job->closed) return;
+                    ++job->active;
+                }
+                job->run();
+                std::lock_guard<std::mutex> job_lock(job->mutex);
+                if (--job->active == 0) {
+                    job->done_cv.notify_all();
+                }
+            });
+        }
+    }
+    cv_.notify_all();
+
+    job->run();
+
+    // Ждём только тех, кто успел взяться за части: остальные увидят closed
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->closed = true;
+    job->done_cv.wait(lock, [&]() { return job->active == 0; });
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::shared() {
+    std::lock_guard<std::mutex> lock(shared_mutex);
+    if (!shared_pool) {
+        shared_pool = std::make_shared<ThreadPool>(shared_size);
+    }
+    return shared_pool;
+}
+
+void ThreadPool::set_shared_size(size_t threads) {
+    std::shared_ptr<ThreadPool> previous;
+    {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        shared_size = threads;
+        previous = std::move(shared_pool);
+    }
+    // Прежний пул разрушится, когда его отпустит последний запрос
+}
@@ -0,0 +1,124 @@
+#include "time_series_ring.h"
+#include <algorithm>
+
+TimeSeriesRing::View::View(const TimeSeriesRing& ring, uint64_t first, size_t size)
+    : ring_(&ring),
+      first_(first),
+      head_(static_cast<size_t>(first % ring.capacity_)),
+      size_(size),
+      lowest_(size) {
+}
+
+template <typename Compare>
+size_t TimeSeriesRing::View::search(std::time_t t, Compare before) const {
+    // Двоичный поиск по логическим индексам: каждая проба отмечается,
+    // чтобы read() мог проверить её целостность
+    size_t low = 0;
+    size_t high = size_;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        touch(mid);
+        if (before(ring_->timestamps_[physical(mid)].load(std::memory_order_relaxed), t)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t TimeSeriesRing::View::lower_bound(std::time_t t) const {
+    return search(t, [](std::time_t value, std::time_t key) { return value < key; });
+}
+
+size_t TimeSeriesRing::View::upper_bound(std::time_t t) const {
+    return search(t, [](std::time_t value, std::time_t key) { return value <= key; });
+}
+
+std::time_t TimeSeriesRing::View::timestamp_at(size_t index) const {
+    touch(index);
+    return ring_->timestamps_[physical(index)].load(std::memory_order_relaxed);
+}
+
+float TimeSeriesRing::View::value_at(size_t index) const {
+    touch(index);
+    return ring_->values_[physical(index)].load(std::memory_order_relaxed);
+}
+
+size_t TimeSeriesRing::View::copy(size_t first, size_t last, std::time_t* timestamps, float* values) const {
+    last = std::min(last, size_);
+    if (first >= last) return 0;
+    touch(first);
+
+    // Не более двух непрерывных участков: до конца массива и с его начала
+    size_t count = last - first;
+    size_t begin = physical(first);
+    size_t head = std::min(count, ring_->capacity_ - begin);
+    auto copy_part = [&](size_t from, size_t offset, size_t n) {
+        if (timestamps) {
+            for (size_t i = 0; i < n; ++i) {
+                timestamps[offset + i] = ring_->timestamps_[from + i].load(std::memory_order_relaxed);
+            }
+        }
+        if (values) {
+            for (size_t i = 0; i < n; ++i) {
+                values[offset + i] = ring_->values_[from + i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+    copy_part(begin, 0, head);
+    copy_part(0, head, count - head);
+    return count;
+}
+
+TimeSeriesRing::TimeSeriesRing(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1),
+      timestamps_(new std::atomic<std::time_t>[capacity_]()),
+      values_(new std::atomic<float>[capacity_]()) {
+}
+
+bool TimeSeriesRing::push(std::time_t timestamp, float value) {
+    uint64_t begin = begin_.load(std::memory_order_relaxed);
+    uint64_t end = committed_.load(std::memory_order_relaxed);
+    if (end > begin && timestamp < timestamps_[(end - 1) % capacity_].load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    if (end - begin == capacity_) {
+        begin_.store(begin + 1, std::memory_order_release);
+    }
+
+    // Сначала объявляем запись ячейки: читатель, заставший её в любом
+    // состоянии, увидит claimed_ после своего барьера и повторит чтение
+    claimed_.store(end + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t slot = static_cast<size_t>(end % capacity_);
+    timestamps_[slot].store(timestamp, std::memory_order_relaxed);
+    values_[slot].store(value, std::memory_order_relaxed);
+    committed_.store(end + 1, std::memory_order_release);
+    return true;
+}
+
+void TimeSeriesRing::evict_before(std::time_t cutoff) {
+    View current = view();
+    size_t count = current.lower_bound(cutoff);
+    if (count == 0) return;
+    begin_.store(current.first_ + count, std::memory_order_release);
+}
+
+TimeSeriesRing::View TimeSeriesRing::snapshot() const {
+    // begin_ читается первым: тогда end >= begin
+    uint64_t begin = begin_.load(std::memory_order_acquire);
+    uint64_t end = committed_.load(std::memory_order_acquire);
+    if (end > capacity_) {
+        begin = std::max<uint64_t>(begin, end - capacity_);
+    }
+    return View(*this, begin, static_cast<size_t>(end - begin));
+}
+
+bool TimeSeriesRing::intact(const View& view) const {
+    // Запись n затирается, когда писатель объявляет запись n + capacity_
+    uint64_t oldest_read = view.first_ + view.lowest_;
+    return claimed_.load(std::memory_order_relaxed) <= oldest_read + capacity_;
+}
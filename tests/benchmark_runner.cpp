@@ -0,0 +1,567 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "simd_kernels.h"
+#include "temperature_calculator.h"
+#include "database_manager.h"
+#include "thread_pool.h"
+#include "serial_port.h"
+#include "device_line_parser.h"
+#include "device_frame.h"
+#include "ingest_pipeline.h"
+#include "network_listener.h"
+#include <functional>
+#include <string_view>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+// Результат замера сохраняется сюда, чтобы компилятор не выбросил вычисления
+volatile double benchmark_sink = 0.0;
+
+template <typename Func>
+double measure_ns_per_item(Func&& func, size_t items, int repeats) {
+    func(); // прогрев
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        func();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(items) * repeats);
+}
+
+void report(const std::string& name, double ns_per_item) {
+    std::cout << "  " << std::left << std::setw(36) << name
+              << std::right << std::fixed << std::setprecision(3) << std::setw(9) << ns_per_item << " ns/item"
+              << std::setprecision(0) << std::setw(10) << 1000.0 / ns_per_item << " M items/s" << std::endl;
+}
+
+void benchmark_simd_kernels() {
+    std::cout << "Aggregation kernels (detected: " << simd_level_name(detected_simd_level()) << ")" << std::endl;
+
+    const size_t COUNT = 1 << 22;
+    const int REPEATS = 20;
+    std::vector<float> values(COUNT);
+    std::vector<std::time_t> timestamps(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        values[i] = 20.0f + static_cast<float>((i * 7919) % 1000) * 0.01f;
+        timestamps[i] = 1700000000 + static_cast<std::time_t>(i);
+    }
+    // Половина массива попадает в диапазон
+    std::time_t from = timestamps[COUNT / 4];
+    std::time_t to = timestamps[3 * COUNT / 4];
+
+    const SimdLevel levels[] = {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels) {
+        std::string name = simd_level_name(level);
+        if (!set_simd_level(level)) {
+            std::cout << "  " << name << ": not supported by this CPU" << std::endl;
+            continue;
+        }
+
+        report(name + " sum/min/max/var", measure_ns_per_item([&]() {
+            benchmark_sink = aggregate_values(values.data(), COUNT).variance;
+        }, COUNT, REPEATS));
+        report(name + " sum/min/max/var kahan", measure_ns_per_item([&]() {
+            benchmark_sink = aggregate_values(values.data(), COUNT, Accumulation::KAHAN).variance;
+        }, COUNT, REPEATS));
+        report(name + " time range", measure_ns_per_item([&]() {
+            benchmark_sink = aggregate_values_in_range(timestamps.data(), values.data(), COUNT, from, to).mean;
+        }, COUNT, REPEATS));
+    }
+
+    set_simd_level(detected_simd_level());
+}
+
+void benchmark_calculator_readers() {
+    std::cout << "TemperatureCalculator ingest latency under concurrent readers" << std::endl;
+
+    const int COUNT = 200000;
+    for (int reader_count : {0, 1, 4}) {
+        TemperatureCalculator calc;
+        std::time_t start = std::time(nullptr);
+        // Последние сутки заполнены: каждый читатель копирует полный срез
+        for (int i = 0; i < 86400; ++i) {
+            calc.add_measurement(start - 86400 + i, 20.0f);
+        }
+
+        std::atomic<bool> done{false};
+        std::atomic<long long> snapshots{0};
+        std::vector<std::thread> readers;
+        for (int r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&]() {
+                while (!done) {
+                    benchmark_sink = static_cast<double>(calc.get_measurements_last_24h().size());
+                    ++snapshots;
+                }
+            });
+        }
+
+        std::vector<double> latencies(COUNT);
+        for (int i = 0; i < COUNT; ++i) {
+            auto begin = std::chrono::steady_clock::now();
+            calc.add_measurement(start + i, 20.0f + static_cast<float>(i % 100) * 0.01f);
+            latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "  " << reader_count << " readers: add_measurement p50 " << std::fixed << std::setprecision(0)
+                  << latencies[COUNT / 2] << " ns, p99 " << latencies[COUNT * 99 / 100]
+                  << " ns, max " << latencies.back() << " ns (" << snapshots << " snapshots)" << std::endl;
+    }
+}
+
+void benchmark_parallel_aggregation() {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Parallel range aggregation (" << cores << " cores)" << std::endl;
+
+    // Калькулятор: сводка со скетчем по 4M записей
+    const size_t COUNT = 1 << 22;
+    TemperatureCalculator calc({60}, COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        calc.add_measurement(1000 + static_cast<std::time_t>(i), 20.0f + static_cast<float>((i * 7919) % 1000) * 0.01f);
+    }
+
+    // База: 30 суток измерений раз в секунду, часовые средние по сырым блокам
+    const char* db_path = "benchmark_parallel.db";
+    std::remove(db_path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    db.initialize(db_path);
+    const std::time_t DB_SECONDS = 30 * 86400;
+    std::time_t db_start = std::time(nullptr) - DB_SECONDS;
+    std::vector<TemperatureData> batch;
+    for (std::time_t t = 0; t < DB_SECONDS; ++t) {
+        batch.push_back({db_start + t, 20.0f + static_cast<float>((t * 7919) % 1000) * 0.01f});
+    }
+    db.import_measurements(batch);
+
+    std::vector<size_t> thread_counts = {1};
+    for (size_t threads = 2; threads <= cores; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    for (size_t threads : thread_counts) {
+        ThreadPool::set_shared_size(threads);
+        report("calculator aggregate, " + std::to_string(threads) + " threads", measure_ns_per_item([&]() {
+            benchmark_sink = calc.calculate_aggregate(0, 1000 + static_cast<std::time_t>(COUNT)).sum;
+        }, COUNT, 5));
+        report("hourly series from raw, " + std::to_string(threads) + " threads", measure_ns_per_item([&]() {
+            benchmark_sink = static_cast<double>(db.get_downsampled(db_start, db_start + DB_SECONDS, 3600).size());
+        }, static_cast<size_t>(DB_SECONDS), 3));
+    }
+
+    ThreadPool::set_shared_size(0);
+    db.cleanup();
+    std::remove(db_path);
+    std::remove((std::string(db_path) + "-wal").c_str());
+    std::remove((std::string(db_path) + "-shm").c_str());
+}
+
+template <typename Buckets>
+void report_bucketing(const std::string& name, const Buckets& buckets, const std::vector<std::time_t>& timestamps,
+                      const std::vector<float>& values, int repeats) {
+    std::vector<TemperatureBucket> result;
+    report(name, measure_ns_per_item([&]() {
+        result.clear();
+        accumulate_buckets(buckets, timestamps.data(), values.data(), timestamps.size(), result);
+        benchmark_sink = result.back().aggregate.sum;
+    }, timestamps.size(), repeats));
+}
+
+template <std::time_t Seconds>
+void compare_bucketing(const std::string& label, const std::vector<std::time_t>& timestamps,
+                       const std::vector<float>& values, int repeats) {
+    // Ширина читается через volatile, чтобы компилятор не подставил константу
+    volatile std::time_t runtime_width = Seconds;
+    report_bucketing(label + " fixed", FixedBuckets<Seconds>(), timestamps, values, repeats);
+    report_bucketing(label + " runtime", RuntimeBuckets{runtime_width}, timestamps, values, repeats);
+}
+
+void benchmark_bucket_policies() {
+    std::cout << "Bucketing with compile-time vs runtime bucket width" << std::endl;
+
+    const size_t COUNT = 1 << 22;
+    const int REPEATS = 10;
+    std::vector<std::time_t> timestamps(COUNT);
+    std::vector<float> values(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        timestamps[i] = 1700000000 + static_cast<std::time_t>(i);
+        values[i] = 20.0f + static_cast<float>((i * 7919) % 1000) * 0.01f;
+    }
+
+    compare_bucketing<10>("10 s", timestamps, values, REPEATS);
+    compare_bucketing<60>("1 min", timestamps, values, REPEATS);
+    compare_bucketing<3600>("1 h", timestamps, values, REPEATS);
+    compare_bucketing<86400>("1 d", timestamps, values, REPEATS);
+}
+
+// Прежний разбор строк PortReader: append, find, substr и erase на каждую строку
+void legacy_split(std::string& partial, const char* data, size_t size,
+                  const std::function<void(const std::string&)>& callback) {
+    partial.append(data, size);
+    size_t pos;
+    while ((pos = partial.find('\n')) != std::string::npos) {
+        std::string line = partial.substr(0, pos);
+        partial.erase(0, pos + 1);
+        if (!line.empty() && callback) {
+            callback(line);
+        }
+    }
+}
+
+void benchmark_line_framing() {
+    std::cout << "Line framing of short device lines" << std::endl;
+
+    // Поток вида "TEMP:23.45 TIME:2024-01-15 14:30:45.123"
+    std::string stream;
+    size_t line_count = 0;
+    while (stream.size() < (size_t(16) << 20)) {
+        char line[64];
+        int length = std::snprintf(line, sizeof(line), "TEMP:%d.%02d TIME:2024-01-15 14:%02d:%02d.%03d\n",
+                                   15 + static_cast<int>(line_count % 20), static_cast<int>(line_count % 100),
+                                   static_cast<int>(line_count / 60 % 60), static_cast<int>(line_count % 60),
+                                   static_cast<int>(line_count % 1000));
+        stream.append(line, static_cast<size_t>(length));
+        ++line_count;
+    }
+    const int REPEATS = 5;
+
+    // Порции - как их отдаёт read() при разной нагрузке на порт
+    for (size_t chunk : {size_t(32), size_t(256), size_t(4096)}) {
+        size_t bytes = 0;
+        std::function<void(const std::string&)> legacy_callback = [&](const std::string& line) {
+            bytes += line.size();
+        };
+        double legacy = measure_ns_per_item([&]() {
+            std::string partial;
+            for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+                legacy_split(partial, stream.data() + offset, std::min(chunk, stream.size() - offset), legacy_callback);
+            }
+        }, line_count, REPEATS);
+
+        std::function<void(std::string_view)> callback = [&](std::string_view line) {
+            bytes += line.size();
+        };
+        double splitter = measure_ns_per_item([&]() {
+            LineSplitter lines;
+            for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+                lines.feed(stream.data() + offset, std::min(chunk, stream.size() - offset), callback);
+            }
+        }, line_count, REPEATS);
+        benchmark_sink = static_cast<double>(bytes);
+
+        // 10 бит на байт в линии 8N1
+        double line_bytes = static_cast<double>(stream.size()) / line_count;
+        std::string suffix = ", " + std::to_string(chunk) + " B reads";
+        report("find/substr/erase" + suffix, legacy);
+        report("LineSplitter" + suffix, splitter);
+        std::cout << "    sustained: " << std::setprecision(0)
+                  << line_bytes * 10.0 / splitter * 1000.0 << " Mbaud vs "
+                  << line_bytes * 10.0 / legacy * 1000.0 << " Mbaud before" << std::endl;
+    }
+}
+
+// Прежний путь: substr + std::stof, время - через strptime и mktime
+bool legacy_parse(const std::string& data, float& temperature, std::time_t& timestamp) {
+    size_t temp_pos = data.find("TEMP:");
+    size_t time_pos = data.find("TIME:");
+    if (temp_pos == std::string::npos || time_pos == std::string::npos) return false;
+    try {
+        temperature = std::stof(data.substr(temp_pos + 5, data.find(' ', temp_pos) - temp_pos - 5));
+    } catch (...) {
+        return false;
+    }
+    std::tm tm = {};
+    tm.tm_isdst = -1;
+    if (strptime(data.c_str() + time_pos + 5, "%Y-%m-%d %H:%M:%S", &tm) == nullptr) return false;
+    timestamp = std::mktime(&tm);
+    return true;
+}
+
+void benchmark_device_line_parser() {
+    std::cout << "Device line parsing" << std::endl;
+
+    // Строки как у симулятора (std::to_string даёт 6 знаков после точки),
+    // подряд в одном буфере - так их отдаёт LineSplitter
+    const size_t COUNT = 1 << 20;
+    std::string buffer;
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i < COUNT; ++i) {
+        char line[64];
+        int length = std::snprintf(line, sizeof(line), "TEMP:%.6f TIME:2024-01-15 %02d:%02d:%02d.%03d",
+                                   15.0 + static_cast<double>(i % 20000) * 0.001234,
+                                   static_cast<int>(i / 3600 % 24), static_cast<int>(i / 60 % 60),
+                                   static_cast<int>(i % 60), static_cast<int>(i * 7 % 1000));
+        offsets.push_back(buffer.size());
+        buffer.append(line, static_cast<size_t>(length));
+    }
+    offsets.push_back(buffer.size());
+    std::vector<std::string_view> views;
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < COUNT; ++i) {
+        views.emplace_back(buffer.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        lines.emplace_back(views.back());
+    }
+
+    report("strptime/stof (legacy)", measure_ns_per_item([&]() {
+        double sum = 0.0;
+        float temperature;
+        std::time_t timestamp;
+        for (const auto& line : lines) {
+            if (legacy_parse(line, temperature, timestamp)) sum += temperature + static_cast<double>(timestamp);
+        }
+        benchmark_sink = sum;
+    }, COUNT, 1));
+
+    report("DeviceLineParser", measure_ns_per_item([&]() {
+        DeviceLineParser parser;
+        DeviceReading reading;
+        double sum = 0.0;
+        for (std::string_view line : views) {
+            if (parser.parse(line, reading)) sum += reading.temperature + static_cast<double>(reading.timestamp_ms);
+        }
+        benchmark_sink = sum;
+    }, COUNT, 10));
+}
+
+void benchmark_device_frames() {
+    std::cout << "Binary device frames vs text lines" << std::endl;
+
+    // Показания раз в 50 мс, как у симулятора с --interval 50
+    const size_t COUNT = 1 << 20;
+    std::vector<DeviceSample> samples(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        samples[i].timestamp_ms = 1705329045123 + static_cast<int64_t>(i) * 50;
+        samples[i].temperature = 15.0f + static_cast<float>(i % 2000) * 0.01f;
+    }
+
+    std::string text;
+    for (size_t i = 0; i < COUNT; ++i) {
+        // Строка симулятора: std::to_string даёт 6 знаков после точки
+        char line[64];
+        int length = std::snprintf(line, sizeof(line), "TEMP:%.6f TIME:2024-01-15 14:%02d:%02d.%03d\n",
+                                   samples[i].temperature, static_cast<int>(i / 1200 % 60),
+                                   static_cast<int>(i / 20 % 60), static_cast<int>(i * 50 % 1000));
+        text.append(line, static_cast<size_t>(length));
+    }
+
+    // 10 бит на байт в линии 8N1
+    const double BAUD = 9600.0;
+    double text_bytes = static_cast<double>(text.size()) / COUNT;
+    std::cout << "  text: " << std::setprecision(1) << text_bytes << " B/sample, "
+              << std::setprecision(0) << BAUD / 10.0 / text_bytes << " samples/s at 9600 baud" << std::endl;
+
+    for (size_t per_frame : {size_t(1), size_t(16), size_t(64)}) {
+        std::vector<unsigned char> frames;
+        for (size_t i = 0; i < COUNT; i += per_frame) {
+            encode_device_frame(0, samples.data() + i, std::min(per_frame, COUNT - i), frames);
+        }
+        double frame_bytes = static_cast<double>(frames.size()) / COUNT;
+        std::cout << "  frames of " << per_frame << ": " << std::setprecision(1) << frame_bytes << " B/sample, "
+                  << std::setprecision(0) << BAUD / 10.0 / frame_bytes << " samples/s at 9600 baud ("
+                  << std::setprecision(1) << text_bytes / frame_bytes << "x)" << std::endl;
+
+        if (per_frame != 16) continue;
+        report("text: split + DeviceLineParser", measure_ns_per_item([&]() {
+            DeviceStreamSplitter splitter;
+            DeviceLineParser parser;
+            DeviceReading reading;
+            double sum = 0.0;
+            auto on_line = [&](std::string_view line) {
+                if (parser.parse(line, reading)) sum += reading.temperature;
+            };
+            auto on_frame = [](std::string_view) {};
+            for (size_t offset = 0; offset < text.size(); offset += 256) {
+                splitter.feed(text.data() + offset, std::min<size_t>(256, text.size() - offset), on_line, on_frame);
+            }
+            benchmark_sink = sum;
+        }, COUNT, 3));
+        report("frames of 16: split + decode", measure_ns_per_item([&]() {
+            DeviceStreamSplitter splitter;
+            double sum = 0.0;
+            auto on_line = [](std::string_view) {};
+            DeviceFrame frame;
+            auto on_frame = [&](std::string_view raw) {
+                size_t length = 0;
+                decode_device_frame(reinterpret_cast<const unsigned char*>(raw.data()), raw.size(), frame, length);
+                for (size_t i = 0; i < frame.count; ++i) sum += frame.samples[i].temperature;
+            };
+            const char* data = reinterpret_cast<const char*>(frames.data());
+            for (size_t offset = 0; offset < frames.size(); offset += 256) {
+                splitter.feed(data + offset, std::min<size_t>(256, frames.size() - offset), on_line, on_frame);
+            }
+            benchmark_sink = sum;
+        }, COUNT, 3));
+    }
+}
+
+void benchmark_ingest_pipeline() {
+    std::cout << "Ingest: reader thread cost per line" << std::endl;
+
+    const char* db_path = "benchmark_ingest.db";
+    std::remove(db_path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    db.initialize(db_path);
+
+    const size_t COUNT = 1 << 16;
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < COUNT; ++i) {
+        lines.push_back("TEMP:" + std::to_string(20.0 + static_cast<double>(i % 1000) / 100.0));
+    }
+
+    // Прежний путь: поток чтения сам разбирает строку и пишет её в базу
+    const size_t SYNC_COUNT = 2000;
+    DeviceLineParser parser;
+    DeviceReading reading;
+    report("synchronous: parse + insert", measure_ns_per_item([&]() {
+        for (size_t i = 0; i < SYNC_COUNT; ++i) {
+            if (parser.parse(lines[i], reading)) db.add_measurement(std::time(nullptr), reading.temperature);
+        }
+    }, SYNC_COUNT, 1));
+
+    // Конвейер: поток чтения только копирует строку в своё кольцо
+    const std::string sensor_id = "bench";
+    IngestOptions options;
+    options.raw_overflow = OverflowPolicy::Block;
+    IngestPipeline pipeline(options);
+    pipeline.set_sink([&](const std::vector<IngestSample>& batch) {
+        std::vector<TemperatureData> data;
+        data.reserve(batch.size());
+        for (const auto& sample : batch) {
+            data.push_back({sample.timestamp, sample.temperature});
+        }
+        size_t stored = 0;
+        db.add_measurements(data, &stored);
+        return stored;
+    });
+    pipeline.start();
+    auto start = std::chrono::steady_clock::now();
+    double push_ns = measure_ns_per_item([&]() {
+        for (const auto& line : lines) {
+            pipeline.push_line(sensor_id, line);
+        }
+    }, COUNT, 3);
+    report("pipeline: push_line", push_ns);
+    pipeline.stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    IngestStats stats = pipeline.stats();
+    std::cout << "  end to end: " << std::setprecision(0) << static_cast<double>(stats.samples.processed) / seconds
+              << " lines/s stored in " << stats.batches << " batches" << std::endl;
+
+    db.cleanup();
+    std::remove(db_path);
+    std::remove((std::string(db_path) + "-wal").c_str());
+    std::remove((std::string(db_path) + "-shm").c_str());
+}
+
+#ifndef _WIN32
+void benchmark_network_ingest() {
+    std::cout << "Network ingest over loopback (listener + pipeline)" << std::endl;
+
+    // Block: замеряется пропускная способность, а не потери при всплеске
+    IngestOptions options;
+    options.raw_overflow = OverflowPolicy::Block;
+    IngestPipeline pipeline(options);
+    pipeline.start();
+    NetworkListener listener(0, 0, "127.0.0.1");
+    listener.set_callback([&](const std::string& sensor_id, std::string_view line) {
+        pipeline.push_line(sensor_id, line);
+    });
+    listener.start();
+
+    // Ждёт, пока поток показаний не затихнет; время - до последнего показания
+    auto measure = [&](const std::string& name, size_t sent, auto&& send) {
+        uint64_t before = pipeline.stats().samples.processed;
+        auto start = std::chrono::steady_clock::now();
+        send();
+        auto last_change = std::chrono::steady_clock::now();
+        uint64_t processed = before;
+        while (std::chrono::steady_clock::now() - last_change < std::chrono::milliseconds(200)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            uint64_t now_processed = pipeline.stats().samples.processed;
+            if (now_processed != processed) {
+                processed = now_processed;
+                last_change = std::chrono::steady_clock::now();
+            }
+        }
+        double seconds = std::chrono::duration<double>(last_change - start).count();
+        std::cout << "  " << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(9) << static_cast<double>(processed - before) / seconds << " samples/s, "
+                  << processed - before << " of " << sent << " stored" << std::endl;
+    };
+
+    const size_t COUNT = 200000;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(listener.udp_port()));
+    int udp = socket(AF_INET, SOCK_DGRAM, 0);
+
+    for (size_t per_datagram : {size_t(1), size_t(32)}) {
+        std::vector<std::string> datagrams;
+        for (size_t i = 0; i < COUNT; i += per_datagram) {
+            std::string datagram;
+            for (size_t j = i; j < std::min(COUNT, i + per_datagram); ++j) {
+                datagram += "sensor-" + std::to_string(j % 16) + " TEMP:" + std::to_string(20 + j % 10) + ".5\n";
+            }
+            datagrams.push_back(datagram);
+        }
+        measure("UDP, " + std::to_string(per_datagram) + " lines per datagram", COUNT, [&]() {
+            for (size_t i = 0; i < datagrams.size(); ++i) {
+                sendto(udp, datagrams[i].data(), datagrams[i].size(), 0,
+                       reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+                // Отправитель быстрее приёмника; даём ядру не переполнить буфер сокета
+                if (i % 64 == 63) std::this_thread::yield();
+            }
+        });
+    }
+    close(udp);
+
+    std::string stream;
+    for (size_t i = 0; i < COUNT; ++i) {
+        stream += "sensor-" + std::to_string(i % 16) + " TEMP:" + std::to_string(20 + i % 10) + ".5\n";
+    }
+    int tcp = socket(AF_INET, SOCK_STREAM, 0);
+    addr.sin_port = htons(static_cast<uint16_t>(listener.tcp_port()));
+    connect(tcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    measure("TCP, one connection", COUNT, [&]() {
+        for (size_t offset = 0; offset < stream.size();) {
+            ssize_t written = write(tcp, stream.data() + offset, stream.size() - offset);
+            if (written <= 0) break;
+            offset += static_cast<size_t>(written);
+        }
+    });
+    close(tcp);
+
+    listener.stop();
+    pipeline.stop();
+}
+#endif
+
+int main() {
+    benchmark_simd_kernels();
+    benchmark_calculator_readers();
+    benchmark_parallel_aggregation();
+    benchmark_bucket_policies();
+    benchmark_line_framing();
+    benchmark_device_line_parser();
+    benchmark_device_frames();
+    benchmark_ingest_pipeline();
+#ifndef _WIN32
+    benchmark_network_ingest();
+#endif
+    return 0;
+}
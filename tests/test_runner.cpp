@@ -2,6 +2,45 @@
 #include <cassert>
 #include "temperature_calculator.h"
 #include "logger.h"
+#include "gorilla_codec.h"
+#include "database_manager.h"
+#include "measurement_cache.h"
+#include "segmented_log.h"
+#include "binary_log.h"
+#include "simd_kernels.h"
+#include "quantile_sketch.h"
+#include "thread_pool.h"
+#include "port_reader.h"
+#include "device_manager.h"
+#include "serial_port.h"
+#include "device_line_parser.h"
+#include "device_frame.h"
+#include "spsc_ring.h"
+#include "ingest_pipeline.h"
+#include "network_listener.h"
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <sqlite3.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 
 void test_temperature_calculator() {
     std::cout << "Testing TemperatureCalculator..." << std::endl;
@@ -21,7 +60,1720 @@ void test_temperature_calculator() {
     std::cout << "All tests passed!" << std::endl;
 }
 
+void test_time_series_ring() {
+    std::cout << "Testing TimeSeriesRing..." << std::endl;
+    
+    TimeSeriesRing ring(8);
+    for (int i = 0; i < 12; ++i) {
+        assert(ring.push(100 + i * 10, static_cast<float>(i)));
+    }
+    // Ёмкость 8: остались записи 4..11, данные переходят через конец массива
+    assert(ring.size() == 8 && ring.timestamp_at(0) == 140 && ring.value_at(7) == 11.0f);
+    assert(!ring.push(150, 0.0f));
+    assert(ring.push(210, 11.5f) && ring.size() == 8);
+    
+    assert(ring.lower_bound(0) == 0);
+    assert(ring.lower_bound(150) == 0);
+    assert(ring.lower_bound(185) == 4);
+    assert(ring.upper_bound(190) == 5);
+    assert(ring.upper_bound(210) == 8);
+    
+    // Диапазон переходит через конец массива
+    std::time_t timestamps[8];
+    float values[8];
+    assert(ring.copy(ring.lower_bound(160), ring.upper_bound(200), timestamps, values) == 5);
+    for (size_t i = 0; i < 5; ++i) {
+        assert(timestamps[i] == static_cast<std::time_t>(160 + i * 10) && values[i] == static_cast<float>(6 + i));
+    }
+    assert(ring.copy(ring.lower_bound(200), ring.size(), nullptr, values) == 3 && values[2] == 11.5f);
+    assert(ring.copy(5, 3, timestamps, values) == 0);
+    
+    ring.evict_before(185);
+    assert(ring.size() == 4 && ring.timestamp_at(0) == 190);
+    ring.evict_before(1000);
+    assert(ring.empty() && ring.push(50, 1.0f));
+    
+    std::cout << "TimeSeriesRing tests passed!" << std::endl;
+}
+
+void test_sliding_window() {
+    std::cout << "Testing sliding window statistics..." << std::endl;
+    
+    TemperatureCalculator calc({60, 3600});
+    WindowStats stats;
+    assert(!calc.get_window_stats(86400, stats));
+    assert(calc.get_window_stats(60, stats) && stats.count == 0);
+    
+    // Сверяем с прямым пересчётом по последней минуте
+    std::vector<TemperatureData> history;
+    for (int i = 0; i < 500; ++i) {
+        std::time_t ts = 1000 + i * 7;
+        float temp = 20.0f + static_cast<float>((i * 37) % 23) * 0.5f;
+        calc.add_measurement(ts, temp);
+        history.push_back({ts, temp});
+        
+        double sum = 0.0, sq = 0.0;
+        float lo = 1e9f, hi = -1e9f;
+        long long count = 0;
+        for (const auto& data : history) {
+            if (data.timestamp > ts - 60) {
+                sum += data.temperature;
+                sq += static_cast<double>(data.temperature) * data.temperature;
+                lo = std::min(lo, data.temperature);
+                hi = std::max(hi, data.temperature);
+                ++count;
+            }
+        }
+        double mean = sum / count;
+        
+        assert(calc.get_window_stats(60, stats));
+        assert(stats.count == count && stats.min == lo && stats.max == hi);
+        assert(stats.last == temp && stats.last_timestamp == ts);
+        assert(std::fabs(stats.mean - mean) < 1e-9);
+        assert(std::fabs(stats.variance - (sq / count - mean * mean)) < 1e-6);
+    }
+    
+    // Очистка сдвигает окна без новых измерений
+    calc.cleanup_old_data(1000 + 499 * 7 + 60);
+    assert(calc.get_window_stats(60, stats) && stats.count == 0);
+    assert(calc.get_window_stats(3600, stats) && stats.count == 500);
+    
+    std::cout << "Sliding window tests passed!" << std::endl;
+}
+
+void test_calculator_concurrent_reads() {
+    std::cout << "Testing lock-free TemperatureCalculator readers..." << std::endl;
+    
+    // Маленький буфер, чтобы писатель постоянно затирал старые записи
+    TemperatureCalculator calc({60}, 4096);
+    std::time_t start = std::time(nullptr) - 50000;
+    const int COUNT = 50000;
+    auto value_of = [](std::time_t ts) { return static_cast<float>(ts % 1000); };
+    
+    std::atomic<bool> done{false};
+    std::atomic<long long> snapshots{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                // Срез непрерывен и не содержит затёртых значений
+                auto data = calc.get_measurements_last_24h();
+                for (size_t i = 0; i < data.size(); ++i) {
+                    assert(data[i].temperature == value_of(data[i].timestamp));
+                    assert(i == 0 || data[i].timestamp == data[i - 1].timestamp + 1);
+                }
+                assert(data.size() <= 4096);
+                
+                WindowStats stats;
+                assert(calc.get_window_stats(60, stats));
+                assert(stats.count <= 60);
+                assert(stats.count == 0 || stats.last == value_of(stats.last_timestamp));
+                ++snapshots;
+            }
+        });
+    }
+    
+    for (int i = 0; i < COUNT; ++i) {
+        assert(calc.add_measurement(start + i, value_of(start + i)));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    auto data = calc.get_measurements_last_24h();
+    assert(data.size() == 4096 && data.back().timestamp == start + COUNT - 1);
+    
+    std::cout << "Lock-free reader tests passed (" << snapshots << " snapshots)" << std::endl;
+}
+
+void test_simd_kernels() {
+    std::cout << "Testing aggregation kernels..." << std::endl;
+    
+    // Длина не кратна ширине векторов - проверяется и хвост
+    const size_t COUNT = 10007;
+    std::vector<float> values(COUNT);
+    std::vector<std::time_t> timestamps(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        values[i] = 15.0f + static_cast<float>((i * 37) % 101) * 0.1f;
+        timestamps[i] = 5000 + static_cast<std::time_t>(i) * 2;
+    }
+    values[COUNT - 1] = -40.0f;
+    
+    assert(set_simd_level(SimdLevel::SCALAR));
+    KernelStats expected = aggregate_values(values.data(), COUNT);
+    KernelStats expected_range = aggregate_values_in_range(timestamps.data(), values.data(), COUNT, 5101, 9000);
+    assert(expected.count == static_cast<long long>(COUNT) && expected.min == -40.0f && expected.max == 25.0f);
+    assert(expected_range.count == 1950);
+    assert(expected_range.first_timestamp == 5102 && expected_range.last_timestamp == 9000);
+    
+    const SimdLevel levels[] = {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels) {
+        if (!set_simd_level(level)) continue;
+        for (Accumulation accumulation : {Accumulation::DOUBLE, Accumulation::KAHAN}) {
+            KernelStats stats = aggregate_values(values.data(), COUNT, accumulation);
+            assert(stats.count == expected.count && stats.min == expected.min && stats.max == expected.max);
+            assert(std::fabs(stats.mean - expected.mean) < 1e-9);
+            assert(std::fabs(stats.variance - expected.variance) < 1e-9);
+            
+            KernelStats range = aggregate_values_in_range(timestamps.data(), values.data(), COUNT,
+                                                          5101, 9000, accumulation);
+            assert(range.count == expected_range.count);
+            assert(range.min == expected_range.min && range.max == expected_range.max);
+            assert(range.first_timestamp == expected_range.first_timestamp);
+            assert(range.last_timestamp == expected_range.last_timestamp);
+            assert(std::fabs(range.mean - expected_range.mean) < 1e-9);
+        }
+    }
+    set_simd_level(detected_simd_level());
+    
+    std::cout << "Aggregation kernel tests passed (" << simd_level_name(detected_simd_level()) << ")" << std::endl;
+}
+
+void test_quantile_sketch() {
+    std::cout << "Testing quantile sketch..." << std::endl;
+    
+    // Точные процентили по отсортированной копии
+    std::vector<float> values;
+    for (int i = 0; i < 20000; ++i) {
+        values.push_back(-30.0f + static_cast<float>((i * 7919LL) % 7001) * 0.01f);
+    }
+    values.push_back(0.0f);
+    
+    QuantileSketch whole, first_half, second_half;
+    for (size_t i = 0; i < values.size(); ++i) {
+        whole.add(values[i]);
+        (i % 2 ? first_half : second_half).add(values[i]);
+    }
+    std::vector<float> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    
+    for (double q : {0.0, 0.05, 0.5, 0.95, 0.99, 1.0}) {
+        float exact = sorted[static_cast<size_t>(q * (sorted.size() - 1))];
+        float estimate = whole.quantile(q);
+        assert(std::fabs(estimate - exact) <= std::fabs(exact) * QuantileSketch::RELATIVE_ACCURACY + 1e-3f);
+    }
+    
+    // Слияние даёт тот же скетч, что и добавление всех значений
+    first_half.merge(second_half);
+    assert(first_half.count() == whole.count());
+    assert(first_half.serialize() == whole.serialize());
+    
+    std::vector<uint8_t> data = whole.serialize();
+    QuantileSketch restored;
+    assert(QuantileSketch::deserialize(data.data(), data.size(), restored));
+    assert(restored.count() == whole.count() && restored.quantile(0.95) == whole.quantile(0.95));
+    assert(!QuantileSketch::deserialize(data.data(), data.size() - 1, restored));
+    assert(QuantileSketch::deserialize(nullptr, 0, restored) && restored.empty());
+    assert(restored.percentiles().count == 0);
+    
+    // Часовые скетчи калькулятора: сутки сливаются из часов (7200, 10800] и (10800, 14400]
+    TemperatureCalculator calc({60});
+    for (int i = 0; i < 2 * 3600; ++i) {
+        calc.add_measurement(7201 + i, i < 3600 ? 10.0f : 30.0f);
+    }
+    TemperaturePercentiles hour = calc.calculate_hourly_percentiles(7200 + 1800);
+    assert(hour.count == 3600 && std::fabs(hour.p50 - 10.0f) < 0.1f);
+    TemperaturePercentiles day = calc.calculate_daily_percentiles(7200);
+    assert(day.count == 7200 && std::fabs(day.p5 - 10.0f) < 0.1f && std::fabs(day.p95 - 30.0f) < 0.2f);
+    calc.cleanup_old_data(7201 + 3600 + 86400);
+    assert(calc.calculate_hourly_percentiles(7200).count == 0);
+    assert(calc.calculate_hourly_percentiles(10800).count == 3600);
+    
+    std::cout << "Quantile sketch tests passed!" << std::endl;
+}
+
+void test_parallel_aggregation() {
+    std::cout << "Testing parallel range aggregation..." << std::endl;
+    
+    // Каждый индекс обрабатывается ровно один раз, в том числе во вложенных вызовах
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallel_for(hits.size(), [&](size_t i) {
+        ++hits[i];
+        pool.parallel_for(3, [&](size_t) { ++hits[(i + 1) % hits.size()]; });
+    });
+    for (const auto& hit : hits) {
+        assert(hit == 4);
+    }
+    
+    // Сводка по частям совпадает с последовательным подсчётом
+    const int COUNT = 300000;
+    TemperatureCalculator calc({60}, COUNT);
+    double sum = 0.0;
+    for (int i = 0; i < COUNT; ++i) {
+        float temp = -10.0f + static_cast<float>((i * 7919LL) % 4001) * 0.01f;
+        calc.add_measurement(1000 + i, temp);
+        if (i >= 100) sum += temp;
+    }
+    
+    for (size_t threads : {1, 3}) {
+        ThreadPool::set_shared_size(threads);
+        TemperatureAggregate aggregate = calc.calculate_aggregate(1099, 1000 + COUNT);
+        assert(aggregate.count == COUNT - 100 && aggregate.sketch.count() == COUNT - 100);
+        assert(aggregate.first_timestamp == 1100 && aggregate.last_timestamp == 1000 + COUNT - 1);
+        assert(aggregate.min_temp == -10.0f && aggregate.max_temp == 30.0f);
+        assert(std::fabs(aggregate.sum - sum) < 1e-3);
+        assert(std::fabs(aggregate.percentiles().p50 - 10.0f) < 0.1f);
+    }
+    ThreadPool::set_shared_size(0);
+    
+    std::cout << "Parallel aggregation tests passed!" << std::endl;
+}
+
+void test_calculator_policies() {
+    std::cout << "Testing calculator bucket policies..." << std::endl;
+    
+    // Арифметика корзин считается при компиляции, отрицательные метки - вниз
+    static_assert(FixedBuckets<10>::start_of(125) == 120, "10 s bucket");
+    static_assert(FixedBuckets<60>::start_of(-1) == -60, "negative timestamp");
+    static_assert(FixedBuckets<3600>::start_of(7200) == 7200, "aligned timestamp");
+    static_assert(DailyTemperatureCalculator::bucket_start(86400 * 3 + 5) == 86400 * 3, "daily bucket");
+    assert(RuntimeBuckets{60}.start_of(-1) == FixedBuckets<60>::start_of(-1));
+    
+    // 10-секундные корзины без скетчей: средние есть, процентилей нет
+    TenSecondTemperatureCalculator fine({60});
+    for (int i = 0; i < 35; ++i) {
+        fine.add_measurement(1001 + i, static_cast<float>(i / 10));
+    }
+    std::vector<TemperatureBucket> buckets = fine.calculate_buckets(1005, 1030);
+    assert(buckets.size() == 3);
+    assert(buckets[0].bucket_start == 1000 && buckets[0].aggregate.count == 10);
+    assert(buckets[2].bucket_start == 1020 && buckets[2].aggregate.average() == 2.0f);
+    assert(buckets[1].aggregate.sketch.empty());
+    assert(fine.calculate_percentiles(1000, 1040).count == 0);
+    fine.cleanup_old_data(1034 + 3600 - 10);
+    assert(fine.calculate_buckets(0, 5000).front().bucket_start == 1020);
+    
+    // Суточные корзины: процентили по суткам, неделя истории
+    DailyTemperatureCalculator daily({3600}, 4096);
+    for (int day = 0; day < 3; ++day) {
+        for (int i = 0; i < 24; ++i) {
+            daily.add_measurement(86400 * day + 3600 * (i + 1), static_cast<float>(day * 10 + i % 2));
+        }
+    }
+    buckets = daily.calculate_buckets(0, 86400 * 3);
+    assert(buckets.size() == 3 && buckets[1].aggregate.count == 24);
+    assert(buckets[1].aggregate.sketch.count() == 24 && buckets[1].aggregate.min_temp == 10.0f);
+    assert(daily.calculate_percentiles(86400, 86400 * 2).count == 24);
+    assert(daily.calculate_daily_percentiles(0).count == 24);
+    daily.cleanup_old_data(86400 * 9 + 1);
+    assert(daily.calculate_percentiles(0, 86400 * 3).count == 24);
+    
+    // Средние, процентили и ряд корзин за один час видят одни и те же измерения
+    HourlyTemperatureCalculator hourly({60});
+    for (std::time_t t = 36000 - 5; t <= 36000 + 2 * 3600 + 5; ++t) {
+        hourly.add_measurement(t, t % 7 == 0 ? 40.0f : 20.0f);
+    }
+    for (std::time_t hour : {std::time_t(36000), std::time_t(39600)}) {
+        TemperatureAggregate aggregate = hourly.calculate_aggregate(hour, hour + 3600);
+        buckets = hourly.calculate_buckets(hour, hour + 3600);
+        assert(aggregate.count == 3600 && aggregate.first_timestamp == hour + 1);
+        assert(hourly.calculate_hourly_percentiles(hour).count == aggregate.count);
+        assert(buckets.size() == 1 && buckets[0].bucket_start == hour);
+        assert(buckets[0].aggregate.count == aggregate.count);
+        assert(std::fabs(buckets[0].aggregate.sum - aggregate.sum) < 1e-3);
+        assert(hourly.calculate_hourly_average(hour) == aggregate.average());
+    }
+    
+    std::cout << "Calculator policy tests passed!" << std::endl;
+}
+
+void test_gorilla_codec() {
+    std::cout << "Testing GorillaCodec..." << std::endl;
+    
+    // Сутки данных с частотой 1 Гц и медленно меняющейся температурой
+    GorillaEncoder encoder;
+    std::time_t start = 1700000000;
+    const int samples = 86400;
+    for (int i = 0; i < samples; ++i) {
+        float temp = 20.0f + static_cast<float>((i / 600) % 50) * 0.1f;
+        encoder.append(start + i, temp);
+    }
+    
+    auto block = encoder.finish();
+    GorillaDecoder decoder(block);
+    assert(decoder.count() == samples);
+    
+    std::time_t ts;
+    float temp;
+    int decoded = 0;
+    while (decoder.next(ts, temp)) {
+        assert(ts == start + decoded);
+        assert(temp == 20.0f + static_cast<float>((decoded / 600) % 50) * 0.1f);
+        ++decoded;
+    }
+    assert(decoded == samples);
+    
+    // Не менее чем 10-кратное сжатие относительно 16-байтовых записей
+    assert(block.size() * 10 < samples * 16);
+    
+    // Нерегулярные интервалы и произвольные значения
+    GorillaEncoder irregular;
+    irregular.append(100, -5.5f);
+    irregular.append(90, 1000.25f);
+    irregular.append(100000, 0.0f);
+    irregular.append(100001, 0.0f);
+    auto block2 = irregular.finish();
+    GorillaDecoder decoder2(block2);
+    assert(decoder2.next(ts, temp) && ts == 100 && temp == -5.5f);
+    assert(decoder2.next(ts, temp) && ts == 90 && temp == 1000.25f);
+    assert(decoder2.next(ts, temp) && ts == 100000 && temp == 0.0f);
+    assert(decoder2.next(ts, temp) && ts == 100001 && temp == 0.0f);
+    assert(!decoder2.next(ts, temp));
+    
+    std::cout << "GorillaCodec tests passed!" << std::endl;
+}
+
+void test_measurement_cache() {
+    std::cout << "Testing MeasurementCache..." << std::endl;
+    
+    MeasurementCache cache(1000);
+    std::vector<TemperatureData> rows;
+    
+    // Пока покрытие не задано, кэш не отвечает на запросы диапазонов
+    assert(!cache.query(0, 100, 10, rows));
+    cache.set_coverage_start(0);
+    
+    for (int i = 0; i < 5000; ++i) {
+        cache.push(1000 + i, static_cast<float>(1000 + i));
+    }
+    
+    TemperatureData last;
+    assert(cache.get_last(last) && last.timestamp == 5999 && last.temperature == 5999.0f);
+    
+    // Свежий диапазон - из кэша, от новых к старым
+    assert(cache.query(5900, 5999, 0, rows));
+    assert(rows.size() == 100 && rows.front().timestamp == 5999 && rows.back().timestamp == 5900);
+    
+    // Вытесненный диапазон - в хранилище
+    assert(!cache.query(1000, 2000, 0, rows));
+    
+    // Но N последних записей кэш отдаёт при любом from
+    assert(cache.query(0, 0x7fffffff, 10, rows) && rows.size() == 10);
+    
+    // Запись не по порядку сдвигает границу покрытия
+    cache.push(5500, 5500.0f);
+    assert(!cache.query(5400, 5999, 0, rows));
+    assert(cache.query(5501, 5999, 0, rows));
+    
+    // Читатели параллельно с писателем видят только согласованные данные
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (int i = 0; i < 200000; ++i) {
+            cache.push(6000 + i, static_cast<float>(6000 + i));
+        }
+        done = true;
+    });
+    while (!done) {
+        if (cache.query(0, 0x7fffffff, 50, rows)) {
+            for (const auto& row : rows) {
+                assert(static_cast<float>(row.timestamp) == row.temperature);
+            }
+        }
+    }
+    writer.join();
+    
+    std::cout << "MeasurementCache tests passed!" << std::endl;
+}
+
+void remove_database(const std::string& path) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::filesystem::remove(path + suffix);
+    }
+}
+
+TemperatureAggregate brute_force_aggregate(const std::vector<TemperatureData>& rows,
+                                           std::time_t from, std::time_t to) {
+    TemperatureAggregate result;
+    for (const auto& row : rows) {
+        if (row.timestamp >= from && (to == 0 || row.timestamp <= to)) {
+            result.add(row.timestamp, row.temperature);
+        }
+    }
+    return result;
+}
+
+void assert_same_aggregate(const TemperatureAggregate& actual, const TemperatureAggregate& expected) {
+    assert(actual.count == expected.count);
+    if (expected.count == 0) return;
+    assert(actual.first_timestamp == expected.first_timestamp);
+    assert(actual.last_timestamp == expected.last_timestamp);
+    assert(actual.min_temp == expected.min_temp);
+    assert(actual.max_temp == expected.max_temp);
+    assert(std::fabs(actual.sum - expected.sum) < 1e-3 * std::max(1.0, std::fabs(expected.sum)));
+}
+
+void test_database_aggregate() {
+    std::cout << "Testing DatabaseManager::get_aggregate..." << std::endl;
+    
+    const std::string path = "test_aggregate.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    
+    // Три закрытых часовых блока и незакрытый четвёртый
+    const std::time_t base = 1709211600; // 2024-02-29 13:00:00 UTC
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base; t < base + 3 * 3600 + 1800; t += 7) {
+        float temperature = 20.0f + 5.0f * std::sin(static_cast<float>(t - base) / 900.0f);
+        rows.push_back({t, temperature});
+        assert(db.add_measurement(t, temperature));
+    }
+    
+    const std::time_t ranges[][2] = {
+        {0, 0},                                 // всё
+        {base + 1000, base + 8000},             // режет два закрытых блока
+        {base + 3600, base + 7199},             // ровно один закрытый блок
+        {base, base + 2 * 3600 + 1},            // целые блоки и краешек следующего
+        {base + 5000, 0},                       // хвост закрытых и весь открытый блок
+        {base + 3 * 3600 + 100, base + 3 * 3600 + 900}, // внутри открытого блока
+        {base + 2 * 3600 + 3000, base + 3 * 3600 + 60}, // стык закрытого и открытого
+        {base + 3600 + 1, base + 3600 + 6},     // между соседними измерениями
+        {base - 7200, base - 1},                // до начала данных
+    };
+    for (const auto& range : ranges) {
+        assert_same_aggregate(db.get_aggregate(range[0], range[1]),
+                              brute_force_aggregate(rows, range[0], range[1]));
+    }
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::cout << "DatabaseManager::get_aggregate tests passed!" << std::endl;
+}
+
+bool exec_sql(const std::string& path, const char* sql) {
+    sqlite3* conn = nullptr;
+    bool ok = sqlite3_open(path.c_str(), &conn) == SQLITE_OK &&
+              sqlite3_exec(conn, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+    sqlite3_close(conn);
+    return ok;
+}
+
+void test_database_batch_rollback() {
+    std::cout << "Testing DatabaseManager::add_measurements rollback..." << std::endl;
+    
+    const std::string path = "test_batch.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    
+    const std::time_t base = 1709211600;
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base + 3000; t < base + 3500; t += 10) {
+        rows.push_back({t, 20.0f});
+    }
+    size_t stored = 0;
+    assert(db.add_measurements(rows, &stored) && stored == rows.size());
+    
+    // Ошибка строки внутри пачки: сохраняется начало
+    assert(exec_sql(path, "CREATE TRIGGER reject_hot BEFORE INSERT ON measurement_tail "
+                          "WHEN NEW.temperature > 100 BEGIN SELECT RAISE(ABORT, 'hot'); END;"));
+    std::vector<TemperatureData> batch = {{base + 3500, 21.0f}, {base + 3510, 22.0f}, {base + 3520, 150.0f}};
+    assert(!db.add_measurements(batch, &stored) && stored == 2);
+    rows.push_back(batch[0]);
+    rows.push_back(batch[1]);
+    assert(db.get_last_measurement().timestamp == base + 3510);
+    
+    // Откат всей транзакции при фиксации: пачка закрывает блок по пути, но
+    // ни блок, ни строки, ни кэш не должны измениться
+    assert(exec_sql(path, "CREATE TRIGGER reject_all BEFORE INSERT ON measurement_tail "
+                          "WHEN NEW.temperature < -100 BEGIN SELECT RAISE(ROLLBACK, 'cold'); END;"));
+    batch = {{base + 3590, 23.0f}, {base + 3610, 24.0f}, {base + 3620, -150.0f}};
+    assert(!db.add_measurements(batch, &stored) && stored == 0);
+    
+    assert_same_aggregate(db.get_aggregate(), brute_force_aggregate(rows, 0, 0));
+    TemperatureData last = db.get_last_measurement();
+    assert(last.timestamp == base + 3510 && last.temperature == 22.0f);
+    assert(db.get_measurements(base + 3500, 0, 0).size() == 2);
+    
+    // Последующая запись продолжает тот же незакрытый блок
+    assert(db.add_measurement(base + 3600, 25.0f));
+    rows.push_back({base + 3600, 25.0f});
+    assert_same_aggregate(db.get_aggregate(), brute_force_aggregate(rows, 0, 0));
+    
+    // После переоткрытия база совпадает с тем, что было видно в памяти
+    db.cleanup();
+    assert(db.initialize(path));
+    assert_same_aggregate(db.get_aggregate(), brute_force_aggregate(rows, 0, 0));
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::cout << "DatabaseManager::add_measurements rollback tests passed!" << std::endl;
+}
+
+void test_storage_tiers() {
+    std::cout << "Testing storage tiers..." << std::endl;
+    
+    std::vector<StorageTier> tiers;
+    assert(DatabaseManager::parse_storage_tiers("raw:7d,1m:30d,15m:90d,1h:365d", tiers));
+    assert(tiers.size() == 4);
+    assert(tiers[0].resolution_seconds == 0 && tiers[0].retention_seconds == 7 * 86400);
+    assert(tiers[1].resolution_seconds == 60 && tiers[1].retention_seconds == 30 * 86400);
+    assert(tiers[2].resolution_seconds == 900 && tiers[3].resolution_seconds == 3600);
+    assert(DatabaseManager::parse_storage_tiers("raw:3600,30s:2h", tiers));
+    assert(tiers[0].retention_seconds == 3600 && tiers[1].resolution_seconds == 30);
+    
+    // Разбор не меняет результат при ошибке
+    for (const char* spec : {"", "raw", "raw:7x", "raw:0d", "1m:-5d", "raw:7d,1m", "raw:7d,abc:1d"}) {
+        assert(!DatabaseManager::parse_storage_tiers(spec, tiers));
+        assert(tiers.size() == 2);
+    }
+    
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(!db.set_storage_tiers({}));
+    assert(!db.set_storage_tiers({{60, 86400}}));                       // первый не сырой
+    assert(!db.set_storage_tiers({{0, 86400}, {60, 0}}));               // нулевой срок
+    assert(!db.set_storage_tiers({{0, 86400}, {3600, 86400}, {60, 86400}})); // не по возрастанию
+    assert(!db.set_storage_tiers({{0, 86400}, {60, 86400}, {90, 86400}}));   // не кратно
+    assert(db.set_storage_tiers({{0, 86400}, {60, 86400}, {3600, 86400}}));
+    
+    std::cout << "Storage tier tests passed!" << std::endl;
+}
+
+std::map<std::time_t, TemperatureAggregate> brute_force_buckets(const std::vector<TemperatureData>& rows,
+                                                                std::time_t from, std::time_t to,
+                                                                std::time_t step) {
+    std::map<std::time_t, TemperatureAggregate> buckets;
+    for (const auto& row : rows) {
+        if (row.timestamp >= from && row.timestamp <= to) {
+            buckets[row.timestamp / step * step].add(row.timestamp, row.temperature);
+        }
+    }
+    return buckets;
+}
+
+void assert_same_buckets(const std::vector<TemperatureBucket>& actual,
+                         const std::map<std::time_t, TemperatureAggregate>& expected) {
+    assert(actual.size() == expected.size());
+    auto it = expected.begin();
+    for (const auto& bucket : actual) {
+        assert(bucket.bucket_start == it->first);
+        assert_same_aggregate(bucket.aggregate, it->second);
+        ++it;
+    }
+}
+
+void test_storage_compaction() {
+    std::cout << "Testing storage compaction..." << std::endl;
+    
+    const std::string path = "test_compaction.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    assert(db.set_storage_tiers({{0, 86400}, {60, 2 * 86400}, {3600, 30 * 86400}}));
+    
+    // Трое суток измерений раз в 30 секунд
+    const std::time_t base = 1709164800; // 2024-02-29 00:00:00 UTC
+    const std::time_t now = base + 3 * 86400;
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base; t < now; t += 30) {
+        rows.push_back({t, 20.0f + 5.0f * std::sin(static_cast<float>(t - base) / 5000.0f)});
+    }
+    assert(db.import_measurements(rows));
+    
+    db.maintain_storage(now);
+    
+    // Сырые данные старше суток удалены, но агрегаты уровней совпадают с исходными
+    assert(db.get_aggregate(0, 0).count < static_cast<long long>(rows.size()));
+    assert(db.get_aggregate(base, now - 86400 - 3600).count == 0);
+    assert_same_buckets(db.get_downsampled(base, now - 1, 3600),
+                        brute_force_buckets(rows, base, now - 1, 3600));
+    assert_same_buckets(db.get_downsampled(base + 86400, now - 1, 600),
+                        brute_force_buckets(rows, base + 86400, now - 1, 600));
+    assert_same_buckets(db.get_downsampled(now - 7200, now - 1, 60),
+                        brute_force_buckets(rows, now - 7200, now - 1, 60));
+    
+    // Повторный запуск ничего не меняет
+    db.maintain_storage(now);
+    assert_same_buckets(db.get_downsampled(base, now - 1, 3600),
+                        brute_force_buckets(rows, base, now - 1, 3600));
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::cout << "Storage compaction tests passed!" << std::endl;
+}
+
+void test_storage_late_rows() {
+    std::cout << "Testing late rows below the compaction watermark..." << std::endl;
+    
+    const std::string path = "test_late_rows.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    assert(db.set_storage_tiers({{0, 86400}, {60, 2 * 86400}, {3600, 30 * 86400}}));
+    
+    const std::time_t base = 1709164800;
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base; t < base + 600; ++t) {
+        rows.push_back({t, 20.0f});
+    }
+    assert(db.add_measurements(rows));
+    db.maintain_storage(base + 7200);
+    
+    // Опоздавшие строки - пачкой и по одной - ниже уже построенных уровней
+    std::vector<TemperatureData> late = {{base + 30, 100.0f}, {base + 4000, -5.0f}};
+    assert(db.add_measurements(late));
+    assert(db.add_measurement(base + 90, 50.0f));
+    rows.insert(rows.end(), late.begin(), late.end());
+    rows.push_back({base + 90, 50.0f});
+    db.maintain_storage(base + 7200);
+    
+    assert_same_aggregate(db.get_aggregate(base, base + 59), brute_force_aggregate(rows, base, base + 59));
+    assert_same_buckets(db.get_downsampled(base, base + 7199, 60),
+                        brute_force_buckets(rows, base, base + 7199, 60));
+    assert_same_buckets(db.get_downsampled(base, base + 7199, 3600),
+                        brute_force_buckets(rows, base, base + 7199, 3600));
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::cout << "Late row tests passed!" << std::endl;
+}
+
+void test_storage_compaction_failure() {
+    std::cout << "Testing storage compaction failure..." << std::endl;
+    
+    const std::string path = "test_compaction_failure.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    assert(db.set_storage_tiers({{0, 86400}, {60, 30 * 86400}}));
+    
+    const std::time_t base = 1709164800;
+    const std::time_t now = base + 2 * 86400;
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base; t < now; t += 30) {
+        rows.push_back({t, 15.0f + static_cast<float>((t - base) % 3600) / 360.0f});
+    }
+    assert(db.import_measurements(rows));
+    
+    // Прореживание доходит до полудня первых суток и дальше не удаётся
+    std::string trigger = "CREATE TRIGGER reject_rollups BEFORE INSERT ON rollups WHEN NEW.bucket_start >= " +
+                          std::to_string(base + 12 * 3600) + " BEGIN SELECT RAISE(ABORT, 'full'); END;";
+    assert(exec_sql(path, trigger.c_str()));
+    db.maintain_storage(now);
+    assert(db.get_aggregate(0, 0).count == static_cast<long long>(rows.size()));
+    
+    // Когда прореживание проходит, удаляются сырые данные старше срока
+    assert(exec_sql(path, "DROP TRIGGER reject_rollups"));
+    db.maintain_storage(now);
+    assert(db.get_aggregate(0, 0).count < static_cast<long long>(rows.size()));
+    assert_same_buckets(db.get_downsampled(base, now - 1, 60),
+                        brute_force_buckets(rows, base, now - 1, 60));
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::vector<StorageTier> defaults;
+    assert(DatabaseManager::parse_storage_tiers("raw:7d,1m:30d,15m:90d,1h:365d,1d:3650d", defaults));
+    assert(db.set_storage_tiers(defaults));
+    
+    std::cout << "Storage compaction failure tests passed!" << std::endl;
+}
+
+std::string format_csv(const std::vector<TemperatureData>& rows) {
+    std::string out;
+    for (const auto& row : rows) {
+        out += std::to_string(row.timestamp) + "," + std::to_string(row.temperature) + "\n";
+    }
+    return out;
+}
+
+void test_database_export() {
+    std::cout << "Testing DatabaseManager::export_measurements..." << std::endl;
+    
+    const std::string path = "test_export.db";
+    remove_database(path);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    
+    // Десять часовых блоков загрузкой и незакрытый блок обычной записью
+    const std::time_t base = 1709164800;
+    std::vector<TemperatureData> rows;
+    for (std::time_t t = base; t < base + 10 * 3600; ++t) {
+        rows.push_back({t, static_cast<float>(t % 1000) / 10.0f});
+    }
+    assert(db.import_measurements(rows));
+    for (std::time_t t = base + 10 * 3600; t < base + 10 * 3600 + 100; ++t) {
+        rows.push_back({t, 1.5f});
+        assert(db.add_measurement(t, 1.5f));
+    }
+    
+    std::string expected = format_csv(rows);
+    std::string exported;
+    assert(db.export_measurements(0, 0, 4, format_csv, [&](const std::string& chunk) {
+        exported += chunk;
+        return true;
+    }));
+    assert(exported == expected);
+    
+    // Диапазон, режущий блоки
+    std::vector<TemperatureData> part(rows.begin() + 1000, rows.begin() + 20001);
+    exported.clear();
+    assert(db.export_measurements(part.front().timestamp, part.back().timestamp, 3, format_csv,
+                                  [&](const std::string& chunk) {
+                                      exported += chunk;
+                                      return true;
+                                  }));
+    assert(exported == format_csv(part));
+    
+    // Блок, удалённый во время выгрузки, не пропускается молча
+    bool deleted = false;
+    assert(!db.export_measurements(0, 0, 1, format_csv, [&](const std::string&) {
+        if (!deleted) {
+            deleted = exec_sql(path, "DELETE FROM measurement_blocks "
+                                     "WHERE id = (SELECT MAX(id) FROM measurement_blocks)");
+            assert(deleted);
+        }
+        return true;
+    }));
+    
+    db.cleanup();
+    remove_database(path);
+    
+    std::cout << "DatabaseManager::export_measurements tests passed!" << std::endl;
+}
+
+std::string query_text(const std::string& path, const char* sql) {
+    sqlite3* conn = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    std::string result;
+    if (sqlite3_open_v2(path.c_str(), &conn, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+        sqlite3_prepare_v2(conn, sql, -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+        result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(conn);
+    return result;
+}
+
+void test_database_backup() {
+    std::cout << "Testing DatabaseManager::backup..." << std::endl;
+    
+    const std::string path = "test_backup_source.db";
+    const std::string copy = "test_backup_copy.db";
+    remove_database(path);
+    remove_database(copy);
+    DatabaseManager& db = DatabaseManager::get_instance();
+    assert(db.initialize(path));
+    
+    // Шумные значения плохо сжимаются - база в несколько тысяч страниц
+    const std::time_t base = 1700000000;
+    std::vector<TemperatureData> rows;
+    uint32_t seed = 12345;
+    for (std::time_t t = base; t < base + 4000000; ++t) {
+        seed = seed * 1664525u + 1013904223u;
+        rows.push_back({t, static_cast<float>(seed >> 8) / 65536.0f});
+    }
+    assert(db.import_measurements(rows));
+    long long blocks = std::stoll(query_text(path, "SELECT COUNT(*) FROM measurement_blocks"));
+    rows.clear();
+    
+    // Запись идёт всё время копирования; ни один вызов не должен ждать всю копию
+    std::atomic<bool> done{false};
+    double max_latency = 0.0;
+    size_t ingested = 0;
+    std::thread ingest([&]() {
+        std::time_t t = base + 4000000;
+        while (!done) {
+            auto start = std::chrono::steady_clock::now();
+            assert(db.add_measurement(t++, 21.0f));
+            std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+            max_latency = std::max(max_latency, latency.count());
+            ++ingested;
+        }
+    });
+    
+    BackupOptions options;
+    options.latency_budget_ms = 2;
+    options.pause_ms = 5;
+    BackupStats stats;
+    assert(db.backup(copy, options, &stats));
+    done = true;
+    ingest.join();
+    
+    std::cout << "  " << stats.pages << " pages in " << stats.steps << " steps, " << stats.seconds
+              << " s; " << ingested << " rows written, max latency " << max_latency * 1000 << " ms" << std::endl;
+    assert(stats.steps > 1 && ingested > 0);
+    assert(max_latency < stats.seconds / 2);
+    assert(query_text(copy, "PRAGMA integrity_check") == "ok");
+    assert(std::stoll(query_text(copy, "SELECT COUNT(*) FROM measurement_blocks")) >= blocks);
+    
+    // Другой процесс пишет непрерывно: постраничная копия всё время
+    // перезапускается, и копирование переходит на один шаг вне блокировки
+    remove_database(copy);
+    done = false;
+    std::thread writer([&]() {
+        sqlite3* conn = nullptr;
+        assert(sqlite3_open(path.c_str(), &conn) == SQLITE_OK);
+        sqlite3_busy_timeout(conn, 1000);
+        for (int i = 0; !done; ++i) {
+            std::string sql = "INSERT OR REPLACE INTO daily_averages (day_start, average_temp, count) VALUES (" +
+                              std::to_string(i % 100) + ", 20.0, 1)";
+            sqlite3_exec(conn, sql.c_str(), nullptr, nullptr, nullptr);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        sqlite3_close(conn);
+    });
+    options.latency_budget_ms = 1;
+    options.pause_ms = 10;
+    assert(db.backup(copy, options, &stats));
+    done = true;
+    writer.join();
+    assert(query_text(copy, "PRAGMA integrity_check") == "ok");
+    assert(std::stoll(query_text(copy, "SELECT COUNT(*) FROM measurement_blocks")) >= blocks);
+    
+    db.cleanup();
+    remove_database(path);
+    remove_database(copy);
+    
+    std::cout << "DatabaseManager::backup tests passed!" << std::endl;
+}
+
+size_t count_lines(const std::vector<std::string>& paths) {
+    size_t lines = 0;
+    for (const auto& path : paths) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) ++lines;
+    }
+    return lines;
+}
+
+void test_segmented_log() {
+    std::cout << "Testing SegmentedLog..." << std::endl;
+    
+    const std::string dir = "test_segments";
+    std::filesystem::remove_all(dir);
+    
+    // 2024-02-29 13:30:00 UTC
+    const std::time_t t = 1709213400;
+    
+    SegmentedLog hourly(dir, "m", SegmentSpan::HOUR, 7200);
+    assert(hourly.open());
+    assert(hourly.segment_start(t) == 1709211600);
+    assert(hourly.segment_end(1709211600) == 1709215200);
+    
+    SegmentedLog monthly(dir, "h", SegmentSpan::MONTH, 86400);
+    assert(monthly.segment_start(t) == 1706745600);      // 2024-02-01
+    assert(monthly.segment_end(1706745600) == 1709251200); // 2024-03-01
+    
+    SegmentedLog yearly(dir, "d", SegmentSpan::YEAR, 86400);
+    assert(yearly.segment_start(t) == 1704067200);       // 2024-01-01
+    assert(yearly.segment_end(1704067200) == 1735689600);  // 2025-01-01
+    
+    for (int i = 0; i < 5; ++i) {
+        std::ostream* out = hourly.stream_for(t + i * 3600);
+        assert(out != nullptr);
+        *out << "line " << i << '\n';
+    }
+    hourly.flush();
+    assert(hourly.segment_paths().size() == 5);
+    
+    // Манифест переживает переоткрытие
+    SegmentedLog reopened(dir, "m", SegmentSpan::HOUR, 7200);
+    assert(reopened.open() && reopened.segment_paths().size() == 5);
+    assert(count_lines(reopened.segment_paths()) == 5);
+    
+    // Срок хранения 2 часа: остаются сегменты, заканчивающиеся позже now - 7200
+    const std::time_t now = t + 4 * 3600;
+    assert(reopened.remove_expired(now) == 2);
+    assert(reopened.segment_paths().size() == 3);
+    assert(!std::filesystem::exists(dir + "/m-2024-02-29T13.log"));
+    assert(std::filesystem::exists(dir + "/m-2024-02-29T15.log"));
+    
+    std::filesystem::remove_all(dir);
+    
+    std::cout << "SegmentedLog tests passed!" << std::endl;
+}
+
+void test_binary_log() {
+    std::cout << "Testing binary log..." << std::endl;
+    
+    const std::string path = "test_binary.bin";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        for (int i = 0; i < 1000; ++i) {
+            write_binary_record(out, 1700000000 + i, 20.0f + i * 0.25f);
+        }
+        // Недописанная запись в конце
+        out.write("torn", 4);
+    }
+    
+    std::vector<TemperatureRecord> records;
+    size_t corrupted = 0;
+    assert(load_binary_log(path, records, &corrupted));
+    assert(records.size() == 1000 && corrupted == 1);
+    assert(records[999].timestamp == 1700000999 && records[999].temperature == 20.0f + 999 * 0.25f);
+    
+    // Испорченная запись отбрасывается по контрольной сумме
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(BINARY_LOG_RECORD_SIZE * 10 + 8);
+        file.put('\x7f');
+    }
+    records.clear();
+    assert(load_binary_log(path, records, &corrupted));
+    assert(records.size() == 999 && corrupted == 2);
+    
+    std::filesystem::remove(path);
+    
+    std::cout << "Binary log tests passed!" << std::endl;
+}
+
+std::vector<std::string> log_segments(const std::string& prefix) {
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("logs")) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) == 0 && entry.path().extension() == ".log") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    return paths;
+}
+
+std::vector<std::string> measurement_segments() {
+    return log_segments("measurements-");
+}
+
+void test_logger_windows() {
+    std::cout << "Testing Logger hourly windows..." << std::endl;
+    
+    Logger& logger = Logger::get_instance();
+    
+    // Начало местного часа три часа назад
+    std::time_t base = std::time(nullptr) - 3 * 3600;
+    std::tm tm = *std::localtime(&base);
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    std::time_t hour = std::mktime(&tm);
+    
+    // Среднее за час пишется, когда приходит измерение следующего часа
+    for (int i = 0; i < 60; ++i) {
+        logger.log_measurement(hour + i * 60, i % 2 == 0 ? 10.0f : 12.0f);
+    }
+    for (int i = 0; i < 60; ++i) {
+        logger.log_measurement(hour + 3600 + i * 60, 30.0f);
+    }
+    logger.log_measurement(hour + 7200, 0.0f);
+    logger.flush();
+    
+    std::vector<float> averages;
+    for (const auto& path : log_segments("hourly-")) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t pos = line.find("HOURLY_AVG ");
+            if (pos != std::string::npos) {
+                averages.push_back(std::stof(line.substr(pos + 11)));
+            }
+        }
+    }
+    
+    assert(averages.size() >= 2);
+    assert(averages[averages.size() - 2] == 11.0f);
+    assert(averages[averages.size() - 1] == 30.0f);
+    
+    std::cout << "Logger window tests passed!" << std::endl;
+}
+
+void test_logger_async() {
+    std::cout << "Testing asynchronous Logger..." << std::endl;
+    
+    Logger& logger = Logger::get_instance();
+    logger.flush();
+    size_t before = count_lines(measurement_segments());
+    
+    // Несколько производителей одновременно; flush() дожидается записи всех
+    const int THREADS = 4;
+    const int PER_THREAD = 20000;
+    std::time_t now = std::time(nullptr);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < THREADS; ++t) {
+        producers.emplace_back([&logger, now, t]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                logger.log_measurement(now, 20.0f + t);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    logger.flush();
+    
+    assert(count_lines(measurement_segments()) == before + THREADS * PER_THREAD);
+    
+    std::cout << "Logger tests passed!" << std::endl;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void test_logger_append_only() {
+    std::cout << "Testing append-only Logger segments..." << std::endl;
+    
+    Logger& logger = Logger::get_instance();
+    std::time_t now = std::time(nullptr);
+    logger.log_measurement(now, 21.0f);
+    logger.flush();
+    
+    std::map<std::string, std::string> before;
+    for (const auto& path : log_segments("")) {
+        before[path] = read_file(path);
+    }
+    size_t lines = count_lines(measurement_segments());
+    
+    // Новые записи и очистка устаревших только дописывают сегменты в конец
+    for (int i = 1; i <= 100; ++i) {
+        logger.log_measurement(now + i, 22.0f);
+    }
+    logger.cleanup_old_data();
+    for (int i = 101; i <= 200; ++i) {
+        logger.log_measurement(now + i, 23.0f);
+    }
+    logger.flush();
+    
+    for (const auto& segment : before) {
+        std::string after = read_file(segment.first);
+        assert(after.size() >= segment.second.size());
+        assert(after.compare(0, segment.second.size(), segment.second) == 0);
+    }
+    assert(count_lines(measurement_segments()) == lines + 200);
+    
+    std::cout << "Append-only Logger tests passed!" << std::endl;
+}
+
+void test_line_splitter() {
+    std::cout << "Testing LineSplitter..." << std::endl;
+    
+    std::vector<std::string> lines;
+    auto collect = [&](std::string_view line) { lines.emplace_back(line); };
+    
+    // Строки, разорванные между чтениями, и пустые строки
+    LineSplitter splitter(16);
+    auto feed = [&](const std::string& data) { splitter.feed(data.data(), data.size(), collect); };
+    feed("TEMP:1\nTE");
+    feed("MP:2\n\n\nTEMP:3");
+    assert((lines == std::vector<std::string>{"TEMP:1", "TEMP:2"}));
+    feed("\r\n");
+    assert(lines.size() == 3 && lines[2] == "TEMP:3\r");
+    
+    // Чтение прямо в буфер
+    std::memcpy(splitter.write_area(), "a\nb\n", 4);
+    splitter.commit(4, collect);
+    assert(lines.size() == 5 && lines[3] == "a" && lines[4] == "b");
+    
+    // Строка длиннее буфера отбрасывается целиком, следующая проходит
+    lines.clear();
+    feed(std::string(40, 'x'));
+    feed("yy\nTEMP:4\n");
+    assert((lines == std::vector<std::string>{"TEMP:4"}));
+    assert(splitter.dropped_lines() == 1 && splitter.write_space() == 16);
+    
+    // Буфер побайтно
+    lines.clear();
+    for (char c : std::string("first\nsecond\n")) {
+        feed(std::string(1, c));
+    }
+    assert((lines == std::vector<std::string>{"first", "second"}));
+    
+    std::cout << "LineSplitter tests passed!" << std::endl;
+}
+
+void test_device_line_parser() {
+    std::cout << "Testing DeviceLineParser..." << std::endl;
+    
+    // Время устройства - местное, как у mktime
+    auto local_ms = [](int year, int month, int day, int hour, int minute, int second, int ms) {
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        return static_cast<int64_t>(std::mktime(&tm)) * 1000 + ms;
+    };
+    
+    DeviceLineParser parser;
+    DeviceReading reading;
+    assert(parser.parse("TEMP:25.5 TIME:2024-01-15 14:30:45.123", reading));
+    assert(reading.temperature == 25.5f && reading.has_time);
+    assert(reading.timestamp_ms == local_ms(2024, 1, 15, 14, 30, 45, 123));
+    
+    assert(parser.parse("TEMP:-12.250000 TIME:2024-02-29 23:59:59\r", reading));
+    assert(reading.temperature == -12.25f && reading.timestamp_ms == local_ms(2024, 2, 29, 23, 59, 59, 0));
+    assert(parser.parse("TEMP:21", reading) && reading.temperature == 21.0f && !reading.has_time);
+    
+    const char* invalid[] = {
+        "TEMP:abc TIME:2024-01-15 14:30:45.123",
+        "TEMP:25.5TIME:2024-01-15 14:30:45.123",
+        "TEMP:25.5 TIME:2023-02-29 10:00:00",
+        "TEMP:25.5 TIME:2024-13-01 10:00:00",
+        "TEMP:25.5 TIME:2024-01-15 24:00:00",
+        "TEMP:25.5 TIME:2024-01-15 14:30:45.12",
+        "TEMP:25.5 TIME:2024-01-15 14:30:45 extra",
+        "TEMP:2000 TIME:2024-01-15 14:30:45",
+        "TEMP:nan",
+        "TEMP:1e3",
+        "HUMIDITY:40",
+    };
+    for (const char* line : invalid) {
+        assert(!parser.parse(line, reading));
+    }
+    
+    std::cout << "DeviceLineParser tests passed!" << std::endl;
+}
+
+void test_device_frames() {
+    std::cout << "Testing binary device frames..." << std::endl;
+    
+    // Контрольное значение CRC-16/CCITT-FALSE
+    const unsigned char check[] = "123456789";
+    assert(crc16_ccitt(check, 9) == 0x29B1);
+    
+    DeviceSample samples[3] = {{1705329045123, 21.5f}, {1705329045223, -12.34f}, {1705329110758, 327.67f}};
+    std::vector<unsigned char> frame;
+    assert(encode_device_frame(2, samples, 3, frame));
+    assert(frame.size() == FRAME_HEADER_SIZE + 3 * FRAME_SAMPLE_SIZE + FRAME_CRC_SIZE);
+    
+    DeviceFrame decoded;
+    size_t consumed = 0;
+    assert(decode_device_frame(frame.data(), frame.size() - 1, decoded, consumed) == FrameStatus::Incomplete);
+    assert(decode_device_frame(frame.data(), frame.size(), decoded, consumed) == FrameStatus::Ok);
+    assert(consumed == frame.size() && decoded.channel == 2 && decoded.count == 3);
+    for (size_t i = 0; i < 3; ++i) {
+        assert(decoded.samples[i].timestamp_ms == samples[i].timestamp_ms);
+        assert(decoded.samples[i].temperature == samples[i].temperature);
+    }
+    
+    // Разрыв больше 65.535 с и убывающее время не кодируются
+    std::vector<unsigned char> rejected;
+    DeviceSample gap[2] = {{1000, 20.0f}, {1000 + 65536, 20.0f}};
+    assert(!encode_device_frame(0, gap, 2, rejected));
+    DeviceSample backwards[2] = {{2000, 20.0f}, {1999, 20.0f}};
+    assert(!encode_device_frame(0, backwards, 2, rejected) && rejected.empty());
+    
+    // Текст и кадры вперемешку, побайтно: протокол определяется сам
+    std::string stream = "TEMP:20.5\n";
+    stream.append(frame.begin(), frame.end());
+    stream += "TEMP:21.5\n";
+    
+    std::vector<std::string> lines;
+    std::vector<DeviceFrame> frames;
+    auto on_line = [&](std::string_view line) { lines.emplace_back(line); };
+    auto on_frame = [&](std::string_view raw) {
+        DeviceFrame f;
+        size_t length = 0;
+        assert(decode_device_frame(reinterpret_cast<const unsigned char*>(raw.data()), raw.size(), f, length) ==
+               FrameStatus::Ok && length == raw.size());
+        frames.push_back(f);
+    };
+    
+    DeviceStreamSplitter splitter(64);
+    for (char c : stream) {
+        splitter.feed(&c, 1, on_line, on_frame);
+    }
+    assert((lines == std::vector<std::string>{"TEMP:20.5", "TEMP:21.5"}));
+    assert(frames.size() == 1 && frames[0].count == 3 && frames[0].samples[1].temperature == -12.34f);
+    
+    // Испорченный кадр пропускается до конца строки или до следующего кадра
+    lines.clear();
+    frames.clear();
+    std::string corrupted(frame.begin(), frame.end());
+    corrupted[FRAME_HEADER_SIZE + 1] ^= 0x40;
+    std::string damaged = corrupted + "TEMP:22.5\nTEMP:22.6\n" + corrupted + std::string(frame.begin(), frame.end());
+    splitter.feed(damaged.data(), damaged.size(), on_line, on_frame);
+    assert((lines == std::vector<std::string>{"TEMP:22.6"}));
+    assert(frames.size() == 1 && splitter.corrupt_frames() == 2);
+    
+    // Байт синхронизации посреди строки обрывает её
+    lines.clear();
+    frames.clear();
+    std::string torn = "TEMP:2";
+    torn.append(frame.begin(), frame.end());
+    torn += "TEMP:23.5\n";
+    splitter.feed(torn.data(), torn.size(), on_line, on_frame);
+    assert((lines == std::vector<std::string>{"TEMP:23.5"}));
+    assert(frames.size() == 1 && splitter.frames() == 3);
+    
+    std::cout << "Device frame tests passed!" << std::endl;
+}
+
+void test_spsc_ring() {
+    std::cout << "Testing SpscRing..." << std::endl;
+    
+    SpscRing<int> ring(5);
+    assert(ring.capacity() == 8 && ring.empty());
+    for (int i = 0; i < 8; ++i) {
+        assert(ring.try_push(i));
+    }
+    assert(!ring.try_push(8) && ring.try_claim() == nullptr && ring.size() == 8);
+    int value = -1;
+    assert(ring.try_pop(value) && value == 0);
+    
+    // Слот заполняется на месте и не виден потребителю до publish()
+    int* slot = ring.try_claim();
+    assert(slot != nullptr);
+    *slot = 8;
+    assert(ring.size() == 7);
+    ring.publish();
+    for (int i = 1; i <= 8; ++i) {
+        const int* front = ring.front();
+        assert(front != nullptr && *front == i);
+        ring.pop();
+    }
+    assert(ring.front() == nullptr && !ring.try_pop(value));
+    
+    // Два потока: порядок сохраняется, ничего не теряется
+    const int COUNT = 200000;
+    SpscRing<int> shared(64);
+    std::thread producer([&]() {
+        for (int i = 0; i < COUNT; ++i) {
+            while (!shared.try_push(i)) std::this_thread::yield();
+        }
+    });
+    for (int expected = 0; expected < COUNT; ++expected) {
+        while (!shared.try_pop(value)) std::this_thread::yield();
+        assert(value == expected);
+    }
+    producer.join();
+    assert(shared.empty());
+    
+    std::cout << "SpscRing tests passed!" << std::endl;
+}
+
+void test_ingest_pipeline() {
+    std::cout << "Testing IngestPipeline..." << std::endl;
+    
+    auto wait_until = [](auto condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    };
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool gate_open = true;
+    int failures = 0; // столько вызовов подряд приёмник ничего не сохраняет
+    std::vector<std::pair<std::string, float>> stored;
+    std::vector<std::time_t> stored_times;
+    auto sink = [&](const std::vector<IngestSample>& batch) -> size_t {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return gate_open; });
+        if (failures > 0) {
+            --failures;
+            return 0;
+        }
+        // Пачка упорядочена по времени; между пачками порядка нет
+        assert(std::is_sorted(batch.begin(), batch.end(), [](const IngestSample& a, const IngestSample& b) {
+            return a.timestamp < b.timestamp;
+        }));
+        for (const auto& sample : batch) {
+            stored.emplace_back(*sample.sensor_id, sample.temperature);
+            stored_times.push_back(sample.timestamp);
+        }
+        return batch.size();
+    };
+    const std::string sensor_a = "sensor-a";
+    const std::string sensor_b = "sensor-b";
+    const std::string sensor_c = "sensor-c";
+    
+    {
+        // Порядок, служебные строки, ошибки разбора и кадры нескольких каналов;
+        // Block - чтобы поток чтения не обгонял разбор и ничего не терялось
+        IngestOptions options;
+        options.raw_overflow = OverflowPolicy::Block;
+        IngestPipeline pipeline(options);
+        pipeline.set_sink(sink);
+        assert(!pipeline.push_line(sensor_a, "TEMP:1.0"));
+        assert(pipeline.start());
+        
+        std::thread reader([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                pipeline.push_line(sensor_b, "TEMP:" + std::to_string(i / 10.0));
+            }
+        });
+        for (int i = 0; i < 1000; ++i) {
+            pipeline.push_line(sensor_a, "TEMP:" + std::to_string(i / 10.0));
+        }
+        reader.join();
+        assert(pipeline.push_line(sensor_a, "READY"));
+        assert(pipeline.push_line(sensor_a, "TEMP:abc"));
+        
+        // Часы устройства отстают на год: кадр сдвигается ко времени приёма
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        DeviceSample samples[2] = {{now - 365LL * 86400000, 30.5f}, {now - 365LL * 86400000 + 250, 31.5f}};
+        std::vector<unsigned char> frame;
+        assert(encode_device_frame(3, samples, 2, frame));
+        assert(pipeline.push_frame(sensor_a, std::string_view(reinterpret_cast<const char*>(frame.data()),
+                                                              frame.size())));
+        // Миллисекунды строки, как и у кадров, отбрасываются только при записи
+        std::time_t now_seconds = static_cast<std::time_t>(now / 1000);
+        char device_time[32];
+        std::strftime(device_time, sizeof(device_time), "%Y-%m-%d %H:%M:%S", std::localtime(&now_seconds));
+        assert(pipeline.push_line(sensor_c, std::string("TEMP:12.5 TIME:") + device_time + ".999"));
+        assert(!pipeline.push_line(sensor_a, std::string(IngestPipeline::MAX_RAW_MESSAGE + 1, 'x')));
+        pipeline.stop();
+        
+        IngestStats stats = pipeline.stats();
+        assert(stats.raw.accepted == 2004 && stats.raw.processed == 2004 && stats.raw.dropped == 1);
+        assert(stats.samples.accepted == 2003 && stats.samples.processed == 2003 && stats.samples.dropped == 0);
+        assert(stats.raw.queued == 0 && stats.samples.queued == 0);
+        assert(stats.parse_errors == 1 && stats.clock_corrections == 2 && stats.batches > 0);
+        
+        assert(stored.size() == 2003);
+        float last_a = -1.0f;
+        float last_b = -1.0f;
+        for (const auto& [sensor_id, temperature] : stored) {
+            float& last = sensor_id == sensor_a ? last_a : last_b;
+            if (sensor_id == "sensor-a/3" || sensor_id == sensor_c) continue;
+            assert(temperature > last);
+            last = temperature;
+        }
+        std::vector<size_t> channel;
+        for (size_t i = 0; i < stored.size(); ++i) {
+            if (stored[i].first == "sensor-a/3") channel.push_back(i);
+        }
+        assert(channel.size() == 2 && stored[channel[0]].second == 30.5f && stored[channel[1]].second == 31.5f);
+        assert(stored_times[channel[1]] - stored_times[channel[0]] <= 1);
+        assert(std::llabs(static_cast<long long>(stored_times[channel[1]] - now / 1000)) < 60);
+        auto line = std::find_if(stored.begin(), stored.end(), [&](const auto& s) { return s.first == sensor_c; });
+        assert(line != stored.end() && stored_times[line - stored.begin()] == now_seconds);
+    }
+    
+    {
+        // Приёмник сначала отказывает: пачка повторяется, пока не сохранится
+        stored.clear();
+        failures = 2;
+        IngestPipeline pipeline;
+        pipeline.set_sink(sink);
+        assert(pipeline.start());
+        for (int i = 0; i < 10; ++i) {
+            assert(pipeline.push_line(sensor_a, "TEMP:" + std::to_string(i)));
+        }
+        assert(wait_until([&]() { return pipeline.stats().write_retries >= 2; }));
+        pipeline.stop();
+        assert(stored.size() == 10 && stored.front().second == 0.0f && stored.back().second == 9.0f);
+    }
+    
+    {
+        // Запись стоит, показания копятся в запасе до предела, излишек отбрасывается
+        stored.clear();
+        gate_open = false;
+        IngestOptions options;
+        options.sample_capacity = 2;
+        options.spill_limit = 5;
+        IngestPipeline pipeline(options);
+        pipeline.set_sink(sink);
+        assert(pipeline.start());
+        for (int i = 0; i < 30; ++i) {
+            assert(pipeline.push_line(sensor_a, "TEMP:" + std::to_string(i)));
+        }
+        assert(wait_until([&]() { return pipeline.stats().raw.processed == 30; }));
+        IngestStats stats = pipeline.stats();
+        assert(stats.samples.dropped > 0 && stats.samples.accepted + stats.samples.dropped == 30);
+        assert(stats.samples.high_water <= 2);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            gate_open = true;
+            cv.notify_all();
+        }
+        pipeline.stop();
+        assert(stored.size() == pipeline.stats().samples.accepted);
+        for (size_t i = 1; i < stored.size(); ++i) {
+            assert(stored[i].second > stored[i - 1].second);
+        }
+    }
+    
+    {
+        // Разбор стоит (Block на второй границе): поток чтения не ждёт, а теряет
+        stored.clear();
+        gate_open = false;
+        IngestOptions options;
+        options.raw_capacity = 4;
+        options.sample_capacity = 2;
+        options.sample_overflow = OverflowPolicy::Block;
+        IngestPipeline pipeline(options);
+        pipeline.set_sink(sink);
+        assert(pipeline.start());
+        size_t accepted = 0;
+        for (int i = 0; i < 50; ++i) {
+            if (pipeline.push_line(sensor_a, "TEMP:" + std::to_string(i))) ++accepted;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        IngestStats stats = pipeline.stats();
+        assert(stats.raw.dropped > 0 && stats.raw.accepted == accepted && accepted + stats.raw.dropped == 50);
+        assert(stats.raw.high_water <= 4);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            gate_open = true;
+            cv.notify_all();
+        }
+        pipeline.stop();
+        assert(stored.size() == accepted && pipeline.stats().samples.dropped == 0);
+    }
+    
+    std::cout << "IngestPipeline tests passed!" << std::endl;
+}
+
+#ifndef _WIN32
+void test_port_reader() {
+    std::cout << "Testing event-driven PortReader..." << std::endl;
+    
+    // Псевдотерминал вместо COM-порта: пишем в master, читаем slave
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    assert(master != -1 && grantpt(master) == 0 && unlockpt(master) == 0);
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> lines;
+    
+    PortReader reader(ptsname(master));
+    reader.set_callback([&](std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.emplace_back(line);
+        cv.notify_all();
+    });
+    std::vector<std::string> frames;
+    reader.set_frame_callback([&](std::string_view frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.emplace_back(frame);
+        cv.notify_all();
+    });
+    assert(reader.start());
+    
+    // Строка, разорванная на две записи, приходит целиком и сразу после конца
+    const char first_half[] = "TEMP:21.5 TIME:2024-01";
+    const char second_half[] = "-15 14:30:45.123\n";
+    assert(write(master, first_half, sizeof(first_half) - 1) > 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto sent = std::chrono::steady_clock::now();
+    assert(write(master, second_half, sizeof(second_half) - 1) > 0);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(cv.wait_for(lock, std::chrono::seconds(2), [&]() { return !lines.empty(); }));
+        assert(lines.size() == 1 && lines[0] == "TEMP:21.5 TIME:2024-01-15 14:30:45.123");
+    }
+    auto latency = std::chrono::steady_clock::now() - sent;
+    std::cout << "  line latency: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(latency).count() << " us" << std::endl;
+    
+    // Двоичный кадр в том же порту
+    DeviceSample samples[2] = {{1705329045123, 21.5f}, {1705329045173, 21.75f}};
+    std::vector<unsigned char> frame;
+    assert(encode_device_frame(0, samples, 2, frame));
+    assert(write(master, frame.data(), frame.size()) == static_cast<ssize_t>(frame.size()));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(cv.wait_for(lock, std::chrono::seconds(2), [&]() { return !frames.empty(); }));
+        assert(frames.size() == 1 && frames[0] == std::string(frame.begin(), frame.end()));
+    }
+    
+    // Остановка будит поток, ждущий данных, без таймаутов
+    auto stop_start = std::chrono::steady_clock::now();
+    reader.stop();
+    assert(std::chrono::steady_clock::now() - stop_start < std::chrono::milliseconds(100));
+    
+    close(master);
+    std::cout << "PortReader tests passed!" << std::endl;
+}
+void test_device_manager() {
+    std::cout << "Testing DeviceManager..." << std::endl;
+    
+    DeviceConfig config;
+    assert(DeviceManager::parse_device_line("/dev/ttyUSB0 115200 7E2 rack1-top", config));
+    assert(config.path == "/dev/ttyUSB0" && config.settings.baud_rate == 115200 && config.sensor_id == "rack1-top");
+    assert(config.settings.data_bits == 7 && config.settings.parity == 'E' && config.settings.stop_bits == 2);
+    assert(DeviceManager::parse_device_line("/dev/ttyS1", config));
+    assert(config.settings.baud_rate == 9600 && config.settings.parity == 'N' && config.sensor_id == "/dev/ttyS1");
+    assert(!DeviceManager::parse_device_line("/dev/ttyS1 fast", config));
+    assert(!DeviceManager::parse_device_line("/dev/ttyS1 9600 9X1", config));
+    
+    // Каналы FIFO вместо портов: второго устройства при запуске ещё нет
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "device_manager_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string path_a = (dir / "a").string();
+    std::string path_b = (dir / "b").string();
+    assert(mkfifo(path_a.c_str(), 0600) == 0);
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> received;
+    
+    DeviceManager manager(1);
+    manager.add_device({path_a, SerialSettings(), "sensor-a"});
+    manager.add_device({path_b, SerialSettings(), "sensor-b"});
+    manager.set_callback([&](const std::string& sensor_id, std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(sensor_id + "|" + std::string(line));
+        cv.notify_all();
+    });
+    assert(manager.start());
+    
+    // Писатель открывается, только когда менеджер уже открыл канал на чтение
+    auto open_writer = [](const std::string& path) {
+        for (int attempt = 0; attempt < 300; ++attempt) {
+            int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+            if (fd != -1) return fd;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return -1;
+    };
+    auto send_and_wait = [&](int fd, const std::string& line, const std::string& expected) {
+        std::string data = line + "\n";
+        assert(write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(cv.wait_for(lock, std::chrono::seconds(2), [&]() {
+            return std::find(received.begin(), received.end(), expected) != received.end();
+        }));
+    };
+    
+    int writer_a = open_writer(path_a);
+    assert(writer_a != -1);
+    send_and_wait(writer_a, "TEMP:1.5", "sensor-a|TEMP:1.5");
+    
+    // Устройство появилось после запуска - подключается при повторной попытке
+    assert(mkfifo(path_b.c_str(), 0600) == 0);
+    int writer_b = open_writer(path_b);
+    assert(writer_b != -1);
+    send_and_wait(writer_b, "TEMP:2.5", "sensor-b|TEMP:2.5");
+    assert(manager.connected_count() == 2);
+    
+    // Отключение и переподключение
+    close(writer_a);
+    writer_a = open_writer(path_a);
+    assert(writer_a != -1);
+    send_and_wait(writer_a, "TEMP:3.5", "sensor-a|TEMP:3.5");
+    
+    manager.stop();
+    assert(manager.connected_count() == 0);
+    close(writer_a);
+    close(writer_b);
+    std::filesystem::remove_all(dir);
+    std::cout << "DeviceManager tests passed!" << std::endl;
+}
+void test_network_listener() {
+    std::cout << "Testing NetworkListener..." << std::endl;
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> received;
+    
+    NetworkListener listener(0, 0, "127.0.0.1");
+    listener.set_callback([&](const std::string& sensor_id, std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(sensor_id + "|" + std::string(line));
+        cv.notify_all();
+    });
+    assert(listener.start());
+    assert(listener.udp_port() > 0 && listener.tcp_port() > 0);
+    
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    auto wait_for_count = [&](size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(2), [&]() { return received.size() >= count; });
+    };
+    
+    // Несколько строк в датаграмме; без идентификатора и с пустым - отбрасываются
+    int udp = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(udp != -1);
+    addr.sin_port = htons(static_cast<uint16_t>(listener.udp_port()));
+    std::string datagram = "rack1 TEMP:21.5 TIME:2024-01-15 14:30:45.123\nTEMP:3.5 TIME:2024-01-15 14:30:45\n"
+                           " TEMP:1.0\nrack2 TEMP:22.5";
+    assert(sendto(udp, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) ==
+           static_cast<ssize_t>(datagram.size()));
+    assert(wait_for_count(2));
+    assert((received == std::vector<std::string>{"rack1|TEMP:21.5 TIME:2024-01-15 14:30:45.123", "rack2|TEMP:22.5"}));
+    assert(listener.rejected_count() == 2);
+    
+    // Пачка датаграмм читается целиком
+    received.clear();
+    for (int i = 0; i < 200; ++i) {
+        std::string line = "rack" + std::to_string(i % 3) + " TEMP:" + std::to_string(i);
+        assert(sendto(udp, line.data(), line.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) > 0);
+    }
+    assert(wait_for_count(200));
+    assert(listener.datagram_count() == 201 && listener.line_count() == 202);
+    close(udp);
+    
+    // TCP: строка, разорванная на две записи, приходит целиком
+    received.clear();
+    int tcp = socket(AF_INET, SOCK_STREAM, 0);
+    assert(tcp != -1);
+    addr.sin_port = htons(static_cast<uint16_t>(listener.tcp_port()));
+    assert(connect(tcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    const char first[] = "shelf-3 TEMP:4.5\nshelf-3 TEMP:";
+    const char second[] = "5.5\r\n";
+    assert(write(tcp, first, sizeof(first) - 1) > 0);
+    assert(wait_for_count(1));
+    assert(write(tcp, second, sizeof(second) - 1) > 0);
+    assert(wait_for_count(2));
+    assert((received == std::vector<std::string>{"shelf-3|TEMP:4.5", "shelf-3|TEMP:5.5\r"}));
+    assert(listener.connection_count() == 1);
+    
+    // Закрытое датчиком соединение освобождается
+    close(tcp);
+    for (int i = 0; i < 200 && listener.connection_count() != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(listener.connection_count() == 0);
+    
+    listener.stop();
+    assert(listener.udp_port() == -1 && listener.tcp_port() == -1);
+    std::cout << "NetworkListener tests passed!" << std::endl;
+}
+#endif
+
 int main() {
     test_temperature_calculator();
+    test_time_series_ring();
+    test_sliding_window();
+    test_calculator_concurrent_reads();
+    test_simd_kernels();
+    test_quantile_sketch();
+    test_parallel_aggregation();
+    test_calculator_policies();
+    test_gorilla_codec();
+    test_measurement_cache();
+    test_database_aggregate();
+    test_database_batch_rollback();
+    test_storage_tiers();
+    test_storage_compaction();
+    test_storage_late_rows();
+    test_storage_compaction_failure();
+    test_database_export();
+    test_database_backup();
+    test_segmented_log();
+    test_binary_log();
+    test_logger_windows();
+    test_logger_async();
+    test_logger_append_only();
+    test_line_splitter();
+    test_device_line_parser();
+    test_device_frames();
+    test_spsc_ring();
+    test_ingest_pipeline();
+#ifndef _WIN32
+    test_port_reader();
+    test_device_manager();
+    test_network_listener();
+#endif
     return 0;
 }